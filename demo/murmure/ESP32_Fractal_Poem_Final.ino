@@ -2,6 +2,7 @@
 #define LGFX_USE_V1
 #include <LovyanGFX.hpp>
 #include <esp_heap_caps.h>
+#include "../../fast_math_toolkit/FMT_Tiles.h"
 
 // include generated tables & glyphs
 #include "arduino_tables.h"
@@ -58,106 +59,53 @@ public:
 LGFX_ESP32 tft;
 
 // ------------------ Configuration ------------------
-#define TILE_SIZE 8         // minimum size is 8 (32bit align)
+// Each tile is redrawn from the display list, so larger tiles repeat less work. Against 8 px
+// tiles (host simulator) 16 px sends ~30% more pixels but a third of the pushes, ~0.2 ms more
+// SPI time per frame, and renders ~2.5x faster, which wins once rendering is the bottleneck.
+#define TILE_SIZE 16
 #define LOG_Q 8
 #define SIN_Q 15
 #define SIN_SIZE 512
 
 // ------------------ Tile-based Compositor ------------------
-
-struct Tile {
-  uint16_t x0, y0;
-  uint16_t w, h;
-  uint16_t *buf;
-  bool dirty_curr;   // Changed in current frame
-  bool dirty_prev;   // Changed in previous frame
-
-  Tile(): x0(0), y0(0), w(0), h(0), buf(nullptr), dirty_curr(false), dirty_prev(false) {}
-
-  void init(uint16_t _x0, uint16_t _y0, uint16_t _w, uint16_t _h) {
-    x0 = _x0; y0 = _y0; w = _w; h = _h;
-    size_t n = (size_t)w * (size_t)h;
-    if (buf) { free(buf); buf = nullptr; }
-    
-    buf = (uint16_t*) heap_caps_malloc(n * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_32BIT);
-    if (!buf) buf = (uint16_t*) malloc(n * sizeof(uint16_t));
-    
-    dirty_curr = false;
-    dirty_prev = false;
-    if (buf) memset(buf, 0, n * sizeof(uint16_t));
-  }
-
-  void prepareFrame(uint16_t bgcolor) {
-    if (dirty_prev || dirty_curr) {
-      size_t n = (size_t)w * (size_t)h;
-      if (bgcolor == 0) memset(buf, 0, n * sizeof(uint16_t));
-      else {
-        for (size_t i=0; i<n; ++i) buf[i] = bgcolor;
-      }
-    }
-    dirty_prev = dirty_curr;
-    dirty_curr = false;
-  }
-
-  inline void writePixelLocal(int16_t lx, int16_t ly, uint16_t color) {
-    if (!buf || lx < 0 || ly < 0 || lx >= (int)w || ly >= (int)h) return;
-    buf[ly * w + lx] = color;
-    dirty_curr = true;
-  }
+// The frame is recorded as a display list and binned per tile, then each tile is drawn into
+// one of TILE_POOL spare buffers while the previous tile is still going out over DMA.
+// TILE_WORKERS 2 renders on both cores instead, but needs a buffer per tile in DMA-capable
+// RAM and only starts the flush once every tile is done; keep 1 until that is measured
+// faster on the panel.
+
+#define TILE_WORKERS 1
+#define TILE_POOL 2
+#define MAX_DRAW_CMDS 512
+#define MAX_BIN_ITEMS 4096
+
+typedef FMT::TileCompositor<uint16_t> TileManager;
+typedef FMT::TileCanvas<uint16_t> TileCanvas;
+
+enum { CMD_GLYPH, CMD_SEGMENT };
+
+struct DrawCmd {
+  uint8_t kind;
+  uint8_t glyph;          // index into GLYPH_BITMAPS
+  uint16_t color;
+  int16_t x1, y1, x2, y2; // glyph centre in x1, y1; segment end points
+  uint16_t scale_q8;
+  int16_t cos_q15, sin_q15;
 };
 
-struct TileManager {
-  uint16_t screen_w, screen_h;
-  uint16_t tile_size;
-  uint16_t cols, rows;
-  Tile *tiles;
-
-  TileManager(): tiles(nullptr) {}
-
-  void init(uint16_t sw, uint16_t sh, uint16_t tsize=TILE_SIZE) {
-    screen_w = sw; screen_h = sh; tile_size = tsize;
-    cols = (screen_w + tile_size - 1) / tile_size;
-    rows = (screen_h + tile_size - 1) / tile_size;
-    size_t count = (size_t)cols * rows;
-    tiles = (Tile*)malloc(sizeof(Tile) * count);
-
-    for (uint16_t r=0; r<rows; ++r) {
-      for (uint16_t c=0; c<cols; ++c) {
-        uint16_t x0 = c * tile_size;
-        uint16_t y0 = r * tile_size;
-        uint16_t w = min((int)tile_size, (int)(screen_w - x0));
-        uint16_t h = min((int)tile_size, (int)(screen_h - y0));
-        Tile &t = tiles[r*cols + c];
-        new (&t) Tile();
-        t.init(x0, y0, w, h);
-      }
-    }
-  }
-
-  inline void writePixelGlobal(int16_t x, int16_t y, uint16_t color) {
-    if (x < 0 || y < 0 || x >= (int)screen_w || y >= (int)screen_h) return;
-    uint16_t tx = x / tile_size;
-    uint16_t ty = y / tile_size;
-    tiles[ty * cols + tx].writePixelLocal(x - (tx * tile_size), y - (ty * tile_size), color);
-  }
-
-  void startFrame(uint16_t bgcolor = 0x0000) {
-    uint32_t count = (uint32_t)cols * rows;
-    for (uint32_t i=0; i<count; ++i) tiles[i].prepareFrame(bgcolor);
-  }
-
-  void flush(LGFX_ESP32 &tft_ref) {
-    uint32_t count = (uint32_t)cols * rows;
-    for (uint32_t i=0; i < count; ++i) {
-      Tile &t = tiles[i];
-      if (t.dirty_curr || t.dirty_prev) {
-        tft_ref.pushImage(t.x0, t.y0, t.w, t.h, t.buf);
-      }
-    }
-  }
+struct DisplayList {
+  DrawCmd cmds[MAX_DRAW_CMDS];
+  FMT::TileRect bounds[MAX_DRAW_CMDS];
+  uint16_t count;
+  uint16_t *bin_start;    // cols * rows + 1 entries
+  uint16_t bin_items[MAX_BIN_ITEMS];
+  bool binned;            // false if the bins overflowed: every tile walks the whole list
 };
 
 TileManager gTiles;
+DisplayList gList;
+FMT::TileDmaPush<LGFX_ESP32> gSink;
+FMT::TileWorkers gWorkers;
 
 // ------------------ Fast Math ------------------
 
@@ -199,54 +147,106 @@ static inline uint32_t fast_log_mul_u16(uint16_t a, uint16_t b) {
 
 // -------------------- Rendering Pipeline --------------------
 
-void draw_glyph_into_tiles(TileManager &tiles, char ch, int16_t cx, int16_t cy, 
-                           float scale_f, float angle_rad, uint16_t color) {
-    int idx = -1;
-    for (uint16_t i = 0; i < GLYPH_COUNT; ++i) {
-        if (GLYPH_CHAR_LIST[i] == ch) { idx = i; break; }
-    }
-    if (idx < 0) return;
+// Glyph-space offset (pixels) scaled by scale_q8 in the log domain, Q8 result
+static inline int32_t scale_offset_q8(int16_t s, uint16_t scale_q8) {
+    int32_t s_q8 = ((int32_t)s) << LOG_Q;
+    uint32_t as = abs(s_q8);
+    uint32_t scaled_q8 = fast_log_mul_u16((uint16_t)min(as, 65535UL), scale_q8) >> LOG_Q;
+    return (s_q8 < 0) ? -(int32_t)scaled_q8 : (int32_t)scaled_q8;
+}
 
+void draw_glyph(TileCanvas &cv, const DrawCmd &c) {
     const uint8_t gw = GLYPH_WIDTH;
     const uint8_t gh = GLYPH_HEIGHT;
-    uint16_t scale_q8 = (uint16_t)(scale_f * (1 << LOG_Q));
 
-    float sA = sinf(angle_rad);
-    float cA = cosf(angle_rad);
-    int16_t cos_q15 = (int16_t)(cA * 32767);
-    int16_t sin_q15 = (int16_t)(sA * 32767);
+    // The glyph is drawn once per tile it overlaps: scale each column and row offset once
+    int32_t col_q8[GLYPH_WIDTH], row_q8[GLYPH_HEIGHT];
+    for (uint8_t col = 0; col < gw; ++col) col_q8[col] = scale_offset_q8((int16_t)col - (gw / 2), c.scale_q8);
+    for (uint8_t row = 0; row < gh; ++row) row_q8[row] = scale_offset_q8((int16_t)row - (gh / 2), c.scale_q8);
 
     for (uint8_t col = 0; col < gw; ++col) {
-        uint32_t colbyte = GLYPH_BITMAPS[idx * gw + col];
+        uint32_t colbyte = GLYPH_BITMAPS[c.glyph * gw + col];
         if (!colbyte) continue;
+        int32_t sxs = col_q8[col];
         for (uint8_t row = 0; row < gh; ++row) {
             if (colbyte & (1 << row)) {
-                int16_t sx = (int16_t)col - (gw / 2);
-                int16_t sy = (int16_t)row - (gh / 2);
+                int32_t sys = row_q8[row];
 
-                int32_t sx_q8 = ((int32_t)sx) << LOG_Q;
-                int32_t sy_q8 = ((int32_t)sy) << LOG_Q;
-                
-                uint32_t asx = abs(sx_q8);
-                uint32_t asy = abs(sy_q8);
-                uint32_t sx_scaled_q8 = fast_log_mul_u16((uint16_t)min(asx, 65535UL), scale_q8) >> LOG_Q;
-                uint32_t sy_scaled_q8 = fast_log_mul_u16((uint16_t)min(asy, 65535UL), scale_q8) >> LOG_Q;
-                
-                int32_t sxs = (sx_q8 < 0) ? -(int32_t)sx_scaled_q8 : (int32_t)sx_scaled_q8;
-                int32_t sys = (sy_q8 < 0) ? -(int32_t)sy_scaled_q8 : (int32_t)sy_scaled_q8;
-
-                int32_t rx_q8 = ( (sxs * (int32_t)cos_q15) - (sys * (int32_t)sin_q15) ) >> 15;
-                int32_t ry_q8 = ( (sxs * (int32_t)sin_q15) + (sys * (int32_t)cos_q15) ) >> 15;
+                int32_t rx_q8 = ( (sxs * (int32_t)c.cos_q15) - (sys * (int32_t)c.sin_q15) ) >> 15;
+                int32_t ry_q8 = ( (sxs * (int32_t)c.sin_q15) + (sys * (int32_t)c.cos_q15) ) >> 15;
 
-                int16_t fx = cx + (int16_t)(rx_q8 >> LOG_Q);
-                int16_t fy = cy + (int16_t)(ry_q8 >> LOG_Q);
+                int16_t fx = c.x1 + (int16_t)(rx_q8 >> LOG_Q);
+                int16_t fy = c.y1 + (int16_t)(ry_q8 >> LOG_Q);
 
-                tiles.writePixelGlobal(fx, fy, color);
+                cv.writePixelGlobal(fx, fy, c.color);
             }
         }
     }
 }
 
+// Simple line drawing into tiles (just points for now for speed/simplicity)
+void draw_segment(TileCanvas &cv, const DrawCmd &c) {
+    float dx = c.x2 - c.x1;
+    float dy = c.y2 - c.y1;
+    float len = sqrt(dx*dx + dy*dy);
+    for (float t=0; t<=1.0f; t += 1.0f/len) {
+        cv.writePixelGlobal(c.x1 + dx*t, c.y1 + dy*t, c.color);
+    }
+}
+
+struct ListRenderer {
+  const DisplayList *list;
+
+  bool empty(uint32_t tile) {
+    return list->binned && list->bin_start[tile] == list->bin_start[tile + 1];
+  }
+
+  void render(uint32_t tile, TileCanvas &cv) {
+    uint16_t n = list->binned ? list->bin_start[tile + 1] - list->bin_start[tile] : list->count;
+    for (uint16_t k = 0; k < n; ++k) {
+      uint16_t i = list->binned ? list->bin_items[list->bin_start[tile] + k] : k;
+      const DrawCmd &c = list->cmds[i];
+      if (c.kind == CMD_GLYPH) draw_glyph(cv, c);
+      else draw_segment(cv, c);
+    }
+  }
+};
+
+static inline void add_cmd(DisplayList &list, const DrawCmd &c, int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+    if (list.count >= MAX_DRAW_CMDS) return;
+    if (x1 < 0 || y1 < 0 || x0 >= tft.width() || y0 >= tft.height()) return;
+    FMT::TileRect r = {x0, y0, x1, y1};
+    list.bounds[list.count] = r;
+    list.cmds[list.count++] = c;
+}
+
+void draw_glyph_into_tiles(DisplayList &list, char ch, int16_t cx, int16_t cy, 
+                           float scale_f, float angle_rad, uint16_t color) {
+    int idx = -1;
+    for (uint16_t i = 0; i < GLYPH_COUNT; ++i) {
+        if (GLYPH_CHAR_LIST[i] == ch) { idx = i; break; }
+    }
+    if (idx < 0) return;
+
+    DrawCmd c;
+    c.kind = CMD_GLYPH;
+    c.glyph = (uint8_t)idx;
+    c.color = color;
+    c.x1 = cx; c.y1 = cy;
+    c.scale_q8 = (uint16_t)(scale_f * (1 << LOG_Q));
+
+    float sA = sinf(angle_rad);
+    float cA = cosf(angle_rad);
+    c.cos_q15 = (int16_t)(cA * 32767);
+    c.sin_q15 = (int16_t)(sA * 32767);
+
+    // Half extents of the rotated cell; one extra glyph unit covers the log-domain multiply error
+    uint32_t ac = abs(c.cos_q15), as = abs(c.sin_q15);
+    int16_t ex = (int16_t)(((((GLYPH_WIDTH / 2 + 1) * ac + (GLYPH_HEIGHT / 2 + 1) * as) >> 7) * c.scale_q8 >> 16) + 2);
+    int16_t ey = (int16_t)(((((GLYPH_WIDTH / 2 + 1) * as + (GLYPH_HEIGHT / 2 + 1) * ac) >> 7) * c.scale_q8 >> 16) + 2);
+    add_cmd(list, c, cx - ex, cy - ey, cx + ex, cy + ey);
+}
+
 // Helper to get character position from flat PROGMEM array
 static inline PathPoint getVerseCharPos(uint8_t verseIdx, uint8_t charIdx) {
     uint16_t offset;
@@ -286,7 +286,7 @@ float cameraX = 0, cameraY = 0, cameraZoom = 1.0f, cameraAngle = 0.0f;
 
 // -------------------- Rendering Functions --------------------
 
-void drawVerseCurved(TileManager &tiles, uint8_t verseIdx, uint16_t color,
+void drawVerseCurved(DisplayList &list, uint8_t verseIdx, uint16_t color,
                         float camX, float camY, float camZoom, float camAngle) {
     uint8_t len = getVerseLen(verseIdx);
     char buf[128];
@@ -307,12 +307,12 @@ void drawVerseCurved(TileManager &tiles, uint8_t verseIdx, uint16_t color,
         int16_t screenY = (int16_t)(ry * camZoom) + tft.height() / 2;
 
         // Draw character rotated relative to camera
-        draw_glyph_into_tiles(tiles, str[i], screenX, screenY, p.scale * camZoom, p.angle - camAngle, color);
+        draw_glyph_into_tiles(list, str[i], screenX, screenY, p.scale * camZoom, p.angle - camAngle, color);
     }
 }
 
 // Debug path rendering
-void drawDebugPath(TileManager &tiles, float camX, float camY, float camZoom, float camAngle) {
+void drawDebugPath(DisplayList &list, float camX, float camY, float camZoom, float camAngle) {
     for (int i=0; i<NUM_MASTER_SEGMENTS; ++i) {
         Segment s;
         memcpy_P(&s, &MASTER_PATH[i], sizeof(Segment));
@@ -331,14 +331,16 @@ void drawDebugPath(TileManager &tiles, float camX, float camY, float camZoom, fl
         int16_t x2 = transformX(s.x2, s.y2);
         int16_t y2 = transformY(s.x2, s.y2);
 
-        // Simple line drawing into tiles (just points for now for speed/simplicity)
         float dx = x2 - x1;
         float dy = y2 - y1;
         float len = sqrt(dx*dx + dy*dy);
         if (len < 1) continue;
-        for (float t=0; t<=1.0f; t += 1.0f/len) {
-            tiles.writePixelGlobal(x1 + dx*t, y1 + dy*t, 0x03E0); // Dim green
-        }
+
+        DrawCmd c;
+        c.kind = CMD_SEGMENT;
+        c.color = 0x03E0; // Dim green
+        c.x1 = x1; c.y1 = y1; c.x2 = x2; c.y2 = y2;
+        add_cmd(list, c, min(x1, x2) - 1, min(y1, y2) - 1, max(x1, x2) + 1, max(y1, y2) + 1);
     }
 }
 
@@ -366,7 +368,7 @@ void renderFlyby(uint8_t verseIdx, float progress) {
 
     cameraZoom = 4.0f;
 
-    drawDebugPath(gTiles, cameraX, cameraY, cameraZoom, cameraAngle);
+    drawDebugPath(gList, cameraX, cameraY, cameraZoom, cameraAngle);
 
     // Render all verses for context
     for (uint8_t i = 0; i < NUM_VERSES; i++) {
@@ -378,7 +380,7 @@ void renderFlyby(uint8_t verseIdx, float progress) {
             uint16_t b = (color & 0x1F) >> 1;
             color = (r << 11) | (g << 5) | b;
         }
-        drawVerseCurved(gTiles, i, color, cameraX, cameraY, cameraZoom, cameraAngle);
+        drawVerseCurved(gList, i, color, cameraX, cameraY, cameraZoom, cameraAngle);
     }
 }
 
@@ -391,10 +393,10 @@ void renderZoomOut(float progress) {
     cameraY = 0;
     cameraAngle *= 0.9f; // Straighten camera
     
-    drawDebugPath(gTiles, cameraX, cameraY, cameraZoom, cameraAngle);
+    drawDebugPath(gList, cameraX, cameraY, cameraZoom, cameraAngle);
 
     for (uint8_t i = 0; i < NUM_VERSES; i++) {
-        drawVerseCurved(gTiles, i, getVerseColor(i), cameraX, cameraY, cameraZoom, cameraAngle);
+        drawVerseCurved(gList, i, getVerseColor(i), cameraX, cameraY, cameraZoom, cameraAngle);
     }
 }
 
@@ -404,17 +406,17 @@ void renderFinal() {
     cameraZoom = 0.2f;
     cameraAngle = 0;
     
-    drawDebugPath(gTiles, cameraX, cameraY, cameraZoom, cameraAngle);
+    drawDebugPath(gList, cameraX, cameraY, cameraZoom, cameraAngle);
 
     for (uint8_t i = 0; i < NUM_VERSES; i++) {
-        drawVerseCurved(gTiles, i, getVerseColor(i), cameraX, cameraY, cameraZoom, cameraAngle);
+        drawVerseCurved(gList, i, getVerseColor(i), cameraX, cameraY, cameraZoom, cameraAngle);
     }
     
     // Pulsing "Murmure" at bottom
     if ((millis() / 800) % 2 == 0) {
         const char* outro = "Murmure...";
         for (int i = 0; i < strlen(outro); i++) {
-            draw_glyph_into_tiles(gTiles, outro[i], 
+            draw_glyph_into_tiles(gList, outro[i], 
                                  tft.width()/2 - 40 + i * 10, 
                                  tft.height() - 20, 1.2f, 0, 0x7BEF);
         }
@@ -427,9 +429,13 @@ void setup() {
     Serial.begin(115200);
     tft.init();
     tft.setRotation(1);
+    tft.initDMA();
     tft.fillScreen(TFT_BLACK);
     
-    gTiles.init(tft.width(), tft.height(), TILE_SIZE);
+    if (TILE_WORKERS > 1 && gWorkers.start(TILE_WORKERS)) gTiles.init(tft.width(), tft.height(), TILE_SIZE, 0x0000);
+    else gTiles.init(tft.width(), tft.height(), TILE_SIZE, 0x0000, TILE_POOL);
+    gList.bin_start = (uint16_t*)malloc(((size_t)gTiles.cols * gTiles.rows + 1) * sizeof(uint16_t));
+    gSink = FMT::tile_dma_push(tft);
     phaseStartMs = millis();
     
     Serial.println("Fractal Poem - Camera Flyby Optimized");
@@ -439,7 +445,7 @@ void loop() {
     uint32_t now = millis();
     uint32_t elapsed = now - phaseStartMs;
     
-    gTiles.startFrame(0x0000);
+    gList.count = 0;
     
     switch(currentPhase) {
         case FLYBY:
@@ -474,7 +480,17 @@ void loop() {
             break;
     }
     
-    gTiles.flush(tft);
+    gList.binned = FMT::tile_bin(gList.bounds, gList.count, gTiles.screen_w, gTiles.screen_h, TILE_SIZE,
+                                 gList.bin_start, gList.bin_items, MAX_BIN_ITEMS);
+    ListRenderer renderer = {&gList};
+    tft.startWrite();
+    if (gTiles.pool) {
+        gTiles.renderTiles(renderer, gSink);
+    } else {
+        gTiles.renderTilesParallel(renderer, gWorkers);
+        gTiles.flush(gSink);
+    }
+    tft.endWrite();
     
     delay(16); // ~60fps
 }
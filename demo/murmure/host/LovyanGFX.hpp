@@ -6,6 +6,7 @@
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <time.h>
 #define VSPI_HOST 0
 #define TFT_BLACK 0x0000
 #define TFT_WHITE 0xFFFF
@@ -20,15 +21,36 @@ namespace lgfx {
         uint16_t* buffer;
         int _width, _height;
         int _rotation;
-        LGFX_Device() : buffer(nullptr), _width(320), _height(240), _rotation(1) {}
+        // Simulated SPI: a push takes ns_per_push + w * h * ns_per_pixel of wall time. pushImage
+        // blocks for it; pushImageDMA waits for the previous transfer like the real driver, then
+        // returns at once and the pixels land in the panel when the transfer completes.
+        uint32_t ns_per_pixel, ns_per_push;
+        uint64_t pushed_pixels, pushes;
+        int64_t dma_end;
+        int dma_x, dma_y, dma_w, dma_h;
+        uint16_t* dma_data;
+        LGFX_Device() : buffer(nullptr), _width(320), _height(240), _rotation(1), ns_per_pixel(0), ns_per_push(0),
+                        pushed_pixels(0), pushes(0), dma_end(0), dma_data(nullptr) {}
         virtual ~LGFX_Device() { if (buffer) delete[] buffer; }
         void setPanel(Panel_Device* panel) {}
         void init() { if (!buffer) buffer = new uint16_t[_width * _height]; memset(buffer, 0, _width * _height * 2); }
+        void initDMA() {}
         void setRotation(int r) { _rotation = r; }
         void fillScreen(uint16_t color) { if (!buffer) return; for (int i=0; i<_width*_height; ++i) buffer[i] = color; }
         int width() { return _width; }
         int height() { return _height; }
-        void pushImage(int x, int y, int w, int h, uint16_t* data) {
+        void setTransferTime(uint32_t pixel_ns, uint32_t push_ns) { ns_per_pixel = pixel_ns; ns_per_push = push_ns; }
+        static int64_t now_ns() {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+        }
+        int64_t transferEnd(int w, int h) {
+            pushed_pixels += (uint64_t)w * h;
+            pushes++;
+            return now_ns() + ns_per_push + (int64_t)w * h * ns_per_pixel;
+        }
+        void blit(int x, int y, int w, int h, const uint16_t* data) {
             if (!buffer) return;
             for (int j=0; j<h; ++j) {
                 for (int i=0; i<w; ++i) {
@@ -37,8 +59,31 @@ namespace lgfx {
                 }
             }
         }
+        void retireDMA(bool block) {
+            if (!dma_data) return;
+            if (block) { while (now_ns() < dma_end) {} }
+            else if (now_ns() < dma_end) return;
+            blit(dma_x, dma_y, dma_w, dma_h, dma_data);
+            dma_data = nullptr;
+        }
+        bool dmaBusy() { retireDMA(false); return dma_data != nullptr; }
+        void waitDMA() { retireDMA(true); }
+        void startWrite() {}
+        void endWrite() { waitDMA(); }
+        void pushImage(int x, int y, int w, int h, uint16_t* data) {
+            waitDMA();
+            int64_t end = transferEnd(w, h);
+            while (now_ns() < end) {}
+            blit(x, y, w, h, data);
+        }
+        void pushImageDMA(int x, int y, int w, int h, uint16_t* data) {
+            waitDMA();
+            dma_end = transferEnd(w, h);
+            dma_x = x; dma_y = y; dma_w = w; dma_h = h; dma_data = data;
+        }
         void savePPM(const std::string& filename) {
             if (!buffer) return;
+            waitDMA();
             std::ofstream ofs(filename, std::ios::binary);
             ofs << "P6\n" << _width << " " << _height << "\n255\n";
             for (int i=0; i<_width*_height; ++i) {
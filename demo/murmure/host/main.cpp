@@ -2,6 +2,9 @@
 #include <string>
 #include <fstream>
 #include <algorithm>
+#include <thread> // FMT_Tiles.h needs these before the min/max macros of the Arduino mock
+#include <mutex>
+#include <condition_variable>
 #include "Arduino.h"
 #include "LovyanGFX.hpp"
 #include "esp_heap_caps.h"
@@ -17,7 +20,34 @@ inline uint32_t get_sim_millis() { return sim_millis; }
 #undef setup
 #undef loop
 
-int main() {
+// pool > 0 streams tiles through that many buffers, pool = 0 renders them on `workers` threads
+static void restart_scene(uint8_t pool, uint8_t workers = 1) {
+    gWorkers.stop();
+    if (!pool) gWorkers.start(workers);
+    gTiles.init(tft.width(), tft.height(), TILE_SIZE, 0x0000, pool);
+    tft.fillScreen(TFT_BLACK);
+    currentPhase = FLYBY;
+    currentVerse = 0;
+    sim_millis = 0;
+    phaseStartMs = 0;
+}
+
+// Wall-clock milliseconds per frame over the first `frames` frames
+static double time_frames(int frames) {
+    int64_t t0 = lgfx::LGFX_Device::now_ns();
+    for (int i = 0; i < frames; i++) {
+        sim_millis += 16;
+        arduino_loop();
+    }
+    tft.waitDMA();
+    return (lgfx::LGFX_Device::now_ns() - t0) / 1e6 / frames;
+}
+
+int main(int argc, char** argv) {
+    // Usage: simulator [ns per pixel] [ns per push]; the default is an 80 MHz SPI bus
+    uint32_t pixel_ns = argc > 1 ? atoi(argv[1]) : 200;
+    uint32_t push_ns = argc > 2 ? atoi(argv[2]) : 2000;
+
     arduino_setup();
     // Simulate to see camera movement
     for(int i=0; i<3000; i++) {
@@ -28,6 +58,49 @@ int main() {
             tft.savePPM(buf);
         }
     }
+    printf("Pushed %.0f pixels in %.0f pushes per frame (full screen %d).\n",
+           (double)tft.pushed_pixels / 3000, (double)tft.pushes / 3000, tft.width() * tft.height());
+
+    // Same frames again with simulated transfer latency: one spare buffer cannot overlap
+    // rendering with a transfer, more let the next tile render while the last one is sent
+    std::vector<uint16_t> expect(tft.width() * tft.height());
+    restart_scene(TILE_POOL);
+    time_frames(600);
+    memcpy(expect.data(), tft.buffer, expect.size() * 2);
+
+    tft.setTransferTime(pixel_ns, push_ns);
+    printf("Transfer %u ns/pixel + %u ns/push:\n", pixel_ns, push_ns);
+    double base = 0, streamed = 0;
+    for (uint8_t pool = 1; pool <= 4; pool++) {
+        restart_scene(pool);
+        double ms = time_frames(600);
+        if (pool == 1) base = ms;
+        if (pool == TILE_POOL) streamed = ms;
+        // A buffer reused before its transfer finished would leave wrong pixels on the panel
+        bool same = memcmp(expect.data(), tft.buffer, expect.size() * 2) == 0;
+        printf("  pool %u: %.3f ms/frame, speedup %.2fx, %.1f stalls/frame%s\n",
+               pool, ms, base / ms, gTiles.stalls / 600.0, same ? "" : ", FRAME MISMATCH");
+    }
+
+    // Rendering split over worker threads into per-tile buffers, flushed after the frame
+    // barrier: render-only speedup, then the whole frame against streaming with TILE_POOL
+    printf("Tile workers (%u hardware threads), render only / with transfer (streaming %.3f ms):\n",
+           std::thread::hardware_concurrency(), streamed);
+    restart_scene(0, 1);
+    time_frames(600); // warm up, so the first row is not penalised
+    for (uint8_t workers = 1; workers <= 4; workers++) {
+        tft.setTransferTime(0, 0);
+        restart_scene(0, workers);
+        double ms = time_frames(600);
+        if (workers == 1) base = ms;
+        bool same = memcmp(expect.data(), tft.buffer, expect.size() * 2) == 0;
+        tft.setTransferTime(pixel_ns, push_ns);
+        restart_scene(0, workers);
+        double full = time_frames(600);
+        same = same && memcmp(expect.data(), tft.buffer, expect.size() * 2) == 0;
+        printf("  %u worker%s: %.3f ms/frame, speedup %.2fx / %.3f ms/frame, %.2fx streaming%s\n",
+               workers, workers > 1 ? "s" : "", ms, base / ms, full, streamed / full, same ? "" : ", FRAME MISMATCH");
+    }
     printf("Simulation finished.\n");
     return 0;
 }
@@ -2,6 +2,7 @@
 #define LGFX_USE_V1
 #include <LovyanGFX.hpp>
 #include <esp_heap_caps.h>
+#include "../../fast_math_toolkit/FMT_Tiles.h"
 
 // include generated tables & glyphs
 #include "arduino_tables.h"
@@ -66,98 +67,9 @@ LGFX_ESP32 tft;
 #define SIN_SIZE 512
 
 // ------------------ Tile-based Compositor ------------------
+// Per-tile dirty boxes: only what was drawn this frame or last frame is cleared and pushed
 
-struct Tile {
-  uint16_t x0, y0;
-  uint16_t w, h;
-  uint16_t *buf;
-  bool dirty_curr;   // Changed in current frame
-  bool dirty_prev;   // Changed in previous frame
-
-  Tile(): x0(0), y0(0), w(0), h(0), buf(nullptr), dirty_curr(false), dirty_prev(false) {}
-
-  void init(uint16_t _x0, uint16_t _y0, uint16_t _w, uint16_t _h) {
-    x0 = _x0; y0 = _y0; w = _w; h = _h;
-    size_t n = (size_t)w * (size_t)h;
-    if (buf) { free(buf); buf = nullptr; }
-    
-    buf = (uint16_t*) heap_caps_malloc(n * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_32BIT);
-    if (!buf) buf = (uint16_t*) malloc(n * sizeof(uint16_t));
-    
-    dirty_curr = false;
-    dirty_prev = false;
-    if (buf) memset(buf, 0, n * sizeof(uint16_t));
-  }
-
-  void prepareFrame(uint16_t bgcolor) {
-    if (dirty_prev || dirty_curr) {
-      size_t n = (size_t)w * (size_t)h;
-      if (bgcolor == 0) memset(buf, 0, n * sizeof(uint16_t));
-      else {
-        for (size_t i=0; i<n; ++i) buf[i] = bgcolor;
-      }
-    }
-    dirty_prev = dirty_curr;
-    dirty_curr = false;
-  }
-
-  inline void writePixelLocal(int16_t lx, int16_t ly, uint16_t color) {
-    if (!buf || lx < 0 || ly < 0 || lx >= (int)w || ly >= (int)h) return;
-    buf[ly * w + lx] = color;
-    dirty_curr = true;
-  }
-};
-
-struct TileManager {
-  uint16_t screen_w, screen_h;
-  uint16_t tile_size;
-  uint16_t cols, rows;
-  Tile *tiles;
-
-  TileManager(): tiles(nullptr) {}
-
-  void init(uint16_t sw, uint16_t sh, uint16_t tsize=TILE_SIZE) {
-    screen_w = sw; screen_h = sh; tile_size = tsize;
-    cols = (screen_w + tile_size - 1) / tile_size;
-    rows = (screen_h + tile_size - 1) / tile_size;
-    size_t count = (size_t)cols * rows;
-    tiles = (Tile*)malloc(sizeof(Tile) * count);
-
-    for (uint16_t r=0; r<rows; ++r) {
-      for (uint16_t c=0; c<cols; ++c) {
-        uint16_t x0 = c * tile_size;
-        uint16_t y0 = r * tile_size;
-        uint16_t w = min((int)tile_size, (int)(screen_w - x0));
-        uint16_t h = min((int)tile_size, (int)(screen_h - y0));
-        Tile &t = tiles[r*cols + c];
-        new (&t) Tile();
-        t.init(x0, y0, w, h);
-      }
-    }
-  }
-
-  inline void writePixelGlobal(int16_t x, int16_t y, uint16_t color) {
-    if (x < 0 || y < 0 || x >= (int)screen_w || y >= (int)screen_h) return;
-    uint16_t tx = x / tile_size;
-    uint16_t ty = y / tile_size;
-    tiles[ty * cols + tx].writePixelLocal(x - (tx * tile_size), y - (ty * tile_size), color);
-  }
-
-  void startFrame(uint16_t bgcolor = 0x0000) {
-    uint32_t count = (uint32_t)cols * rows;
-    for (uint32_t i=0; i<count; ++i) tiles[i].prepareFrame(bgcolor);
-  }
-
-  void flush(LGFX_ESP32 &tft_ref) {
-    uint32_t count = (uint32_t)cols * rows;
-    for (uint32_t i=0; i < count; ++i) {
-      Tile &t = tiles[i];
-      if (t.dirty_curr || t.dirty_prev) {
-        tft_ref.pushImage(t.x0, t.y0, t.w, t.h, t.buf);
-      }
-    }
-  }
-};
+typedef FMT::TileCompositor<uint16_t> TileManager;
 
 TileManager gTiles;
 
@@ -469,7 +381,7 @@ void setup() {
     tft.setRotation(1);
     tft.fillScreen(TFT_BLACK);
     
-    gTiles.init(tft.width(), tft.height(), TILE_SIZE);
+    gTiles.init(tft.width(), tft.height(), TILE_SIZE, 0x0000);
     phaseStartMs = millis();
     // currentPhase = ZOOM_OUT; // test zoom
     Serial.println("Fractal Poem - Camera Flyby Optimized");
@@ -479,7 +391,7 @@ void loop() {
     uint32_t now = millis();
     uint32_t elapsed = now - phaseStartMs;
     
-    gTiles.startFrame(0x0000);
+    gTiles.startFrame();
    
     switch(currentPhase) {
         case FLYBY:
@@ -514,7 +426,7 @@ void loop() {
             break;
     }
     
-    gTiles.flush(tft);
+    gTiles.flushTo(tft);
     
     delay(16); // ~60fps
 }
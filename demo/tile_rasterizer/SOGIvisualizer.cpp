@@ -39,95 +39,19 @@ static LGFX_SOGI& get_hw() {
     return dev;
 }
 
-// ------------------ Tile Implementations ------------------
-
-Tile::Tile() : x0(0), y0(0), w(0), h(0), buf(nullptr), dirty_curr(false), dirty_prev(false) {}
-
-void Tile::init(uint16_t _x0, uint16_t _y0, uint16_t _w, uint16_t _h) {
-    x0 = _x0; y0 = _y0; w = _w; h = _h;
-    size_t n = (size_t)w * (size_t)h;
-    if (buf) heap_caps_free(buf);
-    buf = (uint8_t*) heap_caps_malloc(n, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
-    if (!buf) buf = (uint8_t*) malloc(n);
-    dirty_curr = true;
-    dirty_prev = true;
-    if (buf) memset(buf, 0, n);
-}
-
-// ------------------ TileManager Implementations ------------------
-
-TileManager::TileManager() : tiles(nullptr) {}
-
-void TileManager::init(uint16_t sw, uint16_t sh, uint16_t tsize) {
-    screen_w = sw; screen_h = sh; tile_size = tsize;
-    cols = (screen_w + tile_size - 1) / tile_size;
-    rows = (screen_h + tile_size - 1) / tile_size;
-    tiles = (Tile*)malloc(sizeof(Tile) * cols * rows);
-    for (uint16_t r = 0; r < rows; ++r) {
-        for (uint16_t c = 0; c < cols; ++c) {
-            uint16_t x0 = c * tile_size;
-            uint16_t y0 = r * tile_size;
-            uint16_t tw = (x0 + tile_size <= screen_w) ? tile_size : (screen_w - x0);
-            uint16_t th = (y0 + tile_size <= screen_h) ? tile_size : (screen_h - y0);
-            new (&tiles[r * cols + c]) Tile();
-            tiles[r * cols + c].init(x0, y0, tw, th);
-        }
-    }
-}
-
-void TileManager::writePixelGlobal(int16_t x, int16_t y, uint8_t color) {
-    if (x < 0 || y < 0 || x >= (int)screen_w || y >= (int)screen_h) return;
-#ifdef TILE_SHIFT
-    uint16_t tx = (uint16_t)(x >> TILE_SHIFT);
-    uint16_t ty = (uint16_t)(y >> TILE_SHIFT);
-    uint16_t lx = (uint16_t)(x & (tile_size - 1));
-    uint16_t ly = (uint16_t)(y & (tile_size - 1));
-#else
-    uint16_t tx = (uint16_t)(x / tile_size);
-    uint16_t ty = (uint16_t)(y / tile_size);
-    uint16_t lx = (uint16_t)(x - tx * tile_size);
-    uint16_t ly = (uint16_t)(y - ty * tile_size);
-#endif
-    Tile* t = tileAtIdx(tx, ty);
-    if (!t || !t->buf) return;
-    t->buf[(size_t)ly * (size_t)t->w + (size_t)lx] = color;
-    t->dirty_curr = true;
-}
-
-void TileManager::drawLine(int x0, int y0, int x1, int y1, uint8_t color) {
-    if ((x0 < 0 && x1 < 0) || (x0 >= (int)screen_w && x1 >= (int)screen_w) ||
-        (y0 < 0 && y1 < 0) || (y0 >= (int)screen_h && y1 >= (int)screen_h)) return;
-
-    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
-    int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
-    int err = dx + dy, e2;
-
-    while (true) {
-        writePixelGlobal(x0, y0, color);
-        if (x0 == x1 && y0 == y1) break;
-        e2 = 2 * err;
-        if (e2 >= dy) { err += dy; x0 += sx; }
-        if (e2 <= dx) { err += dx; y0 += sy; }
-    }
-}
-
-void TileManager::startFrame() {
-    uint32_t count = (uint32_t)cols * rows;
-    for (uint32_t i = 0; i < count; ++i) tiles[i].prepareFrame();
-}
-
-void TileManager::flush(lgfx::LGFX_Device &dev) {
-    dev.endWrite();
-    dev.startWrite();
-    uint32_t total = (uint32_t)cols * rows;
-    for (uint32_t i = 0; i < total; ++i) {
-        Tile &t = tiles[i];
-        if (t.dirty_curr || t.dirty_prev) {
-            dev.pushImage(t.x0, t.y0, t.w, t.h, t.buf, lgfx::grayscale_8bit);
-        }
+// ------------------ Tile Flush ------------------
+
+// FMT::TileDmaPush for 8-bit grayscale tiles, which need the source depth spelled out
+struct GrayscaleDmaSink {
+    lgfx::LGFX_Device *dev;
+    uint32_t pushes;
+    uint32_t push(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data) {
+        dev->pushImageDMA(x, y, w, h, data, lgfx::grayscale_8bit, (const lgfx::bgr888_t *)nullptr);
+        return ++pushes;
     }
-//    dev.endWrite();
-}
+    void wait() { while (dev->dmaBusy()) FMT_TILE_YIELD(); }
+    uint32_t completed() { return dev->dmaBusy() ? pushes - 1 : pushes; }
+};
 
 static TileManager& get_canvas() {
     static TileManager tm;
@@ -222,5 +146,8 @@ void SOGIVisualizer::update(const float* buffer, int bufLen, int startIdx, int c
     //int error_w = (int)(fminf(1.0f, fabsf(error) * 2.0f) * SCREEN_WIDTH);
     //for(int x=0; x<error_w; x++) { g_tiled_canvas.writePixelGlobal(x, ERROR_BAR_Y, 255);} // very cpu intensive
 
-    g_tiled_canvas.flush(dev);
+    dev.endWrite();
+    dev.startWrite();
+    GrayscaleDmaSink sink = {&dev, 0};
+    g_tiled_canvas.flush(sink);
 }
@@ -1,11 +1,11 @@
 #include <Arduino.h>
 #include <TFT_eSPI.h> 
 #include <esp_heap_caps.h>
+#include "../fast_math_toolkit/FMT_Tiles.h"
 #include "arduino_tables.h" 
 
 // ------------------ Configuration ------------------
 #define TILE_SIZE 64         
-#define MAX_OUTSTANDING_DMA 16
 #define LOG_Q 8
 #define SIN_Q 15
 #define SIN_SIZE 512
@@ -14,123 +14,10 @@
 
 TFT_eSPI tft = TFT_eSPI();
 
-// [Tile, TileManager, and Fast Math structures are assumed present as per original]
 // ------------------ Tile-based Compositor ------------------
+// Per-tile dirty boxes: only what was drawn this frame or last frame is cleared and pushed
 
-struct Tile {
-  uint16_t x0, y0;   
-  uint16_t w, h;     
-  uint16_t *buf;     // DMA-capable pixel buffer (RGB565)
-  bool dirty;
-  
-  Tile(): x0(0), y0(0), w(0), h(0), buf(nullptr), dirty(false) {}
-  
-  void init(uint16_t _x0, uint16_t _y0, uint16_t _w, uint16_t _h) {
-    x0 = _x0; y0 = _y0; w = _w; h = _h;
-    size_t n = (size_t)w * (size_t)h;
-    if (buf) free(buf);
-    // Attempt to allocate in DMA capable memory
-    buf = (uint16_t*) heap_caps_malloc(n * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
-    if (!buf) buf = (uint16_t*) malloc(n * sizeof(uint16_t)); // Fallback
-    dirty = false;
-    if (buf) memset(buf, 0, n * sizeof(uint16_t));
-  }
-  
-  void clearTo(uint16_t color = 0x0000) {
-    if (!buf) return;
-    size_t n = (size_t)w * (size_t)h;
-    for (size_t i=0; i<n; ++i) buf[i] = color;
-    dirty = false;
-  }
-
-  inline void writePixelLocal(int16_t lx, int16_t ly, uint16_t color) {
-    if (!buf || lx < 0 || ly < 0 || lx >= (int)w || ly >= (int)h) return;
-    buf[ly * w + lx] = color;
-    dirty = true;
-  }
-
-  void freeBuf() {
-    if (buf) { free(buf); buf = nullptr; }
-  }
-};
-
-struct TileManager {
-  uint16_t screen_w, screen_h;
-  uint16_t tile_size;
-  uint16_t cols, rows;
-  Tile *tiles;
-
-  TileManager(): screen_w(0), screen_h(0), tile_size(TILE_SIZE), cols(0), rows(0), tiles(nullptr) {}
-
-  void init(uint16_t sw, uint16_t sh, uint16_t tsize=TILE_SIZE) {
-    screen_w = sw; screen_h = sh; tile_size = tsize;
-    cols = (screen_w + tile_size - 1) / tile_size;
-    rows = (screen_h + tile_size - 1) / tile_size;
-    size_t count = (size_t)cols * rows;
-    tiles = (Tile*)malloc(sizeof(Tile) * count);
-    
-    for (uint16_t r=0; r<rows; ++r) {
-      for (uint16_t c=0; c<cols; ++c) {
-        uint16_t x0 = c * tile_size;
-        uint16_t y0 = r * tile_size;
-        uint16_t w = min(tile_size, (uint16_t)(screen_w - x0));
-        uint16_t h = min(tile_size, (uint16_t)(screen_h - y0));
-        Tile &t = tiles[r*cols + c];
-        new (&t) Tile();
-        t.init(x0, y0, w, h);
-      }
-    }
-  }
-
-  inline Tile &tileAtIdx(uint16_t tx, uint16_t ty) { return tiles[ty * cols + tx]; }
-
-  inline bool coordToTile(int16_t x, int16_t y, uint16_t &tx, uint16_t &ty) {
-    if (x < 0 || y < 0 || x >= (int)screen_w || y >= (int)screen_h) return false;
-    tx = x / tile_size;
-    ty = y / tile_size;
-    return true;
-  }
-
-  void frameClear(uint16_t bgcolor = 0x0000) {
-    uint32_t count = (uint32_t)cols * rows;
-    for (uint32_t i=0; i<count; ++i) {
-      tiles[i].clearTo(bgcolor);
-    }
-  }
-
-  inline void writePixelGlobal(int16_t x, int16_t y, uint16_t color) {
-    uint16_t tx, ty;
-    if (!coordToTile(x, y, tx, ty)) return;
-    Tile &t = tileAtIdx(tx, ty);
-    t.writePixelLocal(x - t.x0, y - t.y0, color);
-  }
-
-  void flush(TFT_eSPI &tft) {
-    uint16_t outstanding = 0;
-    uint32_t count = (uint32_t)cols * rows;
-    for (uint32_t i=0; i<count; ++i) {
-      Tile &t = tiles[i];
-      if (!t.dirty) continue;
-      
-      tft.pushImageDMA(t.x0, t.y0, t.w, t.h, t.buf);
-      outstanding++;
-      
-      if (outstanding >= MAX_OUTSTANDING_DMA) {
-        while (tft.dmaBusy()) { yield(); }
-        outstanding = 0;
-      }
-      t.dirty = false;
-    }
-    while (tft.dmaBusy()) { yield(); }
-  }
-
-  void deinit() {
-    if (!tiles) return;
-    size_t count = (size_t)cols * rows;
-    for (size_t i=0; i<count; ++i) tiles[i].freeBuf();
-    free(tiles); tiles = nullptr;
-  }
-};
+typedef FMT::TileCompositor<uint16_t> TileManager;
 
 // ------------------ Globals & Helpers ------------------
 
@@ -361,7 +248,7 @@ void render_frame() {
     }
     last_time = now;
 
-    gTiles.frameClear(0x0000);
+    gTiles.startFrame();
 
     // 1. Header in a wide box at the top
      //param x0, y0, x1, y1 Bounding box coordinates
@@ -379,7 +266,8 @@ void render_frame() {
     // 3. Footer box for FPS
     draw_string_dynamic(fps_buf, 0, 190, tft.width(), 240, 9.8f, 20.0, 10, true, TFT_GREEN);
 
-    gTiles.flush(tft);
+    FMT::TileDmaPush<TFT_eSPI> sink = FMT::tile_dma_push(tft);
+    gTiles.flush(sink);
     frame_count++;
 }
 
@@ -389,7 +277,7 @@ void setup() {
     tft.initDMA();
     tft.setRotation(1);
     tft.fillScreen(TFT_BLACK);
-    gTiles.init(tft.width(), tft.height(), TILE_SIZE);
+    gTiles.init(tft.width(), tft.height(), TILE_SIZE, TFT_BLACK);
     delay(200);
 }
 
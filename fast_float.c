@@ -22,29 +22,49 @@ typedef union {
     uint32_t u;
 } float_conv;
 
-static uint16_t btm_log2(uint32_t mantissa_bits) {
-    uint16_t idx = (uint16_t)(mantissa_bits >> (23 - 14));
-    uint16_t i12 = idx >> 5; // 9 bits
-    uint16_t i13 = ((idx >> 10) << 5) | (idx & 31); // 9 bits
+#if BTM_BITS > 16 || BTM_TO_COUNT < 1 || BTM_TO_COUNT > 3
+#error "fast_float.c supports up to 16 table input bits and 1 to 3 offset tables"
+#endif
 
-    uint16_t t1 = read_word(&log2_t1[i12]);
-    int16_t t2 = read_sword(&log2_t2[i13]);
+// Offset table n's index for the BTM_BITS-bit table input idx
+#define BTM_TO_INDEX(idx, n) \
+    ((((idx) >> (BTM_BITS - BTM_TO##n##_SEG_BITS)) << BTM_TO##n##_SLICE_BITS) | \
+     (((idx) >> BTM_TO##n##_SLICE_SHIFT) & ((1 << BTM_TO##n##_SLICE_BITS) - 1)))
+
+static inline int32_t btm_sum(uint16_t idx, const uint16_t *t1, const int16_t *t2,
+                              const int16_t *t3, const int16_t *t4) {
+    int32_t res = (int32_t)read_word(&t1[idx >> (BTM_BITS - BTM_TIV_BITS)]) + read_sword(&t2[BTM_TO_INDEX(idx, 1)]);
+#if BTM_TO_COUNT >= 2
+    res += read_sword(&t3[BTM_TO_INDEX(idx, 2)]);
+#endif
+#if BTM_TO_COUNT >= 3
+    res += read_sword(&t4[BTM_TO_INDEX(idx, 3)]);
+#endif
+    (void)t3;
+    (void)t4;
+    return res;
+}
 
-    int32_t res = (int32_t)t1 + t2;
+#if BTM_TO_COUNT >= 3
+#define BTM_LOG2_TABLES log2_t1, log2_t2, log2_t3, log2_t4
+#define BTM_EXP2_TABLES exp2_t1, exp2_t2, exp2_t3, exp2_t4
+#elif BTM_TO_COUNT == 2
+#define BTM_LOG2_TABLES log2_t1, log2_t2, log2_t3, 0
+#define BTM_EXP2_TABLES exp2_t1, exp2_t2, exp2_t3, 0
+#else
+#define BTM_LOG2_TABLES log2_t1, log2_t2, 0, 0
+#define BTM_EXP2_TABLES exp2_t1, exp2_t2, 0, 0
+#endif
+
+static uint16_t btm_log2(uint32_t mantissa_bits) {
+    int32_t res = btm_sum((uint16_t)(mantissa_bits >> (23 - BTM_BITS)), BTM_LOG2_TABLES);
     if (res < 0) return 0;
     if (res > 65535) return 65535;
     return (uint16_t)res;
 }
 
 static uint32_t btm_exp2(uint16_t log_frac) {
-    uint16_t idx = log_frac >> (16 - 14);
-    uint16_t i12 = idx >> 5;
-    uint16_t i13 = ((idx >> 10) << 5) | (idx & 31);
-
-    uint16_t t1 = read_word(&exp2_t1[i12]);
-    int16_t t2 = read_sword(&exp2_t2[i13]);
-
-    int32_t res = (int32_t)t1 + t2;
+    int32_t res = btm_sum(log_frac >> (16 - BTM_BITS), BTM_EXP2_TABLES);
     if (res < 0) res = 0;
     if (res > 65535) res = 65535;
 
@@ -52,40 +72,53 @@ static uint32_t btm_exp2(uint16_t log_frac) {
     return (res_q16 << 7); // Q16 to Q23
 }
 
-float fast_mul_f32(float a, float b) {
-    float_conv ca, cb, cr;
-    ca.f = a;
-    cb.f = b;
-
-    uint32_t a_abs = ca.u & 0x7FFFFFFF;
-    uint32_t b_abs = cb.u & 0x7FFFFFFF;
-    if (a_abs == 0 || b_abs == 0) return 0.0f;
+// Sign, exponent and mantissa of a*b from the raw bits, with lb = btm_log2 of b's mantissa
+static inline uint32_t btm_mul_bits(uint32_t ua, uint32_t ub, uint16_t lb) {
+    if ((ua & 0x7FFFFFFF) == 0 || (ub & 0x7FFFFFFF) == 0) return 0;
 
-    uint32_t sa = ca.u >> 31;
-    uint32_t sb = cb.u >> 31;
-    int32_t ea = (ca.u >> 23) & 0xFF;
-    int32_t eb = (cb.u >> 23) & 0xFF;
-    uint32_t ma = ca.u & 0x7FFFFF;
-    uint32_t mb = cb.u & 0x7FFFFF;
-
-    uint16_t la = btm_log2(ma);
-    uint16_t lb = btm_log2(mb);
+    uint32_t sr = (ua ^ ub) & 0x80000000;
+    int32_t ea = (ua >> 23) & 0xFF;
+    int32_t eb = (ub >> 23) & 0xFF;
+    uint16_t la = btm_log2(ua & 0x7FFFFF);
 
     uint32_t lsum = (uint32_t)la + lb;
     int32_t carry = (int32_t)(lsum >> 16);
     uint16_t lfrac = lsum & 0xFFFF;
 
     int32_t er = ea + eb - 127 + carry;
-    uint32_t mr = btm_exp2(lfrac);
-    uint32_t sr = sa ^ sb;
+    if (er <= 0) return 0;
+    if (er >= 255) return sr | 0x7F800000;
+    return sr | ((uint32_t)er << 23) | btm_exp2(lfrac);
+}
 
-    if (er <= 0) return 0.0f;
-    if (er >= 255) {
-        cr.u = (sr << 31) | 0x7F800000;
-        return cr.f;
+static inline uint32_t btm_div_bits(uint32_t ua, uint32_t ub, uint16_t lb) {
+    if ((ua & 0x7FFFFFFF) == 0) return 0;
+    uint32_t sr = (ua ^ ub) & 0x80000000;
+    if ((ub & 0x7FFFFFFF) == 0) return sr | 0x7F800000;
+
+    int32_t ea = (ua >> 23) & 0xFF;
+    int32_t eb = (ub >> 23) & 0xFF;
+    uint16_t la = btm_log2(ua & 0x7FFFFF);
+
+    int32_t ldiff = (int32_t)la - lb;
+    int32_t carry = 0;
+    if (ldiff < 0) {
+        ldiff += 65536;
+        carry = -1;
     }
+    uint16_t lfrac = (uint16_t)ldiff;
+
+    int32_t er = ea - eb + 127 + carry;
+    if (er <= 0) return 0;
+    if (er >= 255) return sr | 0x7F800000;
+    return sr | ((uint32_t)er << 23) | btm_exp2(lfrac);
+}
 
-    cr.u = (sr << 31) | ((uint32_t)er << 23) | mr;
+float fast_mul_f32(float a, float b) {
+    float_conv ca, cb, cr;
+    ca.f = a;
+    cb.f = b;
+    cr.u = btm_mul_bits(ca.u, cb.u, btm_log2(cb.u & 0x7FFFFF));
     return cr.f;
 }
 
@@ -93,43 +126,771 @@ float fast_div_f32(float a, float b) {
     float_conv ca, cb, cr;
     ca.f = a;
     cb.f = b;
+    cr.u = btm_div_bits(ca.u, cb.u, btm_log2(cb.u & 0x7FFFFF));
+    return cr.f;
+}
 
-    uint32_t a_abs = ca.u & 0x7FFFFFFF;
-    uint32_t b_abs = cb.u & 0x7FFFFFFF;
-    if (a_abs == 0) return 0.0f;
-    if (b_abs == 0) {
-        cr.u = ((ca.u ^ cb.u) & 0x80000000) | 0x7F800000;
-        return cr.f;
+/*
+ * Log-domain functions. A positive normal float is 2^e * (1 + m), so its log2 is
+ * e + btm_log2(m) / 65536; working in that Q16.16 log the exponent field does the
+ * integer part and the BTM tables the fraction, with no float arithmetic at all.
+ * Denormal inputs are treated as zero.
+ */
+
+// log2 of the positive normal float with bits u, Q16.16
+static inline int32_t btm_log2_q16(uint32_t u) {
+    return ((int32_t)((u >> 23) & 0xFF) - 127) * 65536 + btm_log2(u & 0x7FFFFF);
+}
+
+// 2^(l / 65536) as float bits; 0 below FLT_MIN, +inf above FLT_MAX
+static inline uint32_t btm_exp2_q16(int32_t l) {
+    int32_t er = (l >> 16) + 127;
+    if (er <= 0) return 0;
+    if (er >= 255) return 0x7F800000;
+    return ((uint32_t)er << 23) | btm_exp2((uint16_t)(l & 0xFFFF));
+}
+
+// Float bits to Q16.16, truncated toward zero; false if |x| >= 32768
+static inline int f32_to_q16(uint32_t u, int32_t *out) {
+    int32_t e = (int32_t)((u >> 23) & 0xFF) - 127;
+    if (e >= 15) return 0;
+    uint32_t m = (u & 0x7FFFFF) | 0x800000;
+    int32_t shift = e + 16 - 23;
+    uint32_t v = shift >= 0 ? m << shift : (shift > -32 ? m >> -shift : 0);
+    *out = (u >> 31) ? -(int32_t)v : (int32_t)v;
+    return 1;
+}
+
+// Q16.16 to float bits, exact up to the 24-bit mantissa (truncated)
+static inline uint32_t q16_to_f32(int32_t v) {
+    if (v == 0) return 0;
+    uint32_t sign = 0, a = (uint32_t)v;
+    if (v < 0) {
+        sign = 0x80000000;
+        a = (uint32_t)-v;
+    }
+    int8_t msb = 31;
+    while (!(a & 0x80000000UL)) {
+        a <<= 1;
+        msb--;
     }
+    // a now has its leading one in bit 31, value 2^(msb - 16)
+    return sign | ((uint32_t)(msb - 16 + 127) << 23) | ((a >> 8) & 0x7FFFFF);
+}
 
-    uint32_t sa = ca.u >> 31;
-    uint32_t sb = cb.u >> 31;
-    int32_t ea = (ca.u >> 23) & 0xFF;
-    int32_t eb = (cb.u >> 23) & 0xFF;
-    uint32_t ma = ca.u & 0x7FFFFF;
-    uint32_t mb = cb.u & 0x7FFFFF;
+float fast_log2_f32(float x) {
+    float_conv c, r;
+    c.f = x;
+    if (c.u & 0x80000000) {
+        r.u = (c.u & 0x7FFFFFFF) ? 0x7FC00000 : 0xFF800000; // log2(-x) = NaN, log2(-0) = -inf
+        return r.f;
+    }
+    if (c.u < 0x00800000) {
+        r.u = 0xFF800000;
+        return r.f;
+    }
+    if (c.u >= 0x7F800000) return x; // +inf, NaN
+    r.u = q16_to_f32(btm_log2_q16(c.u));
+    return r.f;
+}
 
-    uint16_t la = btm_log2(ma);
-    uint16_t lb = btm_log2(mb);
+float fast_exp2_f32(float x) {
+    float_conv c, r;
+    c.f = x;
+    int32_t l;
+    if (!f32_to_q16(c.u, &l)) {
+        if ((c.u & 0x7FFFFFFF) > 0x7F800000) return x; // NaN
+        r.u = (c.u & 0x80000000) ? 0 : 0x7F800000;
+        return r.f;
+    }
+    r.u = btm_exp2_q16(l);
+    return r.f;
+}
 
-    int32_t ldiff = (int32_t)la - lb;
-    int32_t carry = 0;
-    if (ldiff < 0) {
-        ldiff += 65536;
-        carry = -1;
+// Halving the log is an exact shift, so sqrt and rsqrt cost one lookup pair each way
+float fast_sqrt_f32(float x) {
+    float_conv c, r;
+    c.f = x;
+    if (c.u & 0x80000000) {
+        r.u = (c.u & 0x7FFFFFFF) ? 0x7FC00000 : c.u; // sqrt(-0) = -0
+        return r.f;
     }
-    uint16_t lfrac = (uint16_t)ldiff;
+    if (c.u < 0x00800000) return 0.0f;
+    if (c.u >= 0x7F800000) return x;
+    r.u = btm_exp2_q16(btm_log2_q16(c.u) >> 1);
+    return r.f;
+}
 
-    int32_t er = ea - eb + 127 + carry;
-    uint32_t mr = btm_exp2(lfrac);
-    uint32_t sr = sa ^ sb;
+float fast_rsqrt_f32(float x) {
+    float_conv c, r;
+    c.f = x;
+    if (c.u & 0x80000000) {
+        r.u = (c.u & 0x7FFFFFFF) ? 0x7FC00000 : 0xFF800000;
+        return r.f;
+    }
+    if (c.u < 0x00800000) {
+        r.u = 0x7F800000;
+        return r.f;
+    }
+    if (c.u >= 0x7F800000) {
+        r.u = (c.u == 0x7F800000) ? 0 : c.u;
+        return r.f;
+    }
+    r.u = btm_exp2_q16(-(btm_log2_q16(c.u) >> 1));
+    return r.f;
+}
 
-    if (er <= 0) return 0.0f;
-    if (er >= 255) {
-        cr.u = (sr << 31) | 0x7F800000;
-        return cr.f;
+// x^y for x > 0 as 2^(y log2 x); |y| must stay below 32768. Negative x gives NaN.
+float fast_pow_f32(float x, float y) {
+    float_conv cx, cy, r;
+    cx.f = x;
+    cy.f = y;
+    if ((cy.u & 0x7FFFFFFF) == 0) return 1.0f;
+    if (cx.u & 0x80000000) {
+        r.u = 0x7FC00000;
+        return r.f;
+    }
+    if (cx.u < 0x00800000) {
+        r.u = (cy.u & 0x80000000) ? 0x7F800000 : 0;
+        return r.f;
     }
+    int32_t ly;
+    if (cx.u >= 0x7F800000 || !f32_to_q16(cy.u, &ly)) return fast_exp2_f32(fast_mul_f32(fast_log2_f32(x), y));
+    int64_t l = ((int64_t)btm_log2_q16(cx.u) * ly) >> 16;
+    if (l >= ((int64_t)128 << 16)) {
+        r.u = 0x7F800000;
+        return r.f;
+    }
+    if (l < -((int64_t)128 << 16)) return 0.0f;
+    r.u = btm_exp2_q16((int32_t)l);
+    return r.f;
+}
+
+/*
+ * Block-exponent accumulation. A product (or a float) is a signed 24-bit mantissa m with a
+ * biased exponent e, value m * 2^(e - 150). The accumulator keeps the exponent of its
+ * largest term and holds the others shifted down to it; the sum stays below 2^30 in
+ * magnitude, halving (and bumping the exponent) when it gets there. Intermediate results
+ * can leave the float exponent range without harm; only btm_acc_pack rounds.
+ */
+typedef struct {
+    int32_t acc;
+    int16_t e;
+} btm_acc;
+
+// Below any product's exponent, so the first term sets it
+#define BTM_ACC_INIT {0, -1024}
 
-    cr.u = (sr << 31) | ((uint32_t)er << 23) | mr;
+static inline void btm_acc_add(btm_acc *s, int32_t m, int16_t e) {
+    int16_t d = e - s->e;
+    if (d > 0) {
+        s->acc = d > 30 ? 0 : s->acc >> d;
+        s->e = e;
+    } else if (d < 0) {
+        if (d < -24) return;
+        m >>= -d;
+    }
+    s->acc += m;
+    if (s->acc >= (1L << 30) || s->acc <= -(1L << 30)) {
+        s->acc >>= 1;
+        s->e++;
+    }
+}
+
+// Add a * b, with lb = btm_log2 of b's mantissa
+static inline void btm_acc_mul(btm_acc *s, uint32_t ua, uint32_t ub, uint16_t lb) {
+    int16_t ea = (ua >> 23) & 0xFF, eb = (ub >> 23) & 0xFF;
+    if (ea == 0 || eb == 0) return;
+    uint32_t lsum = (uint32_t)btm_log2(ua & 0x7FFFFF) + lb;
+    int32_t m = ((int32_t)1 << 23) | (int32_t)btm_exp2((uint16_t)lsum);
+    btm_acc_add(s, ((ua ^ ub) & 0x80000000) ? -m : m, ea + eb - 127 + (int16_t)(lsum >> 16));
+}
+
+static inline void btm_acc_float(btm_acc *s, uint32_t u) {
+    int16_t e = (u >> 23) & 0xFF;
+    if (e == 0) return;
+    int32_t m = ((int32_t)1 << 23) | (int32_t)(u & 0x7FFFFF);
+    btm_acc_add(s, (u & 0x80000000) ? -m : m, e);
+}
+
+// Round the sum to float bits; 0 below FLT_MIN, inf above FLT_MAX
+static inline uint32_t btm_acc_pack(const btm_acc *s) {
+    if (s->acc == 0) return 0;
+    uint32_t sign = 0, m = (uint32_t)s->acc;
+    if (s->acc < 0) {
+        sign = 0x80000000;
+        m = (uint32_t)0 - m;
+    }
+    int16_t e = s->e;
+    uint8_t k = 0;
+    while ((m >> k) >= ((uint32_t)1 << 24)) k++;
+    if (k) {
+        m = (m + ((uint32_t)1 << (k - 1))) >> k;
+        e += k;
+        if (m >> 24) {
+            m >>= 1;
+            e++;
+        }
+    }
+    while (!(m & ((uint32_t)1 << 23))) {
+        m <<= 1;
+        e--;
+    }
+    if (e <= 0) return 0;
+    if (e >= 255) return sign | 0x7F800000;
+    return sign | ((uint32_t)e << 23) | (m & 0x7FFFFF);
+}
+
+float fast_dot_f32(const float *a, const float *b, uint16_t n) {
+    btm_acc s = BTM_ACC_INIT;
+    float_conv ca, cb, cr;
+    while (n--) {
+        ca.f = *a++;
+        cb.f = *b++;
+        btm_acc_mul(&s, ca.u, cb.u, btm_log2(cb.u & 0x7FFFFF));
+    }
+    cr.u = btm_acc_pack(&s);
     return cr.f;
 }
+
+// The log of a is looked up once; each element is one log2 and one exp2 lookup and an integer add
+void fast_axpy_f32(float a, const float *x, float *y, uint16_t n) {
+    float_conv ca, cx, cy;
+    ca.f = a;
+    uint16_t la = btm_log2(ca.u & 0x7FFFFF);
+    while (n--) {
+        btm_acc s = BTM_ACC_INIT;
+        cx.f = *x++;
+        cy.f = *y;
+        btm_acc_float(&s, cy.u);
+        btm_acc_mul(&s, cx.u, ca.u, la);
+        cy.u = btm_acc_pack(&s);
+        *y++ = cy.f;
+    }
+}
+
+/*
+ * 16-bit encodings: fp16 is sign:5:10 with bias 15, bfloat16 sign:8:7 with bias 127 (the top
+ * half of a float). A mantissa of mb bits is shifted up to btm_log2's 23-bit input, so the
+ * tables are read at exact points and no extra tables are needed; the Q23 exp2 result is
+ * rounded to mb bits. emax is both the exponent mask and the all-ones (inf/NaN) exponent.
+ */
+static inline uint16_t btm_half_pack(uint16_t sr, int16_t er, uint16_t lfrac, uint8_t mb, int16_t emax) {
+    uint32_t sig = ((uint32_t)1 << 23) | btm_exp2(lfrac);
+    if (er <= 0) {
+        // Denormal result (fp16 underflows at 6e-5, so these are common): one more bit
+        // dropped per step below the smallest exponent; a carry makes it the smallest normal
+        uint8_t s = 23 - mb + 1 - er;
+        if (s > 24) return sr;
+        return sr | (uint16_t)((sig + ((uint32_t)1 << (s - 1))) >> s);
+    }
+    uint32_t m = (sig + ((uint32_t)1 << (22 - mb))) >> (23 - mb);
+    if (m >> (mb + 1)) { // rounded up to 2.0
+        m >>= 1;
+        er++;
+    }
+    if (er >= emax) return sr | ((uint16_t)emax << mb);
+    return sr | ((uint16_t)er << mb) | (uint16_t)(m & ((1 << mb) - 1));
+}
+
+static inline uint16_t btm_half_log2(uint16_t u, uint8_t mb) {
+    return btm_log2((uint32_t)(u & ((1 << mb) - 1)) << (23 - mb));
+}
+
+// A NaN operand comes back quieted; otherwise 0 and the invalid cases (inf * 0, inf / inf) give NaN
+static inline uint16_t btm_half_nan(uint16_t ua, uint16_t ub, uint8_t mb, int16_t emax) {
+    uint16_t inf = (uint16_t)emax << mb, quiet = inf | (uint16_t)(1 << (mb - 1));
+    if ((ua & 0x7FFF) > inf) return ua | quiet;
+    if ((ub & 0x7FFF) > inf) return ub | quiet;
+    return 0;
+}
+
+static inline uint16_t btm_mul_half(uint16_t ua, uint16_t ub, uint8_t mb, int16_t bias, int16_t emax) {
+    int16_t ea = (ua >> mb) & emax, eb = (ub >> mb) & emax;
+    if (ea == emax || eb == emax) {
+        uint16_t nan = btm_half_nan(ua, ub, mb, emax);
+        if (nan) return nan;
+        if (!(ua & 0x7FFF) || !(ub & 0x7FFF)) return ((uint16_t)emax << mb) | (uint16_t)(1 << (mb - 1));
+        return ((ua ^ ub) & 0x8000) | ((uint16_t)emax << mb);
+    }
+    if (ea == 0 || eb == 0) return (ua ^ ub) & 0x8000;
+    uint32_t lsum = (uint32_t)btm_half_log2(ua, mb) + btm_half_log2(ub, mb);
+    return btm_half_pack((ua ^ ub) & 0x8000, ea + eb - bias + (int16_t)(lsum >> 16), (uint16_t)lsum, mb, emax);
+}
+
+static inline uint16_t btm_div_half(uint16_t ua, uint16_t ub, uint8_t mb, int16_t bias, int16_t emax) {
+    int16_t ea = (ua >> mb) & emax, eb = (ub >> mb) & emax;
+    uint16_t sr = (ua ^ ub) & 0x8000;
+    if (ea == emax || eb == emax) {
+        uint16_t nan = btm_half_nan(ua, ub, mb, emax);
+        if (nan) return nan;
+        if (ea == eb) return ((uint16_t)emax << mb) | (uint16_t)(1 << (mb - 1)); // inf / inf
+        return ea == emax ? sr | ((uint16_t)emax << mb) : sr;
+    }
+    if (ea == 0) return sr;
+    if (eb == 0) return sr | ((uint16_t)emax << mb);
+    // la - lb + 65536: bit 16 clear means a borrow
+    int32_t ldiff = (int32_t)btm_half_log2(ua, mb) - btm_half_log2(ub, mb) + 65536;
+    return btm_half_pack(sr, ea - eb + bias - 1 + (int16_t)(ldiff >> 16), (uint16_t)ldiff, mb, emax);
+}
+
+uint16_t fast_mul_f16(uint16_t a, uint16_t b) {
+    return btm_mul_half(a, b, 10, 15, 31);
+}
+
+uint16_t fast_div_f16(uint16_t a, uint16_t b) {
+    return btm_div_half(a, b, 10, 15, 31);
+}
+
+uint16_t fast_mul_bf16(uint16_t a, uint16_t b) {
+    return btm_mul_half(a, b, 7, 127, 255);
+}
+
+uint16_t fast_div_bf16(uint16_t a, uint16_t b) {
+    return btm_div_half(a, b, 7, 127, 255);
+}
+
+// fp16 to float bits, exact; denormals are normalized
+static inline uint32_t f16_to_f32_bits(uint16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    int16_t e = (h >> 10) & 0x1F;
+    uint32_t m = h & 0x3FF;
+    if (e == 0x1F) return sign | 0x7F800000 | (m << 13);
+    if (e == 0) {
+        if (m == 0) return sign;
+        e = 1;
+        while (!(m & 0x400)) {
+            m <<= 1;
+            e--;
+        }
+        m &= 0x3FF;
+    }
+    return sign | ((uint32_t)(e + 127 - 15) << 23) | (m << 13);
+}
+
+// Float bits to fp16, rounded to nearest even, with fp16 denormals
+static inline uint16_t f32_to_f16_bits(uint32_t u) {
+    uint16_t sign = (u >> 16) & 0x8000;
+    int16_t fe = (u >> 23) & 0xFF;
+    uint32_t m = u & 0x7FFFFF;
+    if (fe == 0xFF) return sign | 0x7C00 | (m ? 0x200 | (uint16_t)(m >> 13) : 0); // inf, quiet NaN
+    int16_t e = fe - 127 + 15;
+    if (e >= 31) return sign | 0x7C00;
+    if (e < -10) return sign;
+    // Keep the top 11 bits of the significand, fewer for denormal results
+    m |= 0x800000;
+    uint8_t s = e > 0 ? 13 : 14 - e;
+    uint32_t h = m >> s, rem = m & (((uint32_t)1 << s) - 1), half = (uint32_t)1 << (s - 1);
+    // The implicit bit lands in the exponent field, so a rounding carry bumps the exponent
+    if (e > 0) h += (uint32_t)(e - 1) << 10;
+    if (rem > half || (rem == half && (h & 1))) h++;
+    return sign | (uint16_t)h;
+}
+
+static inline uint16_t f32_to_bf16_bits(uint32_t u) {
+    if ((u & 0x7FFFFFFF) > 0x7F800000) return (uint16_t)(u >> 16) | 0x40; // quiet NaN
+    return (uint16_t)((u + 0x7FFF + ((u >> 16) & 1)) >> 16);
+}
+
+// Float bits to Q16.16 truncated toward zero, saturating; NaN gives 0
+static inline int32_t f32_to_q16_sat(uint32_t u) {
+    int32_t v;
+    if (f32_to_q16(u, &v)) return v;
+    if ((u & 0x7FFFFFFF) > 0x7F800000) return 0;
+    return (u >> 31) ? -(int32_t)0x7FFFFFFF - 1 : (int32_t)0x7FFFFFFF;
+}
+
+// q16_to_f32 with the truncated bits folded into the lowest mantissa bit (round to odd), so
+// rounding that again to 16 bits is the correctly rounded result
+static inline uint32_t q16_to_f32_odd(int32_t v) {
+    uint32_t r = q16_to_f32(v);
+    uint32_t a = v < 0 ? (uint32_t)0 - (uint32_t)v : (uint32_t)v;
+    int16_t lost = (int16_t)((r >> 23) & 0xFF) - 127 + 16 - 23; // bits below the 24-bit mantissa
+    if (lost > 0 && (a & (((uint32_t)1 << lost) - 1))) r |= 1;
+    return r;
+}
+
+float fast_f16_to_f32(uint16_t h) {
+    float_conv c;
+    c.u = f16_to_f32_bits(h);
+    return c.f;
+}
+
+uint16_t fast_f32_to_f16(float f) {
+    float_conv c;
+    c.f = f;
+    return f32_to_f16_bits(c.u);
+}
+
+float fast_bf16_to_f32(uint16_t h) {
+    float_conv c;
+    c.u = (uint32_t)h << 16;
+    return c.f;
+}
+
+uint16_t fast_f32_to_bf16(float f) {
+    float_conv c;
+    c.f = f;
+    return f32_to_bf16_bits(c.u);
+}
+
+void fast_f16_to_f32_array(const uint16_t *in, float *out, uint16_t n) {
+    float_conv c;
+    while (n--) {
+        c.u = f16_to_f32_bits(*in++);
+        *out++ = c.f;
+    }
+}
+
+void fast_f32_to_f16_array(const float *in, uint16_t *out, uint16_t n) {
+    float_conv c;
+    while (n--) {
+        c.f = *in++;
+        *out++ = f32_to_f16_bits(c.u);
+    }
+}
+
+void fast_bf16_to_f32_array(const uint16_t *in, float *out, uint16_t n) {
+    float_conv c;
+    while (n--) {
+        c.u = (uint32_t)*in++ << 16;
+        *out++ = c.f;
+    }
+}
+
+void fast_f32_to_bf16_array(const float *in, uint16_t *out, uint16_t n) {
+    float_conv c;
+    while (n--) {
+        c.f = *in++;
+        *out++ = f32_to_bf16_bits(c.u);
+    }
+}
+
+// Through the float encoding: fp16 -> float is exact, so there is a single rounding
+void fast_f16_to_bf16_array(const uint16_t *in, uint16_t *out, uint16_t n) {
+    while (n--) *out++ = f32_to_bf16_bits(f16_to_f32_bits(*in++));
+}
+
+void fast_bf16_to_f16_array(const uint16_t *in, uint16_t *out, uint16_t n) {
+    while (n--) *out++ = f32_to_f16_bits((uint32_t)*in++ << 16);
+}
+
+void fast_f16_to_q16_array(const uint16_t *in, int32_t *out, uint16_t n) {
+    while (n--) *out++ = f32_to_q16_sat(f16_to_f32_bits(*in++));
+}
+
+void fast_q16_to_f16_array(const int32_t *in, uint16_t *out, uint16_t n) {
+    while (n--) *out++ = f32_to_f16_bits(q16_to_f32_odd(*in++));
+}
+
+void fast_bf16_to_q16_array(const uint16_t *in, int32_t *out, uint16_t n) {
+    while (n--) *out++ = f32_to_q16_sat((uint32_t)*in++ << 16);
+}
+
+void fast_q16_to_bf16_array(const int32_t *in, uint16_t *out, uint16_t n) {
+    while (n--) *out++ = f32_to_bf16_bits(q16_to_f32_odd(*in++));
+}
+
+void fast_f32_to_q16_array(const float *in, int32_t *out, uint16_t n) {
+    float_conv c;
+    while (n--) {
+        c.f = *in++;
+        *out++ = f32_to_q16_sat(c.u);
+    }
+}
+
+// Truncates below the 24-bit mantissa, like q16_to_f32
+void fast_q16_to_f32_array(const int32_t *in, float *out, uint16_t n) {
+    float_conv c;
+    while (n--) {
+        c.u = q16_to_f32(*in++);
+        *out++ = c.f;
+    }
+}
+
+#ifdef BTM64_BITS
+/*
+ * Double precision: the same table scheme on the top BTM64_BITS of the 52-bit mantissa,
+ * with Q32 log fractions and Q32 exp2 mantissas. Meant for host tools that replay the
+ * device's approximate arithmetic on large data sets, so the tables are plain arrays.
+ */
+#if BTM64_BITS > 24 || BTM64_TO_COUNT < 1 || BTM64_TO_COUNT > 3
+#error "the double-precision tables support up to 24 input bits and 1 to 3 offset tables"
+#endif
+
+typedef union {
+    double d;
+    uint64_t u;
+} double_conv;
+
+#define BTM64_TO_INDEX(idx, n) \
+    ((((idx) >> (BTM64_BITS - BTM64_TO##n##_SEG_BITS)) << BTM64_TO##n##_SLICE_BITS) | \
+     (((idx) >> BTM64_TO##n##_SLICE_SHIFT) & ((1L << BTM64_TO##n##_SLICE_BITS) - 1)))
+
+static inline uint32_t btm64_lookup(uint32_t idx, const uint32_t *t1, const int32_t *t2,
+                                    const int32_t *t3, const int32_t *t4) {
+    int64_t res = (int64_t)t1[idx >> (BTM64_BITS - BTM64_TIV_BITS)] + t2[BTM64_TO_INDEX(idx, 1)];
+#if BTM64_TO_COUNT >= 2
+    res += t3[BTM64_TO_INDEX(idx, 2)];
+#endif
+#if BTM64_TO_COUNT >= 3
+    res += t4[BTM64_TO_INDEX(idx, 3)];
+#endif
+    (void)t3;
+    (void)t4;
+    if (res < 0) return 0;
+    if (res > 0xFFFFFFFFLL) return 0xFFFFFFFFUL;
+    return (uint32_t)res;
+}
+
+#if BTM64_TO_COUNT >= 3
+#define BTM64_LOG2_TABLES log2_d1, log2_d2, log2_d3, log2_d4
+#define BTM64_EXP2_TABLES exp2_d1, exp2_d2, exp2_d3, exp2_d4
+#elif BTM64_TO_COUNT == 2
+#define BTM64_LOG2_TABLES log2_d1, log2_d2, log2_d3, 0
+#define BTM64_EXP2_TABLES exp2_d1, exp2_d2, exp2_d3, 0
+#else
+#define BTM64_LOG2_TABLES log2_d1, log2_d2, 0, 0
+#define BTM64_EXP2_TABLES exp2_d1, exp2_d2, 0, 0
+#endif
+
+#define F64_MANT_MASK 0xFFFFFFFFFFFFFULL
+#define F64_ABS_MASK 0x7FFFFFFFFFFFFFFFULL
+#define F64_SIGN 0x8000000000000000ULL
+#define F64_INF 0x7FF0000000000000ULL
+
+static inline uint32_t btm64_log2(uint64_t mantissa_bits) {
+    return btm64_lookup((uint32_t)(mantissa_bits >> (52 - BTM64_BITS)), BTM64_LOG2_TABLES);
+}
+
+// Q32 fraction to the 52-bit mantissa field
+static inline uint64_t btm64_exp2(uint32_t log_frac) {
+    return (uint64_t)btm64_lookup(log_frac >> (32 - BTM64_BITS), BTM64_EXP2_TABLES) << 20;
+}
+
+static inline uint64_t btm64_mul_bits(uint64_t ua, uint64_t ub, uint32_t lb) {
+    if ((ua & F64_ABS_MASK) == 0 || (ub & F64_ABS_MASK) == 0) return 0;
+    uint64_t sr = (ua ^ ub) & F64_SIGN;
+    int32_t ea = (int32_t)((ua >> 52) & 0x7FF), eb = (int32_t)((ub >> 52) & 0x7FF);
+    uint64_t lsum = (uint64_t)btm64_log2(ua & F64_MANT_MASK) + lb;
+    int32_t er = ea + eb - 1023 + (int32_t)(lsum >> 32);
+    if (er <= 0) return 0;
+    if (er >= 2047) return sr | F64_INF;
+    return sr | ((uint64_t)er << 52) | btm64_exp2((uint32_t)lsum);
+}
+
+static inline uint64_t btm64_div_bits(uint64_t ua, uint64_t ub, uint32_t lb) {
+    if ((ua & F64_ABS_MASK) == 0) return 0;
+    uint64_t sr = (ua ^ ub) & F64_SIGN;
+    if ((ub & F64_ABS_MASK) == 0) return sr | F64_INF;
+    int32_t ea = (int32_t)((ua >> 52) & 0x7FF), eb = (int32_t)((ub >> 52) & 0x7FF);
+    // la - lb + 2^32: bit 32 clear means a borrow
+    uint64_t ldiff = (uint64_t)btm64_log2(ua & F64_MANT_MASK) - lb + 0x100000000ULL;
+    int32_t er = ea - eb + 1022 + (int32_t)(ldiff >> 32);
+    if (er <= 0) return 0;
+    if (er >= 2047) return sr | F64_INF;
+    return sr | ((uint64_t)er << 52) | btm64_exp2((uint32_t)ldiff);
+}
+
+double fast_mul_f64(double a, double b) {
+    double_conv ca, cb, cr;
+    ca.d = a;
+    cb.d = b;
+    cr.u = btm64_mul_bits(ca.u, cb.u, btm64_log2(cb.u & F64_MANT_MASK));
+    return cr.d;
+}
+
+double fast_div_f64(double a, double b) {
+    double_conv ca, cb, cr;
+    ca.d = a;
+    cb.d = b;
+    cr.u = btm64_div_bits(ca.u, cb.u, btm64_log2(cb.u & F64_MANT_MASK));
+    return cr.d;
+}
+
+void fast_mul_f64_array(const double *a, const double *b, double *out, uint32_t n) {
+    double_conv ca, cb, cr;
+    while (n--) {
+        ca.d = *a++;
+        cb.d = *b++;
+        cr.u = btm64_mul_bits(ca.u, cb.u, btm64_log2(cb.u & F64_MANT_MASK));
+        *out++ = cr.d;
+    }
+}
+
+void fast_div_f64_array(const double *a, const double *b, double *out, uint32_t n) {
+    double_conv ca, cb, cr;
+    while (n--) {
+        ca.d = *a++;
+        cb.d = *b++;
+        cr.u = btm64_div_bits(ca.u, cb.u, btm64_log2(cb.u & F64_MANT_MASK));
+        *out++ = cr.d;
+    }
+}
+#endif
+
+#if defined(__AVX2__) && !defined(__AVR__)
+#include <immintrin.h>
+#include <pthread.h>
+#define FAST_FLOAT_AVX2 1
+
+// Tables widened to int32 so that _mm256_i32gather_epi32 never reads past their ends
+#define BTM_MAX(a, b) ((a) > (b) ? (a) : (b))
+#if BTM_TO_COUNT >= 3
+#define BTM_WIDE_SIZE BTM_MAX(BTM_MAX(BTM_TIV_SIZE, BTM_TO1_SIZE), BTM_MAX(BTM_TO2_SIZE, BTM_TO3_SIZE))
+#elif BTM_TO_COUNT == 2
+#define BTM_WIDE_SIZE BTM_MAX(BTM_MAX(BTM_TIV_SIZE, BTM_TO1_SIZE), BTM_TO2_SIZE)
+#else
+#define BTM_WIDE_SIZE BTM_MAX(BTM_TIV_SIZE, BTM_TO1_SIZE)
+#endif
+static int32_t wide_log2[BTM_TO_COUNT + 1][BTM_WIDE_SIZE];
+static int32_t wide_exp2[BTM_TO_COUNT + 1][BTM_WIDE_SIZE];
+static pthread_once_t wide_once = PTHREAD_ONCE_INIT;
+
+static void btm_widen(int32_t *dst, const void *src, int n, int is_signed) {
+    for (int i = 0; i < n; i++) dst[i] = is_signed ? ((const int16_t *)src)[i] : ((const uint16_t *)src)[i];
+}
+
+static void btm_wide_fill(void) {
+    btm_widen(wide_log2[0], log2_t1, BTM_TIV_SIZE, 0);
+    btm_widen(wide_exp2[0], exp2_t1, BTM_TIV_SIZE, 0);
+    btm_widen(wide_log2[1], log2_t2, BTM_TO1_SIZE, 1);
+    btm_widen(wide_exp2[1], exp2_t2, BTM_TO1_SIZE, 1);
+#if BTM_TO_COUNT >= 2
+    btm_widen(wide_log2[2], log2_t3, BTM_TO2_SIZE, 1);
+    btm_widen(wide_exp2[2], exp2_t3, BTM_TO2_SIZE, 1);
+#endif
+#if BTM_TO_COUNT >= 3
+    btm_widen(wide_log2[3], log2_t4, BTM_TO3_SIZE, 1);
+    btm_widen(wide_exp2[3], exp2_t4, BTM_TO3_SIZE, 1);
+#endif
+}
+
+// First array call from any thread fills the tables; the others wait until they are complete
+static void btm_wide_init(void) {
+    pthread_once(&wide_once, btm_wide_fill);
+}
+
+#define BTM_TO_INDEX8(idx, n) \
+    _mm256_or_si256(_mm256_slli_epi32(_mm256_srli_epi32(idx, BTM_BITS - BTM_TO##n##_SEG_BITS), BTM_TO##n##_SLICE_BITS), \
+                    _mm256_and_si256(_mm256_srli_epi32(idx, BTM_TO##n##_SLICE_SHIFT), \
+                                     _mm256_set1_epi32((1 << BTM_TO##n##_SLICE_BITS) - 1)))
+
+// Eight btm_log2 / btm_exp2 lookups; idx holds the BTM_BITS index bits
+static inline __m256i btm_lookup8(__m256i idx, int32_t (*t)[BTM_WIDE_SIZE]) {
+    __m256i r = _mm256_add_epi32(_mm256_i32gather_epi32((const int *)t[0], _mm256_srli_epi32(idx, BTM_BITS - BTM_TIV_BITS), 4),
+                                 _mm256_i32gather_epi32((const int *)t[1], BTM_TO_INDEX8(idx, 1), 4));
+#if BTM_TO_COUNT >= 2
+    r = _mm256_add_epi32(r, _mm256_i32gather_epi32((const int *)t[2], BTM_TO_INDEX8(idx, 2), 4));
+#endif
+#if BTM_TO_COUNT >= 3
+    r = _mm256_add_epi32(r, _mm256_i32gather_epi32((const int *)t[3], BTM_TO_INDEX8(idx, 3), 4));
+#endif
+    return _mm256_min_epi32(_mm256_max_epi32(r, _mm256_setzero_si256()), _mm256_set1_epi32(65535));
+}
+
+static inline __m256i btm_log2_8(__m256i u) {
+    return btm_lookup8(_mm256_srli_epi32(_mm256_and_si256(u, _mm256_set1_epi32(0x7FFFFF)), 23 - BTM_BITS), wide_log2);
+}
+
+// Pack sign / exponent / log fraction into floats with the scalar overflow and underflow rules
+static inline __m256i btm_pack8(__m256i sr, __m256i er, __m256i lfrac, __m256i zero) {
+    __m256i mr = _mm256_slli_epi32(btm_lookup8(_mm256_srli_epi32(lfrac, 16 - BTM_BITS), wide_exp2), 7);
+    __m256i r = _mm256_or_si256(sr, _mm256_or_si256(_mm256_slli_epi32(er, 23), mr));
+    __m256i inf = _mm256_cmpgt_epi32(er, _mm256_set1_epi32(254));
+    r = _mm256_blendv_epi8(r, _mm256_or_si256(sr, _mm256_set1_epi32(0x7F800000)), inf);
+    __m256i under = _mm256_cmpgt_epi32(_mm256_set1_epi32(1), er);
+    return _mm256_andnot_si256(_mm256_or_si256(under, zero), r);
+}
+
+static inline __m256i btm_mul8(__m256i ua, __m256i ub, __m256i lb) {
+    const __m256i abs_mask = _mm256_set1_epi32(0x7FFFFFFF);
+    __m256i zero = _mm256_or_si256(_mm256_cmpeq_epi32(_mm256_and_si256(ua, abs_mask), _mm256_setzero_si256()),
+                                   _mm256_cmpeq_epi32(_mm256_and_si256(ub, abs_mask), _mm256_setzero_si256()));
+    __m256i sr = _mm256_andnot_si256(abs_mask, _mm256_xor_si256(ua, ub));
+    __m256i ea = _mm256_and_si256(_mm256_srli_epi32(ua, 23), _mm256_set1_epi32(0xFF));
+    __m256i eb = _mm256_and_si256(_mm256_srli_epi32(ub, 23), _mm256_set1_epi32(0xFF));
+    __m256i lsum = _mm256_add_epi32(btm_log2_8(ua), lb);
+    __m256i er = _mm256_add_epi32(_mm256_sub_epi32(_mm256_add_epi32(ea, eb), _mm256_set1_epi32(127)),
+                                  _mm256_srli_epi32(lsum, 16));
+    return btm_pack8(sr, er, _mm256_and_si256(lsum, _mm256_set1_epi32(0xFFFF)), zero);
+}
+
+static inline __m256i btm_div8(__m256i ua, __m256i ub, __m256i lb) {
+    const __m256i abs_mask = _mm256_set1_epi32(0x7FFFFFFF);
+    __m256i a_zero = _mm256_cmpeq_epi32(_mm256_and_si256(ua, abs_mask), _mm256_setzero_si256());
+    __m256i b_zero = _mm256_cmpeq_epi32(_mm256_and_si256(ub, abs_mask), _mm256_setzero_si256());
+    __m256i sr = _mm256_andnot_si256(abs_mask, _mm256_xor_si256(ua, ub));
+    __m256i ea = _mm256_and_si256(_mm256_srli_epi32(ua, 23), _mm256_set1_epi32(0xFF));
+    __m256i eb = _mm256_and_si256(_mm256_srli_epi32(ub, 23), _mm256_set1_epi32(0xFF));
+    // la - lb + 65536: bit 16 clear means a borrow
+    __m256i ldiff = _mm256_add_epi32(_mm256_sub_epi32(btm_log2_8(ua), lb), _mm256_set1_epi32(65536));
+    __m256i er = _mm256_add_epi32(_mm256_sub_epi32(ea, eb), _mm256_set1_epi32(126));
+    er = _mm256_add_epi32(er, _mm256_srli_epi32(ldiff, 16));
+    __m256i r = btm_pack8(sr, er, _mm256_and_si256(ldiff, _mm256_set1_epi32(0xFFFF)), a_zero);
+    __m256i inf = _mm256_andnot_si256(a_zero, b_zero);
+    return _mm256_blendv_epi8(r, _mm256_or_si256(sr, _mm256_set1_epi32(0x7F800000)), inf);
+}
+#endif
+
+/*
+ * Array kernels: out[i] = a[i] op b[i] (or a[i] * s), bit-identical to the scalar functions.
+ * out may alias a or b. With FAST_FLOAT_AVX2 the table lookups are done eight at a time
+ * with gathers; elsewhere the loops walk plain pointers so that avr-gcc keeps them in the
+ * X/Y/Z registers across iterations.
+ */
+void fast_mul_f32_array(const float *a, const float *b, float *out, uint16_t n) {
+#ifdef FAST_FLOAT_AVX2
+    btm_wide_init();
+    for (; n >= 8; n -= 8, a += 8, b += 8, out += 8) {
+        __m256i ua = _mm256_loadu_si256((const __m256i *)a);
+        __m256i ub = _mm256_loadu_si256((const __m256i *)b);
+        _mm256_storeu_si256((__m256i *)out, btm_mul8(ua, ub, btm_log2_8(ub)));
+    }
+#endif
+    float_conv ca, cb, cr;
+    while (n--) {
+        ca.f = *a++;
+        cb.f = *b++;
+        cr.u = btm_mul_bits(ca.u, cb.u, btm_log2(cb.u & 0x7FFFFF));
+        *out++ = cr.f;
+    }
+}
+
+void fast_div_f32_array(const float *a, const float *b, float *out, uint16_t n) {
+#ifdef FAST_FLOAT_AVX2
+    btm_wide_init();
+    for (; n >= 8; n -= 8, a += 8, b += 8, out += 8) {
+        __m256i ua = _mm256_loadu_si256((const __m256i *)a);
+        __m256i ub = _mm256_loadu_si256((const __m256i *)b);
+        _mm256_storeu_si256((__m256i *)out, btm_div8(ua, ub, btm_log2_8(ub)));
+    }
+#endif
+    float_conv ca, cb, cr;
+    while (n--) {
+        ca.f = *a++;
+        cb.f = *b++;
+        cr.u = btm_div_bits(ca.u, cb.u, btm_log2(cb.u & 0x7FFFFF));
+        *out++ = cr.f;
+    }
+}
+
+// The log of s is looked up once, so each element costs one log2 and one exp2 lookup
+void fast_scale_f32_array(const float *a, float s, float *out, uint16_t n) {
+    float_conv ca, cs, cr;
+    cs.f = s;
+    uint16_t ls = btm_log2(cs.u & 0x7FFFFF);
+#ifdef FAST_FLOAT_AVX2
+    btm_wide_init();
+    __m256i us = _mm256_set1_epi32((int)cs.u), ls8 = _mm256_set1_epi32(ls);
+    for (; n >= 8; n -= 8, a += 8, out += 8) {
+        __m256i ua = _mm256_loadu_si256((const __m256i *)a);
+        _mm256_storeu_si256((__m256i *)out, btm_mul8(ua, us, ls8));
+    }
+#endif
+    while (n--) {
+        ca.f = *a++;
+        cr.u = btm_mul_bits(ca.u, cs.u, ls);
+        *out++ = cr.f;
+    }
+}
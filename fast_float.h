@@ -13,19 +13,124 @@ extern "C" {
 #define PROGMEM
 #endif
 
-// BTM configuration: n1=4, n2=5, n3=5
-// Total index bits = 14
-// Table 1: 512 entries
-// Table 2: 512 entries
-extern const uint16_t PROGMEM log2_t1[512];
-extern const int16_t PROGMEM log2_t2[512];
+// Table split, from generate_tables.py --gen-float --float-dir: a fast_float_config.h on the
+// include path overrides the default bipartite split (n1=4, n2=5, n3=5).
+// BTM_BITS mantissa bits index the tables: the top BTM_TIV_BITS select the initial value
+// (table t1); offset table t<n+1> is indexed by the top BTM_TO<n>_SEG_BITS bits and the
+// BTM_TO<n>_SLICE_BITS bits at BTM_TO<n>_SLICE_SHIFT. Up to three offset tables.
+#if defined(__has_include)
+#if __has_include("fast_float_config.h")
+#include "fast_float_config.h"
+#endif
+#endif
 
-extern const uint16_t PROGMEM exp2_t1[512];
-extern const int16_t PROGMEM exp2_t2[512];
+#ifndef BTM_BITS
+#define BTM_BITS 14
+#define BTM_TIV_BITS 9
+#define BTM_TO_COUNT 1
+#define BTM_TO1_SEG_BITS 4
+#define BTM_TO1_SLICE_BITS 5
+#define BTM_TO1_SLICE_SHIFT 0
+#endif
+
+#define BTM_TIV_SIZE (1 << BTM_TIV_BITS)
+#define BTM_TO1_SIZE (1 << (BTM_TO1_SEG_BITS + BTM_TO1_SLICE_BITS))
+
+extern const uint16_t PROGMEM log2_t1[BTM_TIV_SIZE];
+extern const int16_t PROGMEM log2_t2[BTM_TO1_SIZE];
+extern const uint16_t PROGMEM exp2_t1[BTM_TIV_SIZE];
+extern const int16_t PROGMEM exp2_t2[BTM_TO1_SIZE];
+#if BTM_TO_COUNT >= 2
+#define BTM_TO2_SIZE (1 << (BTM_TO2_SEG_BITS + BTM_TO2_SLICE_BITS))
+extern const int16_t PROGMEM log2_t3[BTM_TO2_SIZE];
+extern const int16_t PROGMEM exp2_t3[BTM_TO2_SIZE];
+#endif
+#if BTM_TO_COUNT >= 3
+#define BTM_TO3_SIZE (1 << (BTM_TO3_SEG_BITS + BTM_TO3_SLICE_BITS))
+extern const int16_t PROGMEM log2_t4[BTM_TO3_SIZE];
+extern const int16_t PROGMEM exp2_t4[BTM_TO3_SIZE];
+#endif
+
+// Double-precision variant for host tooling, built when the config written by
+// generate_tables.py --gen-float64 defines BTM64_BITS; link its fast_float64_tables.cpp.
+// Same scheme with BTM64_BITS (up to 24) mantissa bits in and Q32 table entries: about
+// 20 bits of precision with the default split, against ~14 for the float tables.
+#ifdef BTM64_BITS
+#define BTM64_TIV_SIZE (1L << BTM64_TIV_BITS)
+#define BTM64_TO1_SIZE (1L << (BTM64_TO1_SEG_BITS + BTM64_TO1_SLICE_BITS))
+extern const uint32_t PROGMEM log2_d1[BTM64_TIV_SIZE];
+extern const int32_t PROGMEM log2_d2[BTM64_TO1_SIZE];
+extern const uint32_t PROGMEM exp2_d1[BTM64_TIV_SIZE];
+extern const int32_t PROGMEM exp2_d2[BTM64_TO1_SIZE];
+#if BTM64_TO_COUNT >= 2
+#define BTM64_TO2_SIZE (1L << (BTM64_TO2_SEG_BITS + BTM64_TO2_SLICE_BITS))
+extern const int32_t PROGMEM log2_d3[BTM64_TO2_SIZE];
+extern const int32_t PROGMEM exp2_d3[BTM64_TO2_SIZE];
+#endif
+#if BTM64_TO_COUNT >= 3
+#define BTM64_TO3_SIZE (1L << (BTM64_TO3_SEG_BITS + BTM64_TO3_SLICE_BITS))
+extern const int32_t PROGMEM log2_d4[BTM64_TO3_SIZE];
+extern const int32_t PROGMEM exp2_d4[BTM64_TO3_SIZE];
+#endif
+
+double fast_mul_f64(double a, double b);
+double fast_div_f64(double a, double b);
+void fast_mul_f64_array(const double *a, const double *b, double *out, uint32_t n);
+void fast_div_f64_array(const double *a, const double *b, double *out, uint32_t n);
+#endif
 
 float fast_mul_f32(float a, float b);
 float fast_div_f32(float a, float b);
 
+// log2 / exp2 / sqrt / rsqrt / pow on the same tables (relative error around 1e-4).
+// fast_pow_f32 is for x > 0 and |y| < 32768.
+float fast_log2_f32(float x);
+float fast_exp2_f32(float x);
+float fast_sqrt_f32(float x);
+float fast_rsqrt_f32(float x);
+float fast_pow_f32(float x, float y);
+
+// sum(a[i] * b[i]) and y[i] += a * x[i] without a float addition: products stay as an
+// exponent and a 24-bit mantissa and are summed in a 32-bit block-exponent accumulator, so
+// only the result is rounded to a float. Inputs are assumed finite; denormals count as zero.
+float fast_dot_f32(const float *a, const float *b, uint16_t n);
+void fast_axpy_f32(float a, const float *x, float *y, uint16_t n);
+
+// IEEE binary16 (fp16) and bfloat16 values are passed as their raw 16-bit encodings.
+// Multiply and divide work on the encodings directly: the 10- or 7-bit mantissa indexes the
+// same log2/exp2 tables at exact points and the result is rounded to the nearest encoding,
+// including denormal results. Denormal inputs are treated as zero. Infinities and NaN follow
+// IEEE: a NaN operand is returned quieted, inf * 0 and inf / inf give NaN, x / inf gives 0.
+uint16_t fast_mul_f16(uint16_t a, uint16_t b);
+uint16_t fast_div_f16(uint16_t a, uint16_t b);
+uint16_t fast_mul_bf16(uint16_t a, uint16_t b);
+uint16_t fast_div_bf16(uint16_t a, uint16_t b);
+
+// Conversions, integer-only. Narrowing rounds to nearest even and keeps infinities and NaN;
+// Q16.16 results truncate toward zero and saturate.
+float fast_f16_to_f32(uint16_t h);
+uint16_t fast_f32_to_f16(float f);
+float fast_bf16_to_f32(uint16_t h);
+uint16_t fast_f32_to_bf16(float f);
+void fast_f16_to_f32_array(const uint16_t *in, float *out, uint16_t n);
+void fast_f32_to_f16_array(const float *in, uint16_t *out, uint16_t n);
+void fast_bf16_to_f32_array(const uint16_t *in, float *out, uint16_t n);
+void fast_f32_to_bf16_array(const float *in, uint16_t *out, uint16_t n);
+void fast_f16_to_bf16_array(const uint16_t *in, uint16_t *out, uint16_t n);
+void fast_bf16_to_f16_array(const uint16_t *in, uint16_t *out, uint16_t n);
+void fast_f16_to_q16_array(const uint16_t *in, int32_t *out, uint16_t n);
+void fast_q16_to_f16_array(const int32_t *in, uint16_t *out, uint16_t n);
+void fast_bf16_to_q16_array(const uint16_t *in, int32_t *out, uint16_t n);
+void fast_q16_to_bf16_array(const int32_t *in, uint16_t *out, uint16_t n);
+void fast_f32_to_q16_array(const float *in, int32_t *out, uint16_t n);
+void fast_q16_to_f32_array(const int32_t *in, float *out, uint16_t n);
+
+// Element-wise kernels, same results as the scalar functions; out may alias an input.
+// Built with AVX2 enabled (e.g. -march=native on x86), the lookups use gathers.
+void fast_mul_f32_array(const float *a, const float *b, float *out, uint16_t n);
+void fast_div_f32_array(const float *a, const float *b, float *out, uint16_t n);
+void fast_scale_f32_array(const float *a, float s, float *out, uint16_t n);
+
 #ifdef __cplusplus
 }
 #endif
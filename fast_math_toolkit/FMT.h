@@ -20,8 +20,17 @@
 #include "FMT_Fixed.h"
 #include "FMT_Trig.h"
 #include "FMT_3d.h"
+#include "FMT_3d16.h"
 #include "FMT_Utils.h"
 #include "FMT_Ring.h"
+#include "FMT_Batch.h"
+#include "FMT_Raster.h"
+#include "FMT_Cull.h"
+#include "FMT_Light.h"
+#include "FMT_Ray.h"
+#include "FMT_SDF.h"
+#include "FMT_Mesh.h"
+#include "FMT_Wire.h"
 
 // C-compatible API
 #ifdef __cplusplus
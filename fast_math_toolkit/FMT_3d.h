@@ -26,6 +26,11 @@ typedef struct {
     int32_t x, y, z, w;
 } Vec4;
 
+// Affine 3x4 matrix: Mat4 without the constant [0 0 0 1] bottom row
+typedef struct {
+    int32_t m[3][4];
+} Mat34;
+
 static inline Vec3 vec3_init(int32_t x, int32_t y, int32_t z) {
     Vec3 v = {x, y, z};
     return v;
@@ -83,6 +88,36 @@ static inline int32_t vec3_dist(Vec3 a, Vec3 b) {
     return vec3_length(vec3_sub(a, b));
 }
 
+// sqrt(x^2 + y^2) in the log domain: LogSumExp of 2*log|x| and 2*log|y|, then halved.
+// Scale-free, so the result has the same Q format as the inputs.
+static inline uint32_t hypot2(int32_t x, int32_t y) {
+    uint32_t ux = (x < 0) ? -(uint32_t)x : (uint32_t)x;
+    uint32_t uy = (y < 0) ? -(uint32_t)y : (uint32_t)y;
+    if (!ux) return uy;
+    if (!uy) return ux;
+    int32_t l2 = log2_add_q8(log2_q8(ux) << 1, log2_q8(uy) << 1);
+    return exp2_q8(l2 >> 1);
+}
+
+static inline uint32_t hypot3(int32_t x, int32_t y, int32_t z) {
+    uint32_t uz = (z < 0) ? -(uint32_t)z : (uint32_t)z;
+    if (!uz) return hypot2(x, y);
+    uint32_t ux = (x < 0) ? -(uint32_t)x : (uint32_t)x;
+    uint32_t uy = (y < 0) ? -(uint32_t)y : (uint32_t)y;
+    int32_t l2 = log2_q8(uz) << 1;
+    if (ux) l2 = log2_add_q8(l2, log2_q8(ux) << 1);
+    if (uy) l2 = log2_add_q8(l2, log2_q8(uy) << 1);
+    return exp2_q8(l2 >> 1);
+}
+
+static inline int32_t vec3_length_ap(Vec3 v) {
+    return (int32_t)hypot3(v.x, v.y, v.z);
+}
+
+static inline int32_t vec3_dist_ap(Vec3 a, Vec3 b) {
+    return vec3_length_ap(vec3_sub(a, b));
+}
+
 static inline Vec3 mat3_mul_vec(const Mat3 *M, Vec3 v) {
     int32_t x = v.x, y = v.y, z = v.z;
     Vec3 r;
@@ -249,6 +284,129 @@ static inline Mat4 mat4_inverse_affine_rot(const Mat4 *M) {
     return R;
 }
 
+// Fills the top 3x4 rows shared by Mat4 and Mat34 model matrices
+static inline void model_rows(int32_t (*m)[4], int32_t scale, uint16_t ax, uint16_t ay, uint16_t az, Vec3 trans) {
+    Mat3 R = mat3_rotation_euler(ax, ay, az);
+    for (int i = 0; i < 3; i++) {
+        m[i][0] = q16_mul_s(R.m[i][0], scale);
+        m[i][1] = q16_mul_s(R.m[i][1], scale);
+        m[i][2] = q16_mul_s(R.m[i][2], scale);
+    }
+    m[0][3] = trans.x; m[1][3] = trans.y; m[2][3] = trans.z;
+}
+
+// Affine model matrix: translation * rotation(ZYX) * uniform scale, scale folded into the rotation columns
+static inline Mat4 mat4_model(int32_t scale, uint16_t ax, uint16_t ay, uint16_t az, Vec3 trans) {
+    Mat4 r;
+    model_rows(r.m, scale, ax, ay, az, trans);
+    r.m[3][0] = 0; r.m[3][1] = 0; r.m[3][2] = 0; r.m[3][3] = Q16_ONE;
+    return r;
+}
+
+static inline Mat34 mat34_identity() {
+    Mat34 r;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 4; j++) {
+            r.m[i][j] = (i == j) ? Q16_ONE : 0;
+        }
+    }
+    return r;
+}
+
+static inline Mat34 mat34_from_mat4(const Mat4 *M) {
+    Mat34 r;
+    for (int i = 0; i < 3; i++) {
+        r.m[i][0] = M->m[i][0]; r.m[i][1] = M->m[i][1]; r.m[i][2] = M->m[i][2]; r.m[i][3] = M->m[i][3];
+    }
+    return r;
+}
+
+static inline Mat4 mat34_to_mat4(const Mat34 *M) {
+    Mat4 r;
+    for (int i = 0; i < 3; i++) {
+        r.m[i][0] = M->m[i][0]; r.m[i][1] = M->m[i][1]; r.m[i][2] = M->m[i][2]; r.m[i][3] = M->m[i][3];
+    }
+    r.m[3][0] = 0; r.m[3][1] = 0; r.m[3][2] = 0; r.m[3][3] = Q16_ONE;
+    return r;
+}
+
+static inline Mat34 mat34_model(int32_t scale, uint16_t ax, uint16_t ay, uint16_t az, Vec3 trans) {
+    Mat34 r;
+    model_rows(r.m, scale, ax, ay, az, trans);
+    return r;
+}
+
+// A * B: 27 MACs instead of the 64 of mat4_mul
+static inline Mat34 mat34_mul(const Mat34 *A, const Mat34 *B) {
+    Mat34 R;
+    for (int i = 0; i < 3; i++) {
+        int32_t a0 = A->m[i][0], a1 = A->m[i][1], a2 = A->m[i][2], a3 = A->m[i][3];
+        R.m[i][0] = (int32_t)(((int64_t)a0 * B->m[0][0] + (int64_t)a1 * B->m[1][0] + (int64_t)a2 * B->m[2][0]) >> Q16_S);
+        R.m[i][1] = (int32_t)(((int64_t)a0 * B->m[0][1] + (int64_t)a1 * B->m[1][1] + (int64_t)a2 * B->m[2][1]) >> Q16_S);
+        R.m[i][2] = (int32_t)(((int64_t)a0 * B->m[0][2] + (int64_t)a1 * B->m[1][2] + (int64_t)a2 * B->m[2][2]) >> Q16_S);
+        R.m[i][3] = (int32_t)(((int64_t)a0 * B->m[0][3] + (int64_t)a1 * B->m[1][3] + (int64_t)a2 * B->m[2][3]) >> Q16_S) + a3;
+    }
+    return R;
+}
+
+static inline Vec3 mat34_mul_point(const Mat34 *M, Vec3 v) {
+    Vec3 r;
+    r.x = (int32_t)(((int64_t)M->m[0][0] * v.x + (int64_t)M->m[0][1] * v.y + (int64_t)M->m[0][2] * v.z) >> Q16_S) + M->m[0][3];
+    r.y = (int32_t)(((int64_t)M->m[1][0] * v.x + (int64_t)M->m[1][1] * v.y + (int64_t)M->m[1][2] * v.z) >> Q16_S) + M->m[1][3];
+    r.z = (int32_t)(((int64_t)M->m[2][0] * v.x + (int64_t)M->m[2][1] * v.y + (int64_t)M->m[2][2] * v.z) >> Q16_S) + M->m[2][3];
+    return r;
+}
+
+// Directions ignore the translation column
+static inline Vec3 mat34_mul_dir(const Mat34 *M, Vec3 v) {
+    Vec3 r;
+    r.x = (int32_t)(((int64_t)M->m[0][0] * v.x + (int64_t)M->m[0][1] * v.y + (int64_t)M->m[0][2] * v.z) >> Q16_S);
+    r.y = (int32_t)(((int64_t)M->m[1][0] * v.x + (int64_t)M->m[1][1] * v.y + (int64_t)M->m[1][2] * v.z) >> Q16_S);
+    r.z = (int32_t)(((int64_t)M->m[2][0] * v.x + (int64_t)M->m[2][1] * v.y + (int64_t)M->m[2][2] * v.z) >> Q16_S);
+    return r;
+}
+
+// Inverse of a rotation + translation matrix, as mat4_inverse_affine_rot
+static inline Mat34 mat34_inverse_rot(const Mat34 *M) {
+    Mat34 R;
+    R.m[0][0] = M->m[0][0]; R.m[0][1] = M->m[1][0]; R.m[0][2] = M->m[2][0];
+    R.m[1][0] = M->m[0][1]; R.m[1][1] = M->m[1][1]; R.m[1][2] = M->m[2][1];
+    R.m[2][0] = M->m[0][2]; R.m[2][1] = M->m[1][2]; R.m[2][2] = M->m[2][2];
+
+    int32_t tx = M->m[0][3], ty = M->m[1][3], tz = M->m[2][3];
+    R.m[0][3] = - (int32_t)(((int64_t)R.m[0][0] * tx + (int64_t)R.m[0][1] * ty + (int64_t)R.m[0][2] * tz) >> Q16_S);
+    R.m[1][3] = - (int32_t)(((int64_t)R.m[1][0] * tx + (int64_t)R.m[1][1] * ty + (int64_t)R.m[1][2] * tz) >> Q16_S);
+    R.m[2][3] = - (int32_t)(((int64_t)R.m[2][0] * tx + (int64_t)R.m[2][1] * ty + (int64_t)R.m[2][2] * tz) >> Q16_S);
+    return R;
+}
+
+// General affine inverse (scale/shear allowed) via the adjugate; one division for 1/det
+static inline Mat34 mat34_inverse(const Mat34 *M) {
+    const int32_t (*a)[4] = M->m;
+    int32_t c00 = (int32_t)(((int64_t)a[1][1] * a[2][2] - (int64_t)a[1][2] * a[2][1]) >> Q16_S);
+    int32_t c01 = (int32_t)(((int64_t)a[1][2] * a[2][0] - (int64_t)a[1][0] * a[2][2]) >> Q16_S);
+    int32_t c02 = (int32_t)(((int64_t)a[1][0] * a[2][1] - (int64_t)a[1][1] * a[2][0]) >> Q16_S);
+    int32_t det = (int32_t)(((int64_t)a[0][0] * c00 + (int64_t)a[0][1] * c01 + (int64_t)a[0][2] * c02) >> Q16_S);
+    int32_t inv_det = q16_div_s(Q16_ONE, det);
+
+    Mat34 R;
+    R.m[0][0] = q16_mul_s(c00, inv_det);
+    R.m[1][0] = q16_mul_s(c01, inv_det);
+    R.m[2][0] = q16_mul_s(c02, inv_det);
+    R.m[0][1] = q16_mul_s((int32_t)(((int64_t)a[0][2] * a[2][1] - (int64_t)a[0][1] * a[2][2]) >> Q16_S), inv_det);
+    R.m[1][1] = q16_mul_s((int32_t)(((int64_t)a[0][0] * a[2][2] - (int64_t)a[0][2] * a[2][0]) >> Q16_S), inv_det);
+    R.m[2][1] = q16_mul_s((int32_t)(((int64_t)a[0][1] * a[2][0] - (int64_t)a[0][0] * a[2][1]) >> Q16_S), inv_det);
+    R.m[0][2] = q16_mul_s((int32_t)(((int64_t)a[0][1] * a[1][2] - (int64_t)a[0][2] * a[1][1]) >> Q16_S), inv_det);
+    R.m[1][2] = q16_mul_s((int32_t)(((int64_t)a[0][2] * a[1][0] - (int64_t)a[0][0] * a[1][2]) >> Q16_S), inv_det);
+    R.m[2][2] = q16_mul_s((int32_t)(((int64_t)a[0][0] * a[1][1] - (int64_t)a[0][1] * a[1][0]) >> Q16_S), inv_det);
+
+    int32_t tx = a[0][3], ty = a[1][3], tz = a[2][3];
+    R.m[0][3] = - (int32_t)(((int64_t)R.m[0][0] * tx + (int64_t)R.m[0][1] * ty + (int64_t)R.m[0][2] * tz) >> Q16_S);
+    R.m[1][3] = - (int32_t)(((int64_t)R.m[1][0] * tx + (int64_t)R.m[1][1] * ty + (int64_t)R.m[1][2] * tz) >> Q16_S);
+    R.m[2][3] = - (int32_t)(((int64_t)R.m[2][0] * tx + (int64_t)R.m[2][1] * ty + (int64_t)R.m[2][2] * tz) >> Q16_S);
+    return R;
+}
+
 static inline Mat4 mat4_perspective(int32_t focal) {
     Mat4 r;
     for(int i=0; i<4; i++) for(int j=0; j<4; j++) r.m[i][j] = 0;
@@ -347,6 +505,84 @@ static inline Vec3 quat_rotate_vec(Quat q, Vec3 v) {
     return vec3_init(res_x, res_y, res_z);
 }
 
+// Unit quaternion to rotation matrix: 9 products once, then 9 MACs per vector with mat3_mul_vec
+static inline Mat3 quat_to_mat3(Quat q) {
+    // Products shifted by Q16_S - 1 carry the factor 2
+    int32_t xx = (int32_t)(((int64_t)q.x * q.x) >> (Q16_S - 1));
+    int32_t yy = (int32_t)(((int64_t)q.y * q.y) >> (Q16_S - 1));
+    int32_t zz = (int32_t)(((int64_t)q.z * q.z) >> (Q16_S - 1));
+    int32_t xy = (int32_t)(((int64_t)q.x * q.y) >> (Q16_S - 1));
+    int32_t xz = (int32_t)(((int64_t)q.x * q.z) >> (Q16_S - 1));
+    int32_t yz = (int32_t)(((int64_t)q.y * q.z) >> (Q16_S - 1));
+    int32_t wx = (int32_t)(((int64_t)q.w * q.x) >> (Q16_S - 1));
+    int32_t wy = (int32_t)(((int64_t)q.w * q.y) >> (Q16_S - 1));
+    int32_t wz = (int32_t)(((int64_t)q.w * q.z) >> (Q16_S - 1));
+
+    Mat3 M;
+    M.m[0][0] = Q16_ONE - yy - zz; M.m[0][1] = xy - wz;           M.m[0][2] = xz + wy;
+    M.m[1][0] = xy + wz;           M.m[1][1] = Q16_ONE - xx - zz; M.m[1][2] = yz - wx;
+    M.m[2][0] = xz - wy;           M.m[2][1] = yz + wx;           M.m[2][2] = Q16_ONE - xx - yy;
+    return M;
+}
+
+static inline void quat_rotate_batch(Quat q, const Vec3 *in, Vec3 *out, uint16_t n) {
+    Mat3 R = quat_to_mat3(q);
+    for (uint16_t i = 0; i < n; i++) out[i] = mat3_mul_vec(&R, in[i]);
+}
+
+/**
+ * Spherical interpolation, t in Q16.16 [0, 1]. The weights sin((1-t)θ)/sin θ and sin(tθ)/sin θ
+ * are log subtractions of sin_log entries, θ comes from acos_u16. Below a few degrees the
+ * table resolution is too coarse and nlerp is both cheaper and closer.
+ */
+static inline Quat quat_slerp(Quat a, Quat b, int32_t t) {
+    int32_t d = (int32_t)(((int64_t)a.w * b.w + (int64_t)a.x * b.x + (int64_t)a.y * b.y + (int64_t)a.z * b.z) >> Q16_S);
+    if (d < 0) {
+        // shortest arc
+        b.w = -b.w; b.x = -b.x; b.y = -b.y; b.z = -b.z;
+        d = -d;
+    }
+    uint16_t theta = acos_u16(d);
+    if (theta < 1024) return quat_nlerp(a, b, t);
+
+#ifdef SIN_TABLE_Q15_SIZE
+    // sin_log truncates to its table step; bias by half a step so the angles round instead
+    const uint16_t half_step = 32768U / SIN_TABLE_Q15_SIZE;
+#else
+    const uint16_t half_step = 0;
+#endif
+    uint16_t ta = (uint16_t)((((uint32_t)theta * (uint32_t)(Q16_ONE - t)) >> Q16_S) + half_step);
+    uint16_t tb = (uint16_t)((((uint32_t)theta * (uint32_t)t) >> Q16_S) + half_step);
+    theta += half_step;
+    Log32 s = sin_log(theta);
+    Log32 la = log32_div(sin_log(ta), s);
+    Log32 lb = log32_div(sin_log(tb), s);
+    // the ratio loses sin_log's Q16.16 offset; put it back
+    if (la.sign) la.lval += (16 << FMT_LOG_Q);
+    if (lb.sign) lb.lval += (16 << FMT_LOG_Q);
+    int32_t wa = from_log32(la), wb = from_log32(lb);
+
+    Quat r;
+    r.w = (int32_t)(((int64_t)a.w * wa + (int64_t)b.w * wb) >> Q16_S);
+    r.x = (int32_t)(((int64_t)a.x * wa + (int64_t)b.x * wb) >> Q16_S);
+    r.y = (int32_t)(((int64_t)a.y * wa + (int64_t)b.y * wb) >> Q16_S);
+    r.z = (int32_t)(((int64_t)a.z * wa + (int64_t)b.z * wb) >> Q16_S);
+    // the 8-bit sine tables leave a small length error
+    return quat_normalize(r);
+}
+
+// First-order update q += dt/2 * (0, omega) * q, omega in rad/s (world frame), dt in seconds
+static inline Quat quat_integrate(Quat q, Vec3 omega, int32_t dt) {
+    int32_t half = dt >> 1;
+    Quat w = {0, q16_mul_s(omega.x, half), q16_mul_s(omega.y, half), q16_mul_s(omega.z, half)};
+    Quat dq = quat_mul_quat(w, q);
+    q.w += dq.w;
+    q.x += dq.x;
+    q.y += dq.y;
+    q.z += dq.z;
+    return quat_normalize(q);
+}
+
 static inline Vec3 pipeline_mvp(Vec3 v_local, int32_t scale,
                                 uint16_t ax, uint16_t ay, uint16_t az,
                                 Vec3 trans, int32_t focal) {
@@ -417,6 +653,86 @@ static inline Vec3 pipeline_mvp_fused(Vec3 v_local, int32_t scale,
     return project_perspective_ap(world, focal);
 }
 
+/**
+ * Scene-graph node caching its local (mat34_model) and world matrices.
+ * Setters only mark the node dirty; transform_world() rebuilds lazily. A child notices a
+ * rebuilt parent through the parent's rev counter, so only changed subtrees are recomputed
+ * and nodes need no child lists.
+ */
+enum {
+    TRANSFORM_LOCAL_DIRTY = 1,
+    TRANSFORM_WORLD_DIRTY = 2
+};
+
+typedef struct Transform {
+    struct Transform *parent;
+    Vec3 trans;
+    int32_t scale;
+    uint16_t ax, ay, az;
+    uint16_t rev;        // bumped each time world is rebuilt
+    uint16_t parent_rev; // parent->rev that world was built from
+    uint8_t dirty;
+    Mat34 local;
+    Mat34 world;
+} Transform;
+
+static inline void transform_init(Transform *t) {
+    t->parent = 0;
+    t->trans = vec3_init(0, 0, 0);
+    t->scale = Q16_ONE;
+    t->ax = 0; t->ay = 0; t->az = 0;
+    t->rev = 0;
+    t->parent_rev = 0;
+    t->dirty = TRANSFORM_LOCAL_DIRTY | TRANSFORM_WORLD_DIRTY;
+}
+
+static inline void transform_set_parent(Transform *t, Transform *parent) {
+    if (t->parent == parent) return;
+    t->parent = parent;
+    t->dirty |= TRANSFORM_WORLD_DIRTY;
+}
+
+static inline void transform_set_translation(Transform *t, Vec3 trans) {
+    if (t->trans.x == trans.x && t->trans.y == trans.y && t->trans.z == trans.z) return;
+    t->trans = trans;
+    t->dirty |= TRANSFORM_LOCAL_DIRTY;
+}
+
+static inline void transform_set_rotation(Transform *t, uint16_t ax, uint16_t ay, uint16_t az) {
+    if (t->ax == ax && t->ay == ay && t->az == az) return;
+    t->ax = ax; t->ay = ay; t->az = az;
+    t->dirty |= TRANSFORM_LOCAL_DIRTY;
+}
+
+static inline void transform_set_scale(Transform *t, int32_t scale) {
+    if (t->scale == scale) return;
+    t->scale = scale;
+    t->dirty |= TRANSFORM_LOCAL_DIRTY;
+}
+
+static inline const Mat34 *transform_world(Transform *t) {
+    const Mat34 *pw = 0;
+    if (t->parent) {
+        pw = transform_world(t->parent);
+        if (t->parent->rev != t->parent_rev) t->dirty |= TRANSFORM_WORLD_DIRTY;
+    }
+    if (t->dirty & TRANSFORM_LOCAL_DIRTY) {
+        t->local = mat34_model(t->scale, t->ax, t->ay, t->az, t->trans);
+        t->dirty |= TRANSFORM_WORLD_DIRTY;
+    }
+    if (t->dirty & TRANSFORM_WORLD_DIRTY) {
+        if (pw) {
+            t->world = mat34_mul(pw, &t->local);
+            t->parent_rev = t->parent->rev;
+        } else {
+            t->world = t->local;
+        }
+        t->rev++;
+    }
+    t->dirty = 0;
+    return &t->world;
+}
+
 } // namespace FMT
 
 #endif
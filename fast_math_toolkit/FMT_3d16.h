@@ -0,0 +1,173 @@
+#ifndef FMT_3D16_H
+#define FMT_3D16_H
+
+#include "FMT_3d.h"
+
+namespace FMT {
+
+/**
+ * Compact Q1.14 types for rotations, unit normals and unit quaternions.
+ *
+ * Every component is an int16_t in [-2, 2), so a Mat3s16 is 18 bytes instead of 36 and a
+ * product with a Q16.16 coordinate takes two 16x16 multiplies (q16_mul_q14) instead of a
+ * 32x32-to-64 one; on AVR that is the difference between the hardware MUL and a libgcc call.
+ * Widening to the Q16.16 types is exact, so s16 -> Q16.16 -> s16 round-trips; narrowing rounds
+ * to the nearest 1/16384 and saturates.
+ */
+
+#define Q14_S 14
+#define Q14_ONE (1 << Q14_S)
+
+typedef struct {
+    int16_t x, y, z;
+} Vec3s16;
+
+typedef struct {
+    int16_t m[3][3];
+} Mat3s16;
+
+typedef struct {
+    int16_t w, x, y, z;
+} Quats16;
+
+static inline int16_t q14_from_q16(int32_t v) {
+    v = (v + 2) >> (Q16_S - Q14_S);
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return (int16_t)v;
+}
+
+static inline int32_t q16_from_q14(int16_t v) {
+    return (int32_t)v * (1 << (Q16_S - Q14_S));
+}
+
+// Q16.16 * Q1.14 -> Q16.16 from two 16x16 products: (hi * b) << 2 + (lo * b) >> 14, exact
+static inline int32_t q16_mul_q14(int32_t a, int16_t b) {
+    int32_t hi = (int16_t)(a >> 16) * (int32_t)b;
+    int32_t lo = (int32_t)(uint16_t)a * b;
+    return (int32_t)((uint32_t)hi << (Q16_S - Q14_S)) + (lo >> Q14_S);
+}
+
+// Q1.14 * Q1.14 -> Q1.14, rounded
+static inline int16_t q14_mul(int16_t a, int16_t b) {
+    return (int16_t)(((int32_t)a * b + (1 << (Q14_S - 1))) >> Q14_S);
+}
+
+static inline Vec3s16 vec3s16_init(int16_t x, int16_t y, int16_t z) {
+    Vec3s16 v = {x, y, z};
+    return v;
+}
+
+static inline Vec3s16 vec3s16_from_vec3(Vec3 v) {
+    return vec3s16_init(q14_from_q16(v.x), q14_from_q16(v.y), q14_from_q16(v.z));
+}
+
+static inline Vec3 vec3_from_vec3s16(Vec3s16 v) {
+    return vec3_init(q16_from_q14(v.x), q16_from_q14(v.y), q16_from_q14(v.z));
+}
+
+static inline Mat3s16 mat3s16_from_mat3(const Mat3 *M) {
+    Mat3s16 R;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) R.m[i][j] = q14_from_q16(M->m[i][j]);
+    }
+    return R;
+}
+
+static inline Mat3 mat3_from_mat3s16(const Mat3s16 *M) {
+    Mat3 R;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) R.m[i][j] = q16_from_q14(M->m[i][j]);
+    }
+    return R;
+}
+
+static inline Quats16 quats16_from_quat(Quat q) {
+    Quats16 r = {q14_from_q16(q.w), q14_from_q16(q.x), q14_from_q16(q.y), q14_from_q16(q.z)};
+    return r;
+}
+
+static inline Quat quat_from_quats16(Quats16 q) {
+    Quat r = {q16_from_q14(q.w), q16_from_q14(q.x), q16_from_q14(q.y), q16_from_q14(q.z)};
+    return r;
+}
+
+// Q1.14 . Q1.14 -> Q1.14 (int32 so non-unit inputs do not wrap)
+static inline int32_t vec3s16_dot(Vec3s16 a, Vec3s16 b) {
+    return ((int32_t)a.x * b.x + (int32_t)a.y * b.y + (int32_t)a.z * b.z + (1 << (Q14_S - 1))) >> Q14_S;
+}
+
+// Q1.14 direction . Q16.16 point -> Q16.16, e.g. a plane test against a compact normal
+static inline int32_t vec3s16_dot_vec3(Vec3s16 n, Vec3 p) {
+    return q16_mul_q14(p.x, n.x) + q16_mul_q14(p.y, n.y) + q16_mul_q14(p.z, n.z);
+}
+
+// Q1.14 rotation times Q16.16 point: 18 16x16 multiplies, no 64-bit arithmetic
+static inline Vec3 mat3s16_mul_vec(const Mat3s16 *M, Vec3 v) {
+    Vec3 r;
+    r.x = q16_mul_q14(v.x, M->m[0][0]) + q16_mul_q14(v.y, M->m[0][1]) + q16_mul_q14(v.z, M->m[0][2]);
+    r.y = q16_mul_q14(v.x, M->m[1][0]) + q16_mul_q14(v.y, M->m[1][1]) + q16_mul_q14(v.z, M->m[1][2]);
+    r.z = q16_mul_q14(v.x, M->m[2][0]) + q16_mul_q14(v.y, M->m[2][1]) + q16_mul_q14(v.z, M->m[2][2]);
+    return r;
+}
+
+// Q1.14 rotation times Q1.14 direction (normals): 9 16x16 multiplies
+static inline Vec3s16 mat3s16_mul_vec_s16(const Mat3s16 *M, Vec3s16 v) {
+    Vec3s16 r;
+    r.x = (int16_t)(((int32_t)M->m[0][0] * v.x + (int32_t)M->m[0][1] * v.y + (int32_t)M->m[0][2] * v.z + (1 << (Q14_S - 1))) >> Q14_S);
+    r.y = (int16_t)(((int32_t)M->m[1][0] * v.x + (int32_t)M->m[1][1] * v.y + (int32_t)M->m[1][2] * v.z + (1 << (Q14_S - 1))) >> Q14_S);
+    r.z = (int16_t)(((int32_t)M->m[2][0] * v.x + (int32_t)M->m[2][1] * v.y + (int32_t)M->m[2][2] * v.z + (1 << (Q14_S - 1))) >> Q14_S);
+    return r;
+}
+
+static inline Mat3s16 mat3s16_mul_mat(const Mat3s16 *A, const Mat3s16 *B) {
+    Mat3s16 R;
+    for (int i = 0; i < 3; ++i) {
+        int32_t a0 = A->m[i][0], a1 = A->m[i][1], a2 = A->m[i][2];
+        for (int j = 0; j < 3; ++j) {
+            R.m[i][j] = (int16_t)((a0 * B->m[0][j] + a1 * B->m[1][j] + a2 * B->m[2][j] + (1 << (Q14_S - 1))) >> Q14_S);
+        }
+    }
+    return R;
+}
+
+static inline Quats16 quats16_mul(Quats16 a, Quats16 b) {
+    int32_t aw = a.w, ax = a.x, ay = a.y, az = a.z;
+    int32_t bw = b.w, bx = b.x, by = b.y, bz = b.z;
+    const int32_t half = 1 << (Q14_S - 1);
+    Quats16 r;
+    r.w = (int16_t)((aw * bw - ax * bx - ay * by - az * bz + half) >> Q14_S);
+    r.x = (int16_t)((aw * bx + ax * bw + ay * bz - az * by + half) >> Q14_S);
+    r.y = (int16_t)((aw * by - ax * bz + ay * bw + az * bx + half) >> Q14_S);
+    r.z = (int16_t)((aw * bz + ax * by - ay * bx + az * bw + half) >> Q14_S);
+    return r;
+}
+
+// Unit quaternion to Q1.14 rotation matrix, as quat_to_mat3
+static inline Mat3s16 quats16_to_mat3s16(Quats16 q) {
+    // Products shifted by Q14_S - 1 carry the factor 2
+    int32_t xx = ((int32_t)q.x * q.x) >> (Q14_S - 1);
+    int32_t yy = ((int32_t)q.y * q.y) >> (Q14_S - 1);
+    int32_t zz = ((int32_t)q.z * q.z) >> (Q14_S - 1);
+    int32_t xy = ((int32_t)q.x * q.y) >> (Q14_S - 1);
+    int32_t xz = ((int32_t)q.x * q.z) >> (Q14_S - 1);
+    int32_t yz = ((int32_t)q.y * q.z) >> (Q14_S - 1);
+    int32_t wx = ((int32_t)q.w * q.x) >> (Q14_S - 1);
+    int32_t wy = ((int32_t)q.w * q.y) >> (Q14_S - 1);
+    int32_t wz = ((int32_t)q.w * q.z) >> (Q14_S - 1);
+
+    Mat3s16 M;
+    M.m[0][0] = (int16_t)(Q14_ONE - yy - zz); M.m[0][1] = (int16_t)(xy - wz);           M.m[0][2] = (int16_t)(xz + wy);
+    M.m[1][0] = (int16_t)(xy + wz);           M.m[1][1] = (int16_t)(Q14_ONE - xx - zz); M.m[1][2] = (int16_t)(yz - wx);
+    M.m[2][0] = (int16_t)(xz - wy);           M.m[2][1] = (int16_t)(yz + wx);           M.m[2][2] = (int16_t)(Q14_ONE - xx - yy);
+    return M;
+}
+
+static inline void quats16_rotate_batch(Quats16 q, const Vec3 *in, Vec3 *out, uint16_t n) {
+    Mat3s16 R = quats16_to_mat3s16(q);
+    for (uint16_t i = 0; i < n; i++) out[i] = mat3s16_mul_vec(&R, in[i]);
+}
+
+} // namespace FMT
+
+#endif
@@ -0,0 +1,273 @@
+#ifndef FMT_BATCH_H
+#define FMT_BATCH_H
+
+#include <stddef.h>
+#include "FMT_3d.h"
+
+#if defined(__AVX2__) && !defined(ARDUINO)
+#include <immintrin.h>
+#define FMT_BATCH_AVX2 1
+#endif
+
+namespace FMT {
+
+/**
+ * Array versions of the trig lookups and the vertex pipeline for processing large sets.
+ * Results are bit-exact with the scalar code. With AVX2 the table lookups are done
+ * 8 at a time with gathers, otherwise the scalar functions are looped.
+ */
+
+#ifdef FMT_BATCH_AVX2
+
+#ifdef SIN_TABLE_Q15_SIZE
+#define FMT_BATCH_SIN_N SIN_TABLE_Q15_SIZE
+#else
+#define FMT_BATCH_SIN_N (sizeof(sin_table_q15) / 2)
+#endif
+#ifdef COS_TABLE_Q15_SIZE
+#define FMT_BATCH_COS_N COS_TABLE_Q15_SIZE
+#else
+#define FMT_BATCH_COS_N (sizeof(cos_table_q15) / 2)
+#endif
+
+// 32-bit copies of the 16-bit tables, so a gather never reads past the end of a table.
+struct BatchTables {
+    int32_t sin_q15[FMT_BATCH_SIN_N];
+    int32_t cos_q15[FMT_BATCH_COS_N];
+#ifdef SIN_TABLE_Q15_SIZE
+    int32_t log_sin_q8[FMT_BATCH_SIN_N];
+#endif
+    int32_t atan_q15[256];
+
+    BatchTables() {
+        for (uint32_t i = 0; i < FMT_BATCH_SIN_N; i++) sin_q15[i] = FMT_READ_S16(sin_table_q15, i);
+        for (uint32_t i = 0; i < FMT_BATCH_COS_N; i++) cos_q15[i] = FMT_READ_S16(cos_table_q15, i);
+#ifdef SIN_TABLE_Q15_SIZE
+        for (uint32_t i = 0; i < FMT_BATCH_SIN_N; i++) log_sin_q8[i] = (int16_t)FMT_READ16(log_sin_table_q8, i);
+#endif
+        for (uint32_t i = 0; i < 256; i++) atan_q15[i] = FMT_READ16(atan_q15_table, i);
+    }
+};
+
+static inline const BatchTables &batch_tables() {
+    static const BatchTables t;
+    return t;
+}
+
+// idx = (a * n) >> 16 matches every index path of sin_u16/cos_u16 for a in 0..65535
+static inline __m256i batch_angle_idx(const uint16_t *a, uint32_t n) {
+    __m256i va = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)a));
+    return _mm256_srli_epi32(_mm256_mullo_epi32(va, _mm256_set1_epi32((int32_t)n)), 16);
+}
+
+static inline void batch_store_s16(int16_t *dst, __m256i v) {
+    __m256i p = _mm256_permute4x64_epi64(_mm256_packs_epi32(v, v), 0x08);
+    _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(p));
+}
+
+static inline void batch_store_u16(uint16_t *dst, __m256i v) {
+    __m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), 0x08);
+    _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(p));
+}
+
+// floor(num / den) for num < 2^40, den < 2^32; exact because the quotient never rounds up to the next integer
+static inline __m128i batch_div_idx(__m128i num_lo, __m128i den) {
+    const __m256d bias = _mm256_set1_pd(2147483648.0);
+    const __m128i flip = _mm_set1_epi32((int32_t)0x80000000);
+    __m256d n = _mm256_add_pd(_mm256_cvtepi32_pd(_mm_xor_si128(num_lo, flip)), bias);
+    __m256d d = _mm256_add_pd(_mm256_cvtepi32_pd(_mm_xor_si128(den, flip)), bias);
+    n = _mm256_mul_pd(n, _mm256_set1_pd(255.0));
+    return _mm256_cvttpd_epi32(_mm256_div_pd(n, d));
+}
+
+// (int32_t)(((int64_t)a * b) >> 16) for 8 lanes: even and odd lanes go through separate 64-bit products
+static inline __m256i batch_q16_mul_s(__m256i a, __m256i b) {
+    __m256i even = _mm256_srli_epi64(_mm256_mul_epi32(a, b), Q16_S);
+    __m256i odd = _mm256_slli_epi64(_mm256_srli_epi64(_mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)), Q16_S), 32);
+    return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+// (int32_t)((((int64_t)m0 * x + (int64_t)m1 * y + (int64_t)m2 * z) >> 16) + t, as in mat4_mul_vec3
+static inline __m256i batch_mat_row(int32_t m0, int32_t m1, int32_t m2, int32_t t, __m256i x, __m256i y, __m256i z) {
+    __m256i v0 = _mm256_set1_epi32(m0), v1 = _mm256_set1_epi32(m1), v2 = _mm256_set1_epi32(m2);
+    __m256i xo = _mm256_srli_epi64(x, 32), yo = _mm256_srli_epi64(y, 32), zo = _mm256_srli_epi64(z, 32);
+    __m256i even = _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epi32(v0, x), _mm256_mul_epi32(v1, y)), _mm256_mul_epi32(v2, z));
+    __m256i odd = _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epi32(v0, xo), _mm256_mul_epi32(v1, yo)), _mm256_mul_epi32(v2, zo));
+    even = _mm256_srli_epi64(even, Q16_S);
+    odd = _mm256_slli_epi64(_mm256_srli_epi64(odd, Q16_S), 32);
+    return _mm256_add_epi32(_mm256_blend_epi32(even, odd, 0xAA), _mm256_set1_epi32(t));
+}
+
+// q16_div_s for 4 lanes: double quotient, then a remainder check fixes the case where it rounded up to an integer
+static inline __m128i batch_q16_div_s4(__m128i a, __m128i b) {
+    __m256d q = _mm256_div_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(a), _mm256_set1_pd(65536.0)), _mm256_cvtepi32_pd(b));
+    __m256i q64 = _mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(q));
+    __m256i b64 = _mm256_cvtepi32_epi64(b);
+    __m256i n64 = _mm256_slli_epi64(_mm256_cvtepi32_epi64(a), Q16_S);
+    __m256i r = _mm256_sub_epi64(n64, _mm256_mul_epi32(q64, b64));
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i wrong = _mm256_andnot_si256(_mm256_cmpeq_epi64(r, zero), _mm256_cmpgt_epi64(zero, _mm256_xor_si256(r, n64)));
+    // step toward zero: +1 for a negative quotient, -1 for a positive one
+    __m256i step = _mm256_or_si256(_mm256_cmpgt_epi64(zero, _mm256_xor_si256(n64, b64)), _mm256_set1_epi64x(1));
+    step = _mm256_sub_epi64(zero, step);
+    q64 = _mm256_add_epi64(q64, _mm256_and_si256(wrong, step));
+    return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(q64, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+}
+
+#endif // FMT_BATCH_AVX2
+
+static inline void sincos_u16_batch(const uint16_t *angles, int16_t *sin_out, int16_t *cos_out, size_t n) {
+    size_t i = 0;
+#ifdef FMT_BATCH_AVX2
+    const BatchTables &t = batch_tables();
+    for (; i + 8 <= n; i += 8) {
+        __m256i si = batch_angle_idx(angles + i, FMT_BATCH_SIN_N);
+        __m256i ci = batch_angle_idx(angles + i, FMT_BATCH_COS_N);
+        if (sin_out) batch_store_s16(sin_out + i, _mm256_i32gather_epi32(t.sin_q15, si, 4));
+        if (cos_out) batch_store_s16(cos_out + i, _mm256_i32gather_epi32(t.cos_q15, ci, 4));
+    }
+#endif
+    for (; i < n; i++) {
+        if (sin_out) sin_out[i] = sin_u16(angles[i]);
+        if (cos_out) cos_out[i] = cos_u16(angles[i]);
+    }
+}
+
+static inline void sin_log_batch(const uint16_t *angles, Log32 *out, size_t n) {
+    size_t i = 0;
+#if defined(FMT_BATCH_AVX2) && defined(SIN_TABLE_Q15_SIZE)
+    static_assert(sizeof(Log32) == 4, "sin_log_batch stores Log32 as 32-bit words");
+    const BatchTables &t = batch_tables();
+    const __m256i one = _mm256_set1_epi32(1);
+    for (; i + 8 <= n; i += 8) {
+        __m256i idx = batch_angle_idx(angles + i, FMT_BATCH_SIN_N);
+        __m256i s = _mm256_i32gather_epi32(t.sin_q15, idx, 4);
+        __m256i l = _mm256_i32gather_epi32(t.log_sin_q8, idx, 4);
+        __m256i sign = _mm256_sign_epi32(one, s);
+        __m256i w = _mm256_or_si256(_mm256_and_si256(l, _mm256_set1_epi32(0xFFFF)),
+                                    _mm256_slli_epi32(_mm256_and_si256(sign, _mm256_set1_epi32(0xFF)), 16));
+        _mm256_storeu_si256((__m256i *)(out + i), w);
+    }
+#endif
+    for (; i < n; i++) out[i] = sin_log(angles[i]);
+}
+
+static inline void atan2_u16_batch(const int32_t *y, const int32_t *x, uint16_t *out, size_t n) {
+    size_t i = 0;
+#ifdef FMT_BATCH_AVX2
+    const BatchTables &t = batch_tables();
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 8 <= n; i += 8) {
+        __m256i vx = _mm256_loadu_si256((const __m256i *)(x + i));
+        __m256i vy = _mm256_loadu_si256((const __m256i *)(y + i));
+        __m256i ux = _mm256_abs_epi32(vx);
+        __m256i uy = _mm256_abs_epi32(vy);
+        __m256i hi = _mm256_max_epu32(ux, uy);
+        __m256i lo = _mm256_min_epu32(ux, uy);
+        __m256i y_le_x = _mm256_cmpeq_epi32(hi, ux);
+
+        __m128i i_lo = batch_div_idx(_mm256_castsi256_si128(lo), _mm256_castsi256_si128(hi));
+        __m128i i_hi = batch_div_idx(_mm256_extracti128_si256(lo, 1), _mm256_extracti128_si256(hi, 1));
+        __m256i idx = _mm256_inserti128_si256(_mm256_castsi128_si256(i_lo), i_hi, 1);
+        __m256i both_zero = _mm256_cmpeq_epi32(hi, zero);
+        idx = _mm256_andnot_si256(both_zero, idx);
+
+        __m256i a = _mm256_i32gather_epi32(t.atan_q15, idx, 4);
+        a = _mm256_blendv_epi8(_mm256_sub_epi32(_mm256_set1_epi32(16384), a), a, y_le_x);
+
+        __m256i x_neg = _mm256_cmpgt_epi32(zero, vx);
+        __m256i y_neg = _mm256_cmpgt_epi32(zero, vy);
+        // x < 0: 32768 -/+ a, x >= 0 and y < 0: 65536 - a
+        __m256i base = _mm256_blendv_epi8(_mm256_and_si256(y_neg, _mm256_set1_epi32(65536)),
+                                          _mm256_set1_epi32(32768), x_neg);
+        a = _mm256_blendv_epi8(a, _mm256_sub_epi32(zero, a), _mm256_xor_si256(x_neg, y_neg));
+        a = _mm256_and_si256(_mm256_add_epi32(base, a), _mm256_set1_epi32(0xFFFF));
+        a = _mm256_andnot_si256(both_zero, a);
+        batch_store_u16(out + i, a);
+    }
+#endif
+    for (; i < n; i++) out[i] = atan2_u16(y[i], x[i]);
+}
+
+/**
+ * Transform and project structure-of-arrays vertices with one prebuilt affine matrix
+ * (e.g. mat4_model), so the rotation is built once per mesh instead of once per vertex.
+ * Unlike project_perspective, which divides x * focal and y * focal by the depth separately,
+ * this takes one factor focal / denom per vertex and multiplies both by it, so the results
+ * can differ from project_perspective in the last bits (the scalar and AVX2 paths agree exactly).
+ * Outputs may alias the inputs.
+ */
+static inline void transform_project_batch(const Mat4 *M, int32_t focal,
+                                           const int32_t *x, const int32_t *y, const int32_t *z,
+                                           int32_t *ox, int32_t *oy, int32_t *oz, size_t n) {
+    size_t i = 0;
+#ifdef FMT_BATCH_AVX2
+    const __m256i vf = _mm256_set1_epi32(focal);
+    const __m256i one = _mm256_set1_epi32(1);
+    for (; i + 8 <= n; i += 8) {
+        __m256i vx = _mm256_loadu_si256((const __m256i *)(x + i));
+        __m256i vy = _mm256_loadu_si256((const __m256i *)(y + i));
+        __m256i vz = _mm256_loadu_si256((const __m256i *)(z + i));
+        __m256i wx = batch_mat_row(M->m[0][0], M->m[0][1], M->m[0][2], M->m[0][3], vx, vy, vz);
+        __m256i wy = batch_mat_row(M->m[1][0], M->m[1][1], M->m[1][2], M->m[1][3], vx, vy, vz);
+        __m256i wz = batch_mat_row(M->m[2][0], M->m[2][1], M->m[2][2], M->m[2][3], vx, vy, vz);
+        __m256i d = _mm256_add_epi32(wz, vf);
+        d = _mm256_blendv_epi8(d, one, _mm256_cmpeq_epi32(d, _mm256_setzero_si256()));
+        __m128i f_lo = batch_q16_div_s4(_mm256_castsi256_si128(vf), _mm256_castsi256_si128(d));
+        __m128i f_hi = batch_q16_div_s4(_mm256_castsi256_si128(vf), _mm256_extracti128_si256(d, 1));
+        __m256i f = _mm256_inserti128_si256(_mm256_castsi128_si256(f_lo), f_hi, 1);
+        _mm256_storeu_si256((__m256i *)(ox + i), batch_q16_mul_s(wx, f));
+        _mm256_storeu_si256((__m256i *)(oy + i), batch_q16_mul_s(wy, f));
+        _mm256_storeu_si256((__m256i *)(oz + i), wz);
+    }
+    x += i; y += i; z += i;
+    ox += i; oy += i; oz += i;
+#endif
+    // Matrix entries live in locals and the arrays are walked by pointer (post-increment LD/ST on AVR)
+    const int32_t m00 = M->m[0][0], m01 = M->m[0][1], m02 = M->m[0][2], m03 = M->m[0][3];
+    const int32_t m10 = M->m[1][0], m11 = M->m[1][1], m12 = M->m[1][2], m13 = M->m[1][3];
+    const int32_t m20 = M->m[2][0], m21 = M->m[2][1], m22 = M->m[2][2], m23 = M->m[2][3];
+    for (size_t k = n - i; k; k--) {
+        int32_t vx = *x++, vy = *y++, vz = *z++;
+        int32_t wx = (int32_t)(((int64_t)m00 * vx + (int64_t)m01 * vy + (int64_t)m02 * vz) >> Q16_S) + m03;
+        int32_t wy = (int32_t)(((int64_t)m10 * vx + (int64_t)m11 * vy + (int64_t)m12 * vz) >> Q16_S) + m13;
+        int32_t wz = (int32_t)(((int64_t)m20 * vx + (int64_t)m21 * vy + (int64_t)m22 * vz) >> Q16_S) + m23;
+        int32_t denom = wz + focal;
+        if (denom == 0) denom = 1;
+        int32_t f = q16_div_s(focal, denom);
+        *ox++ = q16_mul_s(wx, f);
+        *oy++ = q16_mul_s(wy, f);
+        *oz++ = wz;
+    }
+}
+
+/**
+ * Log-domain projection as in project_perspective_ap, with log2(focal) taken once per batch.
+ * No 64-bit division; this is the variant to use on AVR.
+ */
+static inline void transform_project_batch_ap(const Mat4 *M, int32_t focal,
+                                              const int32_t *x, const int32_t *y, const int32_t *z,
+                                              int32_t *ox, int32_t *oy, int32_t *oz, size_t n) {
+    const int32_t m00 = M->m[0][0], m01 = M->m[0][1], m02 = M->m[0][2], m03 = M->m[0][3];
+    const int32_t m10 = M->m[1][0], m11 = M->m[1][1], m12 = M->m[1][2], m13 = M->m[1][3];
+    const int32_t m20 = M->m[2][0], m21 = M->m[2][1], m22 = M->m[2][2], m23 = M->m[2][3];
+    const int32_t log_focal = log2_q8((uint32_t)focal);
+    for (; n; n--) {
+        int32_t vx = *x++, vy = *y++, vz = *z++;
+        int32_t wx = (int32_t)(((int64_t)m00 * vx + (int64_t)m01 * vy + (int64_t)m02 * vz) >> Q16_S) + m03;
+        int32_t wy = (int32_t)(((int64_t)m10 * vx + (int64_t)m11 * vy + (int64_t)m12 * vz) >> Q16_S) + m13;
+        int32_t wz = (int32_t)(((int64_t)m20 * vx + (int64_t)m21 * vy + (int64_t)m22 * vz) >> Q16_S) + m23;
+        int32_t denom = wz + focal;
+        if (denom <= 0) denom = 1;
+        int32_t log_factor = log_focal - log2_q8((uint32_t)denom);
+        int32_t rx = (wx == 0) ? 0 : (int32_t)exp2_q8(log2_q8((uint32_t)(wx > 0 ? wx : -wx)) + log_factor);
+        int32_t ry = (wy == 0) ? 0 : (int32_t)exp2_q8(log2_q8((uint32_t)(wy > 0 ? wy : -wy)) + log_factor);
+        *ox++ = (wx < 0) ? -rx : rx;
+        *oy++ = (wy < 0) ? -ry : ry;
+        *oz++ = wz;
+    }
+}
+
+} // namespace FMT
+
+#endif
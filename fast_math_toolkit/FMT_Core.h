@@ -8,10 +8,12 @@
 #define FMT_READ8(a, i) pgm_read_byte(&(a)[(i)])
 #define FMT_READ16(a, i) pgm_read_word(&(a)[(i)])
 #define FMT_READ_S16(a, i) (int16_t)pgm_read_word(&(a)[(i)])
+#define FMT_READ_S32(a, i) (int32_t)pgm_read_dword(&(a)[(i)])
 #else
 #define FMT_READ8(a, i) (a)[(i)]
 #define FMT_READ16(a, i) (a)[(i)]
 #define FMT_READ_S16(a, i) (a)[(i)]
+#define FMT_READ_S32(a, i) (a)[(i)]
 #endif
 
 #ifndef INCLUDE_TABLES
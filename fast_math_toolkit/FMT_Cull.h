@@ -0,0 +1,121 @@
+#ifndef FMT_CULL_H
+#define FMT_CULL_H
+
+#include "FMT_3d.h"
+
+namespace FMT {
+
+/**
+ * Early rejection before the vertex pipeline.
+ *
+ * View space is the one project_perspective expects: camera at z = -focal looking along +z,
+ * so a point projects to x * focal / (z + focal). Planes are stored as n.p + d >= 0 inside
+ * with unit normals (Q16.16), the same n/d convention as ray_plane_intersect.
+ */
+
+typedef struct {
+    Vec3 n;
+    int32_t d;
+} Plane;
+
+enum {
+    FRUSTUM_LEFT, FRUSTUM_RIGHT, FRUSTUM_TOP, FRUSTUM_BOTTOM, FRUSTUM_NEAR, FRUSTUM_FAR,
+    FRUSTUM_PLANES
+};
+
+typedef struct {
+    Plane p[FRUSTUM_PLANES];
+} Frustum;
+
+enum {
+    CULL_OUTSIDE = 0,
+    CULL_INTERSECT = 1,
+    CULL_INSIDE = 2
+};
+
+static inline int32_t plane_dist(const Plane *p, Vec3 v) {
+    return vec3_dot(p->n, v) + p->d;
+}
+
+// Side plane a * x + b * (z + focal) >= 0 with (a, b) scaled to unit length; hypot2 keeps large Q16.16 values in range
+static inline Plane frustum_side_plane(int32_t a, int32_t b, int32_t focal, bool y_axis) {
+    int32_t len = (int32_t)hypot2(a, b);
+    Plane p;
+    int32_t na = q16_div_s(a, len), nb = q16_div_s(b, len);
+    p.n = y_axis ? vec3_init(0, na, nb) : vec3_init(na, 0, nb);
+    p.d = q16_mul_s(nb, focal);
+    return p;
+}
+
+// half_w/half_h: visible extent of projected x/y (Q16.16); near/far: distance from the camera (z + focal)
+static inline void frustum_init(Frustum *f, int32_t focal, int32_t half_w, int32_t half_h, int32_t near_dist, int32_t far_dist) {
+    // |x| * focal <= half_w * (z + focal)
+    f->p[FRUSTUM_LEFT] = frustum_side_plane(focal, half_w, focal, false);
+    f->p[FRUSTUM_RIGHT] = frustum_side_plane(-focal, half_w, focal, false);
+    f->p[FRUSTUM_BOTTOM] = frustum_side_plane(focal, half_h, focal, true);
+    f->p[FRUSTUM_TOP] = frustum_side_plane(-focal, half_h, focal, true);
+    f->p[FRUSTUM_NEAR].n = vec3_init(0, 0, Q16_ONE);
+    f->p[FRUSTUM_NEAR].d = focal - near_dist;
+    f->p[FRUSTUM_FAR].n = vec3_init(0, 0, -Q16_ONE);
+    f->p[FRUSTUM_FAR].d = far_dist - focal;
+}
+
+// Bounding sphere already in view space (e.g. mat34_mul_point of the model-space centre, radius times scale)
+static inline uint8_t frustum_test_sphere(const Frustum *f, Vec3 center, int32_t radius) {
+    uint8_t result = CULL_INSIDE;
+    for (int i = 0; i < FRUSTUM_PLANES; i++) {
+        int32_t d = plane_dist(&f->p[i], center);
+        if (d < -radius) return CULL_OUTSIDE;
+        if (d < radius) result = CULL_INTERSECT;
+    }
+    return result;
+}
+
+// Object-level test: only the sphere centre goes through the model-view matrix
+static inline uint8_t frustum_test_object(const Frustum *f, const Mat34 *model_view, Vec3 center, int32_t radius, int32_t scale) {
+    return frustum_test_sphere(f, mat34_mul_point(model_view, center), q16_mul_s(radius, scale));
+}
+
+/**
+ * Backface test in model space, before any vertex is transformed. eye is the camera
+ * position in the same space, e.g. mat34_mul_point(&inverse_model_view, (0, 0, -focal)).
+ * Agrees with tri_backfacing_proj: with x right, y up and z away from the camera the
+ * cross product of a screen counter-clockwise triangle points away from the eye.
+ */
+static inline bool tri_backfacing_obj(Vec3 a, Vec3 b, Vec3 c, Vec3 eye) {
+    Vec3 n = vec3_cross(vec3_sub(b, a), vec3_sub(c, a));
+    Vec3 e = vec3_sub(eye, a);
+    int64_t dot = (int64_t)n.x * e.x + (int64_t)n.y * e.y + (int64_t)n.z * e.z;
+    return dot >= 0;
+}
+
+// Backface test on projected vertices (y up): counter-clockwise on screen is front-facing
+static inline bool tri_backfacing_proj(Vec3 a, Vec3 b, Vec3 c) {
+    int64_t area = (int64_t)(b.x - a.x) * (c.y - a.y) - (int64_t)(b.y - a.y) * (c.x - a.x);
+    return area <= 0;
+}
+
+/**
+ * Clip a view-space triangle against the near plane z + focal >= near_dist before projection.
+ * Writes a convex polygon of 0, 3 or 4 vertices to out (fan it as 0-1-2, 0-2-3) and returns
+ * its vertex count; winding is preserved.
+ */
+static inline uint8_t clip_tri_near(const Vec3 in[3], int32_t focal, int32_t near_dist, Vec3 out[4]) {
+    int32_t zn = near_dist - focal;
+    uint8_t n = 0;
+    for (int i = 0; i < 3; i++) {
+        const Vec3 &a = in[i];
+        const Vec3 &b = in[(i + 1) % 3];
+        bool a_in = a.z >= zn, b_in = b.z >= zn;
+        if (a_in) out[n++] = a;
+        if (a_in != b_in) {
+            int32_t t = q16_div_s(zn - a.z, b.z - a.z);
+            out[n++] = vec3_init(q16_lerp(a.x, b.x, t), q16_lerp(a.y, b.y, t), zn);
+        }
+    }
+    return n;
+}
+
+} // namespace FMT
+
+#endif
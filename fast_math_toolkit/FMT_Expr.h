@@ -0,0 +1,193 @@
+#ifndef FMT_EXPR_H
+#define FMT_EXPR_H
+
+#include "FMT_3d.h"
+
+namespace FMT {
+
+/**
+ * Optional operator overloads for transform chains (include this header explicitly; FMT.h
+ * does not). Multiplying matrices only records the chain; nothing is computed until a
+ * point is applied or the chain is evaluated:
+ *
+ *   Vec4 c = P * V * M * v;          // three matrix-vector products, right to left
+ *   Mat4 PVM = expr_eval(P * V * M); // matrix products, affine ones with 27 MACs
+ *   expr_transform(P * V * M, in, out, n);  // picks whichever is cheaper for n points
+ *
+ * Mat34 and Mat3 are known to be affine; wrap an affine Mat4 (mat4_model, ...) in
+ * expr_affine() so its [0 0 0 1] row is skipped too. Plain Mat4 is treated as general.
+ * The chain holds pointers to its operands: use it within the statement that builds it.
+ */
+
+// MAC counts: VEC_MACS to apply the chain to a point, EVAL_MACS to collapse it into one matrix
+typedef struct { const Mat4 *m; enum { AFFINE = 0, VEC_MACS = 16, EVAL_MACS = 0 }; } ExprMat4;
+typedef struct { const Mat4 *m; enum { AFFINE = 1, VEC_MACS = 9, EVAL_MACS = 0 }; } ExprAffine4;
+typedef struct { const Mat34 *m; enum { AFFINE = 1, VEC_MACS = 9, EVAL_MACS = 0 }; } ExprMat34;
+typedef struct { const Mat3 *m; enum { AFFINE = 1, VEC_MACS = 9, EVAL_MACS = 0 }; } ExprMat3;
+
+template <class L, class R>
+struct ExprProd {
+    L l;
+    R r;
+    enum {
+        AFFINE = L::AFFINE && R::AFFINE,
+        VEC_MACS = L::VEC_MACS + R::VEC_MACS,
+        EVAL_MACS = L::EVAL_MACS + R::EVAL_MACS + (AFFINE ? 27 : (L::AFFINE || R::AFFINE) ? 48 : 64)
+    };
+};
+
+static inline ExprAffine4 expr_affine(const Mat4 &m) {
+    ExprAffine4 e = {&m};
+    return e;
+}
+
+// Maps operands to expression nodes; no `type` for anything else, which keeps the operators out of overload resolution
+template <class T> struct ExprOf {};
+template <> struct ExprOf<Mat4> {
+    typedef ExprMat4 type;
+    static type make(const Mat4 &m) { type e = {&m}; return e; }
+};
+template <> struct ExprOf<Mat34> {
+    typedef ExprMat34 type;
+    static type make(const Mat34 &m) { type e = {&m}; return e; }
+};
+template <> struct ExprOf<Mat3> {
+    typedef ExprMat3 type;
+    static type make(const Mat3 &m) { type e = {&m}; return e; }
+};
+template <> struct ExprOf<ExprAffine4> {
+    typedef ExprAffine4 type;
+    static type make(const type &e) { return e; }
+};
+template <class L, class R> struct ExprOf<ExprProd<L, R> > {
+    typedef ExprProd<L, R> type;
+    static type make(const type &e) { return e; }
+};
+
+// Result of applying a chain to a point: Vec4 once a general Mat4 is involved, else Vec3
+template <class E, class V> struct ExprApply { typedef V type; };
+template <class V> struct ExprApply<ExprMat4, V> { typedef Vec4 type; };
+template <class L, class R, class V> struct ExprApply<ExprProd<L, R>, V> {
+    typedef typename ExprApply<L, typename ExprApply<R, V>::type>::type type;
+};
+
+// Affine rows applied to a homogeneous point; w passes through
+static inline Vec4 expr_affine_vec4(const int32_t (*m)[4], Vec4 v) {
+    Vec4 r;
+    r.x = (int32_t)(((int64_t)m[0][0] * v.x + (int64_t)m[0][1] * v.y + (int64_t)m[0][2] * v.z + (int64_t)m[0][3] * v.w) >> Q16_S);
+    r.y = (int32_t)(((int64_t)m[1][0] * v.x + (int64_t)m[1][1] * v.y + (int64_t)m[1][2] * v.z + (int64_t)m[1][3] * v.w) >> Q16_S);
+    r.z = (int32_t)(((int64_t)m[2][0] * v.x + (int64_t)m[2][1] * v.y + (int64_t)m[2][2] * v.z + (int64_t)m[2][3] * v.w) >> Q16_S);
+    r.w = v.w;
+    return r;
+}
+
+static inline Vec3 expr_apply(ExprMat34 e, Vec3 v) { return mat34_mul_point(e.m, v); }
+static inline Vec3 expr_apply(ExprAffine4 e, Vec3 v) { return mat4_mul_vec3(e.m, v); }
+static inline Vec3 expr_apply(ExprMat3 e, Vec3 v) { return mat3_mul_vec(e.m, v); }
+static inline Vec4 expr_apply(ExprMat4 e, Vec3 v) {
+    // w = 1: the fourth column is added, not multiplied
+    const int32_t (*m)[4] = e.m->m;
+    Vec4 r;
+    r.x = (int32_t)(((int64_t)m[0][0] * v.x + (int64_t)m[0][1] * v.y + (int64_t)m[0][2] * v.z) >> Q16_S) + m[0][3];
+    r.y = (int32_t)(((int64_t)m[1][0] * v.x + (int64_t)m[1][1] * v.y + (int64_t)m[1][2] * v.z) >> Q16_S) + m[1][3];
+    r.z = (int32_t)(((int64_t)m[2][0] * v.x + (int64_t)m[2][1] * v.y + (int64_t)m[2][2] * v.z) >> Q16_S) + m[2][3];
+    r.w = (int32_t)(((int64_t)m[3][0] * v.x + (int64_t)m[3][1] * v.y + (int64_t)m[3][2] * v.z) >> Q16_S) + m[3][3];
+    return r;
+}
+static inline Vec4 expr_apply(ExprMat4 e, Vec4 v) { return mat4_mul_vec4(e.m, v); }
+static inline Vec4 expr_apply(ExprMat34 e, Vec4 v) { return expr_affine_vec4(e.m->m, v); }
+static inline Vec4 expr_apply(ExprAffine4 e, Vec4 v) { return expr_affine_vec4(e.m->m, v); }
+static inline Vec4 expr_apply(ExprMat3 e, Vec4 v) {
+    Vec3 r = mat3_mul_vec(e.m, vec3_init(v.x, v.y, v.z));
+    Vec4 o = {r.x, r.y, r.z, v.w};
+    return o;
+}
+template <class L, class R, class V>
+static inline typename ExprApply<ExprProd<L, R>, V>::type expr_apply(const ExprProd<L, R> &e, V v) {
+    return expr_apply(e.l, expr_apply(e.r, v));
+}
+
+// Collapsed matrix type: Mat34 for all-affine chains
+template <bool AFFINE> struct ExprMatrixSel { typedef Mat4 type; };
+template <> struct ExprMatrixSel<true> { typedef Mat34 type; };
+template <class E> struct ExprMatrix { typedef typename ExprMatrixSel<(bool)E::AFFINE>::type type; };
+
+static inline Mat34 expr_mul(const Mat34 &A, const Mat34 &B) { return mat34_mul(&A, &B); }
+static inline Mat4 expr_mul(const Mat4 &A, const Mat4 &B) { return mat4_mul(&A, &B); }
+
+// General * affine: B's bottom row is [0 0 0 1], 48 MACs
+static inline Mat4 expr_mul(const Mat4 &A, const Mat34 &B) {
+    Mat4 R;
+    for (int i = 0; i < 4; i++) {
+        int32_t a0 = A.m[i][0], a1 = A.m[i][1], a2 = A.m[i][2], a3 = A.m[i][3];
+        for (int j = 0; j < 3; j++) {
+            R.m[i][j] = (int32_t)(((int64_t)a0 * B.m[0][j] + (int64_t)a1 * B.m[1][j] + (int64_t)a2 * B.m[2][j]) >> Q16_S);
+        }
+        R.m[i][3] = (int32_t)(((int64_t)a0 * B.m[0][3] + (int64_t)a1 * B.m[1][3] + (int64_t)a2 * B.m[2][3]) >> Q16_S) + a3;
+    }
+    return R;
+}
+
+// Affine * general: A's bottom row copies B's, 48 MACs
+static inline Mat4 expr_mul(const Mat34 &A, const Mat4 &B) {
+    Mat4 R;
+    for (int i = 0; i < 3; i++) {
+        int32_t a0 = A.m[i][0], a1 = A.m[i][1], a2 = A.m[i][2], a3 = A.m[i][3];
+        for (int j = 0; j < 4; j++) {
+            R.m[i][j] = (int32_t)(((int64_t)a0 * B.m[0][j] + (int64_t)a1 * B.m[1][j] +
+                                   (int64_t)a2 * B.m[2][j] + (int64_t)a3 * B.m[3][j]) >> Q16_S);
+        }
+    }
+    for (int j = 0; j < 4; j++) R.m[3][j] = B.m[3][j];
+    return R;
+}
+
+static inline Mat4 expr_eval(ExprMat4 e) { return *e.m; }
+static inline Mat34 expr_eval(ExprAffine4 e) { return mat34_from_mat4(e.m); }
+static inline Mat34 expr_eval(ExprMat34 e) { return *e.m; }
+static inline Mat34 expr_eval(ExprMat3 e) {
+    Mat34 r;
+    for (int i = 0; i < 3; i++) {
+        r.m[i][0] = e.m->m[i][0]; r.m[i][1] = e.m->m[i][1]; r.m[i][2] = e.m->m[i][2]; r.m[i][3] = 0;
+    }
+    return r;
+}
+template <class L, class R>
+static inline typename ExprMatrix<ExprProd<L, R> >::type expr_eval(const ExprProd<L, R> &e) {
+    return expr_mul(expr_eval(e.l), expr_eval(e.r));
+}
+
+template <class A, class B>
+static inline ExprProd<typename ExprOf<A>::type, typename ExprOf<B>::type> operator*(const A &a, const B &b) {
+    ExprProd<typename ExprOf<A>::type, typename ExprOf<B>::type> p = {ExprOf<A>::make(a), ExprOf<B>::make(b)};
+    return p;
+}
+
+template <class A>
+static inline typename ExprApply<typename ExprOf<A>::type, Vec3>::type operator*(const A &a, Vec3 v) {
+    return expr_apply(ExprOf<A>::make(a), v);
+}
+
+/**
+ * out[i] = chain * in[i]. The MAC counts are compile-time constants, so this reduces to one
+ * comparison: collapse the chain once and do one product per point when n is large,
+ * otherwise walk the chain per point.
+ */
+template <class A>
+static inline void expr_transform(const A &a, const Vec3 *in,
+                                  typename ExprApply<typename ExprOf<A>::type, Vec3>::type *out, uint16_t n) {
+    typedef typename ExprOf<A>::type E;
+    E e = ExprOf<A>::make(a);
+    const uint32_t final_macs = E::AFFINE ? 9 : 12;
+    if ((uint32_t)n * E::VEC_MACS > (uint32_t)E::EVAL_MACS + (uint32_t)n * final_macs) {
+        typename ExprMatrix<E>::type M = expr_eval(e);
+        typename ExprOf<typename ExprMatrix<E>::type>::type leaf = ExprOf<typename ExprMatrix<E>::type>::make(M);
+        for (uint16_t i = 0; i < n; i++) out[i] = expr_apply(leaf, in[i]);
+    } else {
+        for (uint16_t i = 0; i < n; i++) out[i] = expr_apply(e, in[i]);
+    }
+}
+
+} // namespace FMT
+
+#endif
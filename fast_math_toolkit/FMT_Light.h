@@ -0,0 +1,91 @@
+#ifndef FMT_LIGHT_H
+#define FMT_LIGHT_H
+
+#include "FMT_3d.h"
+
+namespace FMT {
+
+/**
+ * Per-vertex lighting: Lambert diffuse plus Blinn-Phong specular, RGB565 out.
+ * Directions are normalized with vec3_normalize_ap (one log2_q8 of the squared length
+ * shared by all components) and (n.h)^shininess is exp2(shininess * log2(n.h)), so the
+ * only wide multiplies left are the dot products.
+ */
+
+enum {
+    LIGHT_DIRECTIONAL = 0,
+    LIGHT_POINT = 1
+};
+
+typedef struct {
+    Vec3 v;            // directional: unit vector towards the light; point: position
+    uint8_t r, g, b;
+    uint8_t type;
+} Light;
+
+typedef struct {
+    uint8_t r, g, b;   // diffuse albedo
+    uint8_t ks;        // specular strength
+    uint8_t shininess; // Blinn-Phong exponent
+} Material;
+
+static inline uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) {
+    return (uint16_t)(((uint16_t)(r & 0xF8) << 8) | ((uint16_t)(g & 0xFC) << 3) | (b >> 3));
+}
+
+// (n.h)^k as Q8 (256 = 1.0) for n.h in Q16.16
+static inline uint16_t spec_pow_q8(int32_t ndoth, uint8_t k) {
+    if (ndoth <= 0) return 0;
+    if (ndoth >= Q16_ONE) return 256;
+    int32_t l = (log2_q8((uint32_t)ndoth) - (16L << FMT_LOG_Q)) * k;
+    if (l < -(16L << FMT_LOG_Q)) return 0;
+    return (uint16_t)exp2_q8(l + (8L << FMT_LOG_Q));
+}
+
+/**
+ * Light one vertex. p and n are in the same space as the lights and eye, n unit length.
+ * ambient is Q8 (256 = full albedo).
+ */
+static inline uint16_t light_vertex(const Light *lights, uint8_t count, const Material *m,
+                                    Vec3 p, Vec3 n, Vec3 eye, uint16_t ambient) {
+    uint32_t r = ((uint32_t)m->r * ambient) >> 8;
+    uint32_t g = ((uint32_t)m->g * ambient) >> 8;
+    uint32_t b = ((uint32_t)m->b * ambient) >> 8;
+    Vec3 v = vec3_normalize_ap(vec3_sub(eye, p));
+
+    for (uint8_t i = 0; i < count; i++) {
+        const Light *lt = &lights[i];
+        Vec3 l = (lt->type == LIGHT_POINT) ? vec3_normalize_ap(vec3_sub(lt->v, p)) : lt->v;
+        int32_t ndotl = vec3_dot(n, l);
+        if (ndotl <= 0) continue;
+        uint32_t diff = (uint32_t)ndotl >> 8; // Q8
+        if (diff > 256) diff = 256;
+        r += ((((uint32_t)m->r * lt->r) >> 8) * diff) >> 8;
+        g += ((((uint32_t)m->g * lt->g) >> 8) * diff) >> 8;
+        b += ((((uint32_t)m->b * lt->b) >> 8) * diff) >> 8;
+
+        if (m->ks) {
+            Vec3 h = vec3_normalize_ap(vec3_add(l, v));
+            uint32_t spec = ((uint32_t)spec_pow_q8(vec3_dot(n, h), m->shininess) * m->ks) >> 8;
+            r += ((uint32_t)lt->r * spec) >> 8;
+            g += ((uint32_t)lt->g * spec) >> 8;
+            b += ((uint32_t)lt->b * spec) >> 8;
+        }
+    }
+    if (r > 255) r = 255;
+    if (g > 255) g = 255;
+    if (b > 255) b = 255;
+    return rgb565((uint8_t)r, (uint8_t)g, (uint8_t)b);
+}
+
+static inline void light_vertices(const Light *lights, uint8_t count, const Material *m,
+                                  const Vec3 *pos, const Vec3 *normals, uint16_t n,
+                                  Vec3 eye, uint16_t ambient, uint16_t *out) {
+    for (uint16_t i = 0; i < n; i++) {
+        out[i] = light_vertex(lights, count, m, pos[i], normals[i], eye, ambient);
+    }
+}
+
+} // namespace FMT
+
+#endif
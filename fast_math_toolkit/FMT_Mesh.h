@@ -0,0 +1,126 @@
+#ifndef FMT_MESH_H
+#define FMT_MESH_H
+
+#include "FMT_3d.h"
+
+namespace FMT {
+
+/**
+ * Quantized indexed meshes as emitted by generate_tables.py --mesh: int16 positions
+ * (6 bytes per vertex), a per-mesh Q16.16 scale and offset, and 8- or 16-bit triangle
+ * indices, all readable from PROGMEM. The scale and offset are folded into the model-view
+ * matrix once per mesh, so decoding a vertex is a single mat34_mul_point.
+ *
+ * MeshStream walks the triangle list and keeps a small direct-mapped cache of transformed
+ * and projected vertices, so each shared vertex is transformed once as long as its
+ * triangles are close together in the list (the generator numbers vertices in first-use
+ * order for this).
+ */
+
+#ifndef FMT_MESH_CACHE
+#define FMT_MESH_CACHE 16 // entries, power of two
+#endif
+
+typedef struct {
+    const int16_t *verts;      // x, y, z per vertex
+    const uint8_t *indices8;   // one of indices8 / indices16 is set
+    const uint16_t *indices16;
+    uint16_t vert_count;
+    uint16_t tri_count;
+    int32_t scale;             // Q16.16 world units per 65536 quanta
+    Vec3 offset;
+} MeshQ;
+
+// verts_size / index_size / quant are the generated arrays and their *_SIZE macros
+static inline void mesh_init(MeshQ *m, const int16_t *verts, uint16_t verts_size,
+                             const uint8_t *indices, uint16_t index_size, const int32_t *quant) {
+    m->verts = verts;
+    m->indices8 = indices;
+    m->indices16 = 0;
+    m->vert_count = verts_size / 3;
+    m->tri_count = index_size / 3;
+    m->scale = FMT_READ_S32(quant, 0);
+    m->offset = vec3_init(FMT_READ_S32(quant, 1), FMT_READ_S32(quant, 2), FMT_READ_S32(quant, 3));
+}
+
+static inline void mesh_init(MeshQ *m, const int16_t *verts, uint16_t verts_size,
+                             const uint16_t *indices, uint16_t index_size, const int32_t *quant) {
+    mesh_init(m, verts, verts_size, (const uint8_t *)0, index_size, quant);
+    m->indices16 = indices;
+}
+
+static inline uint16_t mesh_index(const MeshQ *m, uint16_t k) {
+    return m->indices8 ? FMT_READ8(m->indices8, k) : FMT_READ16(m->indices16, k);
+}
+
+// Raw quanta as a Vec3; combine with mesh_matrix
+static inline Vec3 mesh_vertex_q(const MeshQ *m, uint16_t i) {
+    const int16_t *v = m->verts + (uint32_t)i * 3;
+    return vec3_init(FMT_READ_S16(v, 0), FMT_READ_S16(v, 1), FMT_READ_S16(v, 2));
+}
+
+// Dequantized model-space position
+static inline Vec3 mesh_vertex(const MeshQ *m, uint16_t i) {
+    Vec3 q = mesh_vertex_q(m, i);
+    return vec3_init(m->offset.x + q16_mul_s(q.x, m->scale),
+                     m->offset.y + q16_mul_s(q.y, m->scale),
+                     m->offset.z + q16_mul_s(q.z, m->scale));
+}
+
+// model_view * dequantize, so that mat34_mul_point(&result, mesh_vertex_q(m, i)) is the view-space vertex
+static inline Mat34 mesh_matrix(const MeshQ *m, const Mat34 *model_view) {
+    Mat34 Q;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) Q.m[i][j] = (i == j) ? m->scale : 0;
+    }
+    Q.m[0][3] = m->offset.x;
+    Q.m[1][3] = m->offset.y;
+    Q.m[2][3] = m->offset.z;
+    return mat34_mul(model_view, &Q);
+}
+
+typedef struct {
+    const MeshQ *mesh;
+    Mat34 M;         // model-view with the quantization folded in
+    int32_t focal;
+    uint16_t tri;    // next triangle
+    uint16_t transformed;
+    uint16_t tag[FMT_MESH_CACHE];
+    Vec3 v[FMT_MESH_CACHE];
+} MeshStream;
+
+static inline void mesh_stream_begin(MeshStream *s, const MeshQ *m, const Mat34 *model_view, int32_t focal) {
+    s->mesh = m;
+    s->M = mesh_matrix(m, model_view);
+    s->focal = focal;
+    s->tri = 0;
+    s->transformed = 0;
+    for (int i = 0; i < FMT_MESH_CACHE; i++) s->tag[i] = 0xFFFF;
+}
+
+// Projected vertex i (project_perspective output: screen x/y, view z), transformed at most once while cached
+static inline Vec3 mesh_stream_vertex(MeshStream *s, uint16_t i) {
+    uint16_t slot = i & (FMT_MESH_CACHE - 1);
+    if (s->tag[slot] != i) {
+        s->tag[slot] = i;
+        s->v[slot] = project_perspective(mat34_mul_point(&s->M, mesh_vertex_q(s->mesh, i)), s->focal);
+        s->transformed++;
+    }
+    return s->v[slot];
+}
+
+// Next triangle's projected vertices; false at the end of the mesh
+static inline bool mesh_stream_next(MeshStream *s, Vec3 out[3]) {
+    if (s->tri >= s->mesh->tri_count) return false;
+    uint16_t k = s->tri * 3;
+    uint16_t i0 = mesh_index(s->mesh, k), i1 = mesh_index(s->mesh, k + 1), i2 = mesh_index(s->mesh, k + 2);
+    out[0] = mesh_stream_vertex(s, i0);
+    out[1] = mesh_stream_vertex(s, i1);
+    out[2] = mesh_stream_vertex(s, i2);
+    s->tri++;
+    return true;
+}
+
+} // namespace FMT
+
+#endif
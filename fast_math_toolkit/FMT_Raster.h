@@ -0,0 +1,214 @@
+#ifndef FMT_RASTER_H
+#define FMT_RASTER_H
+
+#include "FMT_3d.h"
+
+namespace FMT {
+
+/**
+ * Tile-binned triangle rasterizer.
+ *
+ * Triangles are set up once in Q12.4 screen coordinates, binned into the tile grid of a
+ * TileManager, then rasterized one tile at a time straight into the tile's RGB565 buffer
+ * with incremental edge functions (top-left fill rule, pixel-centre sampling). Depth is
+ * log2_q8 of the view distance, so a 16-bit per-tile depth buffer covers the whole range.
+ */
+
+enum {
+    RASTER_SUB = 4,   // Q12.4 sub-pixel bits
+    RASTER_GUARD = 2047
+};
+
+typedef struct {
+    int16_t x[3], y[3]; // Q12.4 screen coordinates
+    uint16_t z[3];      // log2_q8 depth, smaller is nearer
+    uint16_t color;     // RGB565
+} RasterTri;
+
+static inline uint16_t depth_log_u16(int32_t dist) {
+    if (dist <= 0) return 0;
+    int32_t l = log2_q8((uint32_t)dist);
+    if (l < 0) return 0;
+    return (uint16_t)l;
+}
+
+/**
+ * a, b, c are project_perspective / pipeline_mvp outputs (Q16.16, y up, z view depth);
+ * (cx, cy) is the screen centre in pixels. Returns false for triangles that reach behind
+ * the camera or leave the Q12.4 guard band.
+ */
+static inline bool raster_tri_setup(RasterTri *t, Vec3 a, Vec3 b, Vec3 c,
+                                    int32_t focal, int16_t cx, int16_t cy, uint16_t color) {
+    const Vec3 *v[3] = {&a, &b, &c};
+    for (int i = 0; i < 3; i++) {
+        int32_t dist = v[i]->z + focal;
+        if (dist <= 0) return false;
+        int32_t sx = ((int32_t)cx << RASTER_SUB) + (v[i]->x >> (Q16_S - RASTER_SUB));
+        int32_t sy = ((int32_t)cy << RASTER_SUB) - (v[i]->y >> (Q16_S - RASTER_SUB));
+        if (sx < -(RASTER_GUARD << RASTER_SUB) || sx > (RASTER_GUARD << RASTER_SUB) ||
+            sy < -(RASTER_GUARD << RASTER_SUB) || sy > (RASTER_GUARD << RASTER_SUB)) return false;
+        t->x[i] = (int16_t)sx;
+        t->y[i] = (int16_t)sy;
+        t->z[i] = depth_log_u16(dist);
+    }
+    t->color = color;
+    return true;
+}
+
+static inline void raster_tri_bounds(const RasterTri *t, int16_t *px0, int16_t *py0, int16_t *px1, int16_t *py1) {
+    int16_t minx = t->x[0], maxx = t->x[0], miny = t->y[0], maxy = t->y[0];
+    for (int i = 1; i < 3; i++) {
+        if (t->x[i] < minx) minx = t->x[i];
+        if (t->x[i] > maxx) maxx = t->x[i];
+        if (t->y[i] < miny) miny = t->y[i];
+        if (t->y[i] > maxy) maxy = t->y[i];
+    }
+    const int16_t half = 1 << (RASTER_SUB - 1);
+    // first and last pixel whose centre lies inside the bounding box
+    *px0 = (int16_t)((minx - half + (1 << RASTER_SUB) - 1) >> RASTER_SUB);
+    *py0 = (int16_t)((miny - half + (1 << RASTER_SUB) - 1) >> RASTER_SUB);
+    *px1 = (int16_t)((maxx - half) >> RASTER_SUB);
+    *py1 = (int16_t)((maxy - half) >> RASTER_SUB);
+}
+
+/**
+ * Counting-sort triangles into per-tile lists. bin_start needs cols * rows + 1 entries;
+ * tile i owns bin_items[bin_start[i] .. bin_start[i + 1]). Triangle order is kept within
+ * a bin. Returns false if more than max_items references would be needed.
+ */
+static inline bool raster_bin(const RasterTri *tris, uint16_t n,
+                              uint16_t screen_w, uint16_t screen_h, uint16_t tile_size,
+                              uint16_t *bin_start, uint16_t *bin_items, uint16_t max_items) {
+    uint16_t cols = (screen_w + tile_size - 1) / tile_size;
+    uint16_t rows = (screen_h + tile_size - 1) / tile_size;
+    uint32_t count = (uint32_t)cols * rows;
+    for (uint32_t i = 0; i <= count; i++) bin_start[i] = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint16_t k = n; k--; ) { // reverse on the fill pass keeps bins in input order
+            int16_t px0, py0, px1, py1;
+            raster_tri_bounds(&tris[k], &px0, &py0, &px1, &py1);
+            if (px1 < 0 || py1 < 0 || px0 >= (int16_t)screen_w || py0 >= (int16_t)screen_h || px0 > px1 || py0 > py1) continue;
+            if (px0 < 0) px0 = 0;
+            if (py0 < 0) py0 = 0;
+            if (px1 >= (int16_t)screen_w) px1 = screen_w - 1;
+            if (py1 >= (int16_t)screen_h) py1 = screen_h - 1;
+            uint16_t tx0 = px0 / tile_size, tx1 = px1 / tile_size;
+            uint16_t ty0 = py0 / tile_size, ty1 = py1 / tile_size;
+            for (uint16_t ty = ty0; ty <= ty1; ty++) {
+                for (uint16_t tx = tx0; tx <= tx1; tx++) {
+                    uint32_t b = (uint32_t)ty * cols + tx;
+                    if (pass == 0) bin_start[b]++;
+                    else bin_items[--bin_start[b]] = k;
+                }
+            }
+        }
+        if (pass == 0) {
+            // inclusive prefix sum: bin_start[b] = end of bin b, decremented back to its start by the fill pass
+            uint32_t total = 0;
+            for (uint32_t b = 0; b < count; b++) {
+                total += bin_start[b];
+                bin_start[b] = (uint16_t)total;
+            }
+            if (total > max_items) return false;
+            bin_start[count] = (uint16_t)total;
+        }
+    }
+    return true;
+}
+
+static inline int32_t raster_clamp_edge(int64_t e) {
+    // An edge this far away cannot change sign within a tile (side <= 256 px)
+    if (e > (1L << 30)) return 1L << 30;
+    if (e < -(1L << 30)) return -(1L << 30);
+    return (int32_t)e;
+}
+
+/**
+ * Rasterize the triangles listed in items[0..count) into one tile at (x0, y0), w x h.
+ * depth_buf holds w * h entries and is reset here. Returns true if any pixel was written.
+ */
+static inline bool raster_tile(const RasterTri *tris, const uint16_t *items, uint16_t count,
+                               uint16_t *color_buf, uint16_t *depth_buf,
+                               int16_t x0, int16_t y0, uint16_t w, uint16_t h) {
+    if (!count) return false;
+    for (uint32_t i = 0, n = (uint32_t)w * h; i < n; i++) depth_buf[i] = 0xFFFF;
+    bool touched = false;
+
+    for (uint16_t k = 0; k < count; k++) {
+        const RasterTri *t = &tris[items[k]];
+        int32_t ax = t->x[0], ay = t->y[0], bx = t->x[1], by = t->y[1], cx = t->x[2], cy = t->y[2];
+        int32_t za = t->z[0], zb = t->z[1], zc = t->z[2];
+        int64_t area = (int64_t)(bx - ax) * (cy - ay) - (int64_t)(by - ay) * (cx - ax);
+        if (area == 0) continue;
+        if (area < 0) {
+            int32_t tmp;
+            tmp = bx; bx = cx; cx = tmp;
+            tmp = by; by = cy; cy = tmp;
+            tmp = zb; zb = zc; zc = tmp;
+            area = -area;
+        }
+
+        int16_t px0, py0, px1, py1;
+        raster_tri_bounds(t, &px0, &py0, &px1, &py1);
+        if (px0 < x0) px0 = x0;
+        if (py0 < y0) py0 = y0;
+        if (px1 > x0 + (int16_t)w - 1) px1 = x0 + w - 1;
+        if (py1 > y0 + (int16_t)h - 1) py1 = y0 + h - 1;
+        if (px0 > px1 || py0 > py1) continue;
+
+        // Edge p->q: E(s) = (q.x - p.x) * (s.y - p.y) - (q.y - p.y) * (s.x - p.x), positive inside
+        int32_t ex[3] = {cx - bx, ax - cx, bx - ax};
+        int32_t ey[3] = {cy - by, ay - cy, by - ay};
+        int32_t epx[3] = {bx, cx, ax};
+        int32_t epy[3] = {by, cy, ay};
+        int32_t sx = ((int32_t)px0 << RASTER_SUB) + (1 << (RASTER_SUB - 1));
+        int32_t sy = ((int32_t)py0 << RASTER_SUB) + (1 << (RASTER_SUB - 1));
+
+        int32_t row[3], ddx[3], ddy[3];
+        int64_t e64[3];
+        for (int i = 0; i < 3; i++) {
+            e64[i] = (int64_t)ex[i] * (sy - epy[i]) - (int64_t)ey[i] * (sx - epx[i]);
+            bool top_left = (ey[i] == 0 && ex[i] > 0) || ey[i] < 0;
+            row[i] = raster_clamp_edge(e64[i] - (top_left ? 0 : 1));
+            ddx[i] = -ey[i] << RASTER_SUB;
+            ddy[i] = ex[i] << RASTER_SUB;
+        }
+
+        // Depth plane in Q8 from the barycentric weights E_i / area. Kept in 64 bits: a sliver
+        // with a small area has huge gradients, and outside the triangle the plane runs far
+        // past 32 bits before the span reaches the pixels that are covered.
+        int64_t zrow = ((e64[0] * za + e64[1] * zb + e64[2] * zc) << 8) / area;
+        int64_t dzdx = (((int64_t)ddx[0] * za + (int64_t)ddx[1] * zb + (int64_t)ddx[2] * zc) << 8) / area;
+        int64_t dzdy = (((int64_t)ddy[0] * za + (int64_t)ddy[1] * zb + (int64_t)ddy[2] * zc) << 8) / area;
+
+        uint16_t color = t->color;
+        uint32_t off = (uint32_t)(py0 - y0) * w + (uint32_t)(px0 - x0);
+        for (int16_t py = py0; py <= py1; py++, off += w) {
+            int32_t e0 = row[0], e1 = row[1], e2 = row[2];
+            int64_t z = zrow;
+            uint16_t *cp = color_buf + off;
+            uint16_t *dp = depth_buf + off;
+            for (int16_t px = px0; px <= px1; px++, cp++, dp++) {
+                if ((e0 | e1 | e2) >= 0) {
+                    int64_t zz = z >> 8;
+                    if (zz < 0) zz = 0;
+                    if (zz < *dp) {
+                        *dp = (uint16_t)zz;
+                        *cp = color;
+                        touched = true;
+                    }
+                }
+                e0 += ddx[0]; e1 += ddx[1]; e2 += ddx[2];
+                z += dzdx;
+            }
+            row[0] += ddy[0]; row[1] += ddy[1]; row[2] += ddy[2];
+            zrow += dzdy;
+        }
+    }
+    return touched;
+}
+
+} // namespace FMT
+
+#endif
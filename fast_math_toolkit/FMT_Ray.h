@@ -0,0 +1,334 @@
+#ifndef FMT_RAY_H
+#define FMT_RAY_H
+
+#include "FMT_3d.h"
+#include "FMT_Cull.h"
+#include "FMT_Light.h"
+
+namespace FMT {
+
+/**
+ * Fixed-point ray caster over spheres and planes.
+ *
+ * Spheres sit in a flat BVH (depth-first node array, left child follows its parent) and are
+ * traversed by 2x2 ray packets: a node is entered if any ray of the packet hits its box.
+ * Each ray carries per-axis reciprocals of its direction so the slab tests are multiplies only;
+ * planes divide once per accepted hit. Coordinates are Q16.16 and the scene should fit in
+ * about +-100 units so squared distances stay in range.
+ */
+
+enum {
+    RAY_PACKET = 4,
+    RAY_LEAF_SIZE = 2,
+    RAY_STACK = 32,
+    RAY_PLANE_HIT = 0x8000,
+    RAY_NO_HIT = 0xFFFF
+};
+
+#define RAY_T_MAX 0x7FFFFFFF
+
+typedef struct {
+    Vec3 c;
+    int32_t r;
+    uint8_t material;
+} RaySphere;
+
+typedef struct {
+    Plane p;
+    uint8_t material;
+} RayPlane;
+
+typedef struct {
+    Vec3 lo, hi;
+    uint16_t index; // interior: right child; leaf: first entry of the sphere index list
+    uint16_t count; // spheres in a leaf, 0 for interior nodes; large when max_nodes ran out
+    uint8_t axis;   // split axis, used to visit the nearer child first
+} RayNode;
+
+typedef struct {
+    const RaySphere *spheres;
+    const uint16_t *sphere_idx; // leaf order written by ray_bvh_build
+    const RayNode *nodes;
+    uint16_t node_count;
+    const RayPlane *planes;
+    uint8_t plane_count;
+    const Material *materials;
+    const Light *lights;
+    uint8_t light_count;
+    uint16_t ambient;    // Q8, see light_vertex
+    uint16_t background; // RGB565
+} RayScene;
+
+typedef struct {
+    Vec3 eye;
+    Mat3 basis;      // camera to world rotation; looks along +z with y up like project_perspective
+    int32_t focal;   // pixels, Q16.16
+    int16_t cx, cy;  // screen centre in pixels
+} RayCamera;
+
+typedef struct {
+    Vec3 o, d;    // d unit length, see ray_normalize
+    Vec3 inv;     // 1 / d per axis, saturated
+    int32_t t;    // nearest hit so far
+    uint16_t hit; // sphere index, RAY_PLANE_HIT | plane index, or RAY_NO_HIT
+} Ray;
+
+static inline int32_t vec3_axis(Vec3 v, uint8_t axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+static inline int32_t ray_recip(int32_t d) {
+    if (d > -2 && d < 2) return d < 0 ? -RAY_T_MAX : RAY_T_MAX;
+    int64_t r = ((int64_t)1 << 32) / d;
+    if (r > RAY_T_MAX) return RAY_T_MAX;
+    if (r < -RAY_T_MAX) return -RAY_T_MAX;
+    return (int32_t)r;
+}
+
+// vec3_normalize plus one Newton step on the length: the sphere test needs |d| = 1 to ~1e-4,
+// well beyond the log-domain inverse square root alone
+static inline Vec3 ray_normalize(Vec3 v) {
+    v = vec3_normalize(v);
+    int32_t k = (3 * Q16_ONE - vec3_dot(v, v)) >> 1;
+    return vec3_init(q16_mul_s(v.x, k), q16_mul_s(v.y, k), q16_mul_s(v.z, k));
+}
+
+static inline void ray_init(Ray *ray, Vec3 o, Vec3 d) {
+    ray->o = o;
+    ray->d = d;
+    ray->inv = vec3_init(ray_recip(d.x), ray_recip(d.y), ray_recip(d.z));
+    ray->t = RAY_T_MAX;
+    ray->hit = RAY_NO_HIT;
+}
+
+// Slab test with the precomputed reciprocals: six multiplies, no division
+static inline bool ray_hit_box(const Ray *ray, Vec3 lo, Vec3 hi) {
+    int64_t tmin = 0, tmax = ray->t;
+    for (uint8_t a = 0; a < 3; a++) {
+        int32_t o = vec3_axis(ray->o, a), inv = vec3_axis(ray->inv, a);
+        int64_t t0 = ((int64_t)(vec3_axis(lo, a) - o) * inv) >> Q16_S;
+        int64_t t1 = ((int64_t)(vec3_axis(hi, a) - o) * inv) >> Q16_S;
+        if (inv < 0) { int64_t tmp = t0; t0 = t1; t1 = tmp; }
+        if (t0 > tmin) tmin = t0;
+        if (t1 < tmax) tmax = t1;
+        if (tmin > tmax) return false;
+    }
+    return true;
+}
+
+static inline void ray_hit_sphere(Ray *ray, const RaySphere *s, uint16_t id) {
+    Vec3 L = vec3_sub(ray->o, s->c);
+    int32_t b = vec3_dot(ray->d, L);
+    int32_t c = vec3_dot(L, L) - q16_mul_s(s->r, s->r);
+    if (c > 0 && b > 0) return; // outside and pointing away
+    int32_t discr = q16_mul_s(b, b) - c;
+    if (discr < 0) return;
+    int32_t sq = (int32_t)q16_sqrt((uint32_t)discr);
+    int32_t t = -b - sq;
+    if (t < 0) t = -b + sq;
+    if (t >= 0 && t < ray->t) {
+        ray->t = t;
+        ray->hit = id;
+    }
+}
+
+// t = -(n.o + d) / (n.d); the range check against the current hit is cross-multiplied so only accepted hits divide
+static inline void ray_hit_plane(Ray *ray, const Plane *p, uint16_t id) {
+    int32_t den = vec3_dot(p->n, ray->d);
+    if (den == 0) return;
+    int32_t num = -(vec3_dot(p->n, ray->o) + p->d);
+    if (den < 0) { num = -num; den = -den; }
+    if (num < 0) return;
+    if ((int64_t)num << Q16_S >= (int64_t)ray->t * den) return;
+    ray->t = q16_div_s(num, den);
+    ray->hit = id;
+}
+
+static inline void ray_sphere_bounds(const RaySphere *s, Vec3 *lo, Vec3 *hi) {
+    *lo = vec3_init(s->c.x - s->r, s->c.y - s->r, s->c.z - s->r);
+    *hi = vec3_init(s->c.x + s->r, s->c.y + s->r, s->c.z + s->r);
+}
+
+// budget is how many nodes this subtree may use, itself included
+static inline uint16_t ray_bvh_split(RayNode *nodes, uint16_t *count, uint16_t budget,
+                                     uint16_t *idx, const RaySphere *s, uint16_t first, uint16_t n) {
+    uint16_t self = (*count)++;
+    RayNode *node = &nodes[self];
+    Vec3 clo = s[idx[first]].c, chi = clo;
+    ray_sphere_bounds(&s[idx[first]], &node->lo, &node->hi);
+    for (uint16_t i = first + 1; i < first + n; i++) {
+        Vec3 lo, hi, c = s[idx[i]].c;
+        ray_sphere_bounds(&s[idx[i]], &lo, &hi);
+        if (lo.x < node->lo.x) node->lo.x = lo.x;
+        if (lo.y < node->lo.y) node->lo.y = lo.y;
+        if (lo.z < node->lo.z) node->lo.z = lo.z;
+        if (hi.x > node->hi.x) node->hi.x = hi.x;
+        if (hi.y > node->hi.y) node->hi.y = hi.y;
+        if (hi.z > node->hi.z) node->hi.z = hi.z;
+        if (c.x < clo.x) clo.x = c.x;
+        if (c.y < clo.y) clo.y = c.y;
+        if (c.z < clo.z) clo.z = c.z;
+        if (c.x > chi.x) chi.x = c.x;
+        if (c.y > chi.y) chi.y = c.y;
+        if (c.z > chi.z) chi.z = c.z;
+    }
+    node->axis = 0;
+    if (n <= RAY_LEAF_SIZE || budget < 3) {
+        node->index = first;
+        node->count = n;
+        return self;
+    }
+
+    // Median split along the widest spread of centres
+    Vec3 ext = vec3_sub(chi, clo);
+    uint8_t axis = (ext.y > ext.x) ? 1 : 0;
+    if (ext.z > vec3_axis(ext, axis)) axis = 2;
+    for (uint16_t i = first + 1; i < first + n; i++) {
+        uint16_t v = idx[i];
+        int32_t key = vec3_axis(s[v].c, axis);
+        uint16_t j = i;
+        while (j > first && vec3_axis(s[idx[j - 1]].c, axis) > key) {
+            idx[j] = idx[j - 1];
+            j--;
+        }
+        idx[j] = v;
+    }
+    uint16_t half = n >> 1;
+    node->axis = axis;
+    node->count = 0;
+    // Share the budget by sphere count; the left side gets at most budget - 2, so the
+    // right child always has a slot and takes whatever the left one left over
+    uint16_t left = (uint16_t)((uint32_t)(budget - 1) * half / n);
+    if (!left) left = 1;
+    uint16_t before = *count;
+    ray_bvh_split(nodes, count, left, idx, s, first, half);
+    uint16_t right = budget - 1 - (*count - before);
+    node->index = ray_bvh_split(nodes, count, right, idx, s, first + half, n - half);
+    return self;
+}
+
+/**
+ * Build the BVH over n spheres. idx receives the leaf order (n entries), nodes at most
+ * max_nodes entries (2 * n is always enough; with fewer, subtrees get a share of the budget
+ * by sphere count and turn into bigger leaves once it runs out). Returns the node
+ * count, 0 for an empty scene. The median split keeps the depth to about log2(n), well
+ * within RAY_STACK.
+ */
+static inline uint16_t ray_bvh_build(RayNode *nodes, uint16_t max_nodes, uint16_t *idx,
+                                     const RaySphere *spheres, uint16_t n) {
+    if (!n || !max_nodes) return 0;
+    for (uint16_t i = 0; i < n; i++) idx[i] = i;
+    uint16_t count = 0;
+    ray_bvh_split(nodes, &count, max_nodes, idx, spheres, 0, n);
+    return count;
+}
+
+// Leaves laid out like ray_bvh_build's cover one contiguous run of sphere_idx per subtree,
+// from its leftmost leaf to the end of its rightmost one
+static inline void ray_trace_subtree(const RayScene *scene, const RayNode *node, Ray *rays,
+                                     uint8_t count, uint8_t mask) {
+    const RayNode *first = node, *last = node;
+    while (!first->count) first++;
+    while (!last->count) last = &scene->nodes[last->index];
+    for (uint16_t i = first->index; i < last->index + last->count; i++) {
+        uint16_t id = scene->sphere_idx[i];
+        for (uint8_t k = 0; k < count; k++) {
+            if (mask & (1 << k)) ray_hit_sphere(&rays[k], &scene->spheres[id], id);
+        }
+    }
+}
+
+// Trace 1..RAY_PACKET rays that share one BVH walk; results land in each ray's t/hit
+static inline void ray_trace_packet(const RayScene *scene, Ray *rays, uint8_t count) {
+    if (scene->node_count) {
+        uint16_t stack[RAY_STACK];
+        uint8_t sp = 0;
+        stack[sp++] = 0;
+        while (sp) {
+            const RayNode *node = &scene->nodes[stack[--sp]];
+            uint8_t mask = 0;
+            for (uint8_t k = 0; k < count; k++) {
+                if (ray_hit_box(&rays[k], node->lo, node->hi)) mask |= (uint8_t)(1 << k);
+            }
+            if (!mask) continue;
+            if (node->count) {
+                for (uint16_t i = node->index; i < node->index + node->count; i++) {
+                    uint16_t id = scene->sphere_idx[i];
+                    for (uint8_t k = 0; k < count; k++) {
+                        if (mask & (1 << k)) ray_hit_sphere(&rays[k], &scene->spheres[id], id);
+                    }
+                }
+                continue;
+            }
+            uint16_t left = (uint16_t)(node - scene->nodes) + 1, right = node->index;
+            if (sp + 2 > RAY_STACK) {
+                // Deeper than ray_bvh_build ever goes: test the whole subtree without the boxes
+                ray_trace_subtree(scene, node, rays, count, mask);
+                continue;
+            }
+            // Push the far child first so the near one is popped next
+            if (vec3_axis(rays[0].d, node->axis) < 0) {
+                stack[sp++] = left;
+                stack[sp++] = right;
+            } else {
+                stack[sp++] = right;
+                stack[sp++] = left;
+            }
+        }
+    }
+    for (uint8_t i = 0; i < scene->plane_count; i++) {
+        for (uint8_t k = 0; k < count; k++) ray_hit_plane(&rays[k], &scene->planes[i].p, RAY_PLANE_HIT | i);
+    }
+}
+
+static inline uint16_t ray_shade(const RayScene *scene, const Ray *ray) {
+    if (ray->hit == RAY_NO_HIT) return scene->background;
+    Vec3 p = vec3_add(ray->o, vec3_init(q16_mul_s(ray->d.x, ray->t), q16_mul_s(ray->d.y, ray->t), q16_mul_s(ray->d.z, ray->t)));
+    Vec3 n;
+    uint8_t material;
+    if (ray->hit & RAY_PLANE_HIT) {
+        const RayPlane *pl = &scene->planes[ray->hit & ~RAY_PLANE_HIT];
+        n = pl->p.n;
+        material = pl->material;
+    } else {
+        const RaySphere *s = &scene->spheres[ray->hit];
+        n = vec3_normalize_ap(vec3_sub(p, s->c));
+        material = s->material;
+    }
+    return light_vertex(scene->lights, scene->light_count, &scene->materials[material], p, n, ray->o, scene->ambient);
+}
+
+static inline Vec3 ray_camera_dir(const RayCamera *cam, int16_t px, int16_t py) {
+    // Pixel centre relative to the screen centre; >> 4 keeps the squared length in range for wide views
+    Vec3 d = vec3_init((((int32_t)(px - cam->cx) << Q16_S) + (Q16_ONE >> 1)) >> 4,
+                       (((int32_t)(cam->cy - py) << Q16_S) - (Q16_ONE >> 1)) >> 4,
+                       cam->focal >> 4);
+    return mat3_mul_vec(&cam->basis, ray_normalize(d));
+}
+
+/**
+ * Render the w x h tile at (x0, y0) into an RGB565 tile buffer (row stride w), tracing
+ * 2x2 pixel blocks as packets.
+ */
+static inline void ray_render_tile(const RayScene *scene, const RayCamera *cam, uint16_t *buf,
+                                   int16_t x0, int16_t y0, uint16_t w, uint16_t h) {
+    Ray rays[RAY_PACKET];
+    uint16_t offs[RAY_PACKET];
+    for (uint16_t y = 0; y < h; y += 2) {
+        for (uint16_t x = 0; x < w; x += 2) {
+            uint8_t count = 0;
+            for (uint8_t k = 0; k < RAY_PACKET; k++) {
+                uint16_t px = x + (k & 1), py = y + (k >> 1);
+                if (px >= w || py >= h) continue;
+                ray_init(&rays[count], cam->eye, ray_camera_dir(cam, x0 + px, y0 + py));
+                offs[count++] = py * w + px;
+            }
+            ray_trace_packet(scene, rays, count);
+            for (uint8_t k = 0; k < count; k++) buf[offs[k]] = ray_shade(scene, &rays[k]);
+        }
+    }
+}
+
+} // namespace FMT
+
+#endif
@@ -74,6 +74,20 @@ static inline Log32 log32_pow(const Log32 &a, float k) {
     return r;
 }
 
+/**
+ * log2(2^a + 2^b) for Q8.8 log values using the LogSumExp correction table.
+ */
+static inline int32_t log2_add_q8(int32_t a, int32_t b) {
+    int32_t hi = a, diff = a - b;
+    if (diff < 0) {
+        hi = b;
+        diff = -diff;
+    }
+    uint32_t table_idx = (uint32_t)diff >> 3;
+    if (table_idx > 255) table_idx = 255;
+    return hi + (int32_t)FMT_READ16(lse_table_q8, (uint16_t)table_idx);
+}
+
 static inline Log32 log32_add(const Log32 &a, const Log32 &b) {
     if (a.sign == 0) return b;
     if (b.sign == 0) return a;
@@ -81,16 +95,7 @@ static inline Log32 log32_add(const Log32 &a, const Log32 &b) {
     if (a.sign == b.sign) {
         Log32 r;
         r.sign = a.sign;
-        int16_t diff = a.lval - b.lval;
-        if (diff >= 0) {
-            uint16_t table_idx = (uint16_t)(diff >> 3);
-            if (table_idx > 255) table_idx = 255;
-            r.lval = a.lval + (int16_t)FMT_READ16(lse_table_q8, table_idx);
-        } else {
-            uint16_t table_idx = (uint16_t)((-diff) >> 3);
-            if (table_idx > 255) table_idx = 255;
-            r.lval = b.lval + (int16_t)FMT_READ16(lse_table_q8, table_idx);
-        }
+        r.lval = (int16_t)log2_add_q8(a.lval, b.lval);
         return r;
     } else {
         return to_log32(from_log32(a) + from_log32(b));
@@ -0,0 +1,221 @@
+#ifndef FMT_SDF_H
+#define FMT_SDF_H
+
+#include "FMT_3d.h"
+#include "FMT_Light.h"
+#include "FMT_Ray.h"
+
+namespace FMT {
+
+/**
+ * Signed-distance-field sphere tracer in Q16.16.
+ *
+ * A scene is a flat list of primitives folded left to right with a per-primitive combinator,
+ * so procedural scenes need no mesh storage. Lengths go through the log-domain q16_sqrt and
+ * vec3_normalize; like FMT_Ray, keep the scene within about +-100 units.
+ */
+
+enum {
+    SDF_SPHERE, // size.x = radius
+    SDF_BOX,    // size = half extents
+    SDF_PLANE,  // c = unit normal, size.x = offset d (n.p + d)
+    SDF_TORUS   // around the y axis, size.x = major radius, size.y = minor radius
+};
+
+enum {
+    SDF_OP_UNION,
+    SDF_OP_SMOOTH,    // smooth union with radius k
+    SDF_OP_SUBTRACT,  // carve this primitive out of everything before it
+    SDF_OP_INTERSECT
+};
+
+typedef struct {
+    uint8_t type;
+    uint8_t op;
+    uint8_t material;
+    Vec3 c;
+    Vec3 size;
+    int32_t k;
+} SdfPrim;
+
+typedef struct {
+    const SdfPrim *prims;
+    uint8_t count;
+    const Material *materials;
+    const Light *lights;
+    uint8_t light_count;
+    uint16_t ambient;    // Q8, see light_vertex
+    uint16_t background; // RGB565
+} SdfScene;
+
+static inline int32_t sdf_sphere(Vec3 p, Vec3 c, int32_t r) {
+    return vec3_length(vec3_sub(p, c)) - r;
+}
+
+static inline int32_t sdf_box(Vec3 p, Vec3 c, Vec3 half) {
+    Vec3 q = vec3_sub(p, c);
+    q.x = (q.x < 0 ? -q.x : q.x) - half.x;
+    q.y = (q.y < 0 ? -q.y : q.y) - half.y;
+    q.z = (q.z < 0 ? -q.z : q.z) - half.z;
+    int32_t inside = q.x > q.y ? q.x : q.y;
+    if (q.z > inside) inside = q.z;
+    if (inside > 0) inside = 0;
+    return vec3_length(vec3_init(q.x > 0 ? q.x : 0, q.y > 0 ? q.y : 0, q.z > 0 ? q.z : 0)) + inside;
+}
+
+static inline int32_t sdf_plane(Vec3 p, Vec3 n, int32_t d) {
+    return vec3_dot(n, p) + d;
+}
+
+static inline int32_t sdf_torus(Vec3 p, Vec3 c, int32_t major, int32_t minor) {
+    Vec3 q = vec3_sub(p, c);
+    uint32_t r2 = (uint32_t)(((int64_t)q.x * q.x + (int64_t)q.z * q.z) >> Q16_S);
+    int32_t ring = (int32_t)q16_sqrt(r2) - major;
+    uint32_t d2 = (uint32_t)(((int64_t)ring * ring + (int64_t)q.y * q.y) >> Q16_S);
+    return (int32_t)q16_sqrt(d2) - minor;
+}
+
+// Polynomial smooth minimum: min(a, b) - max(k - |a - b|, 0)^2 / 4k; divides only where the shapes blend
+static inline int32_t sdf_smin(int32_t a, int32_t b, int32_t k) {
+    int32_t m = a < b ? a : b;
+    int32_t diff = a - b;
+    int32_t h = k - (diff < 0 ? -diff : diff);
+    if (h <= 0 || k <= 0) return m;
+    return m - q16_div_s(q16_mul_s(h, h), k << 2);
+}
+
+static inline int32_t sdf_prim(const SdfPrim *s, Vec3 p) {
+    switch (s->type) {
+    case SDF_SPHERE: return sdf_sphere(p, s->c, s->size.x);
+    case SDF_BOX:    return sdf_box(p, s->c, s->size);
+    case SDF_PLANE:  return sdf_plane(p, s->c, s->size.x);
+    default:         return sdf_torus(p, s->c, s->size.x, s->size.y);
+    }
+}
+
+// Distance to the whole scene; material (optional) is that of the nearest contributing primitive
+static inline int32_t sdf_scene_eval(const SdfScene *scene, Vec3 p, uint8_t *material) {
+    int32_t d = RAY_T_MAX;
+    uint8_t mat = 0;
+    for (uint8_t i = 0; i < scene->count; i++) {
+        const SdfPrim *s = &scene->prims[i];
+        int32_t e = sdf_prim(s, p);
+        switch (s->op) {
+        case SDF_OP_SMOOTH:
+            if (e < d) mat = s->material;
+            d = sdf_smin(d, e, s->k);
+            break;
+        case SDF_OP_SUBTRACT:
+            if (-e > d) d = -e;
+            break;
+        case SDF_OP_INTERSECT:
+            if (e > d) d = e;
+            break;
+        default:
+            if (e < d) { d = e; mat = s->material; }
+            break;
+        }
+    }
+    if (material) *material = mat;
+    return d;
+}
+
+/**
+ * March from t_start along the unit direction d for at most max_steps evaluations.
+ * The hit threshold grows with distance (t / 256, at least 1/256 unit), which is about
+ * one pixel for a 256-pixel focal length. Returns true on a hit with *t_out set; on a
+ * miss *t_out is where marching stopped (t_max once the scene is known to be clear).
+ *
+ * With safe_out, a march that starts at the eye also reports how far the empty spheres it
+ * stepped through stay contiguous for any ray within cone radians (Q16.16) of d: a point at
+ * distance s on such a ray is within s * cone of this ray, so the sphere of radius r at t
+ * still covers it for |s - t| <= r - (t + r) * cone.
+ */
+static inline bool sdf_march_cone(const SdfScene *scene, Vec3 o, Vec3 d, int32_t t_start, int32_t t_max,
+                                  uint8_t max_steps, int32_t cone, int32_t *t_out, uint8_t *material,
+                                  int32_t *safe_out) {
+    int32_t t = t_start, safe = 0;
+    bool chained = safe_out && t_start == 0;
+    bool hit = false;
+    for (uint8_t i = 0; i < max_steps && t < t_max; i++) {
+        Vec3 p = vec3_init(o.x + q16_mul_s(d.x, t), o.y + q16_mul_s(d.y, t), o.z + q16_mul_s(d.z, t));
+        int32_t dist = sdf_scene_eval(scene, p, material);
+        int32_t eps = (t >> 8) > (Q16_ONE >> 8) ? (t >> 8) : (Q16_ONE >> 8);
+        if (dist < eps) {
+            hit = true;
+            break;
+        }
+        if (dist > t_max - t) dist = t_max - t;
+        if (chained) {
+            int32_t h = dist - q16_mul_s(t + dist, cone);
+            if (h > 0 && t - h <= safe) {
+                if (t + h > safe) safe = t + h;
+            } else {
+                chained = false;
+            }
+        }
+        t += dist;
+    }
+    *t_out = t;
+    if (safe_out) *safe_out = safe;
+    return hit;
+}
+
+static inline bool sdf_march(const SdfScene *scene, Vec3 o, Vec3 d, int32_t t_start, int32_t t_max,
+                             uint8_t max_steps, int32_t *t_out, uint8_t *material) {
+    return sdf_march_cone(scene, o, d, t_start, t_max, max_steps, 0, t_out, material, 0);
+}
+
+// Gradient from four tetrahedral taps instead of six central differences
+static inline Vec3 sdf_normal(const SdfScene *scene, Vec3 p) {
+    const int32_t e = Q16_ONE >> 6;
+    int32_t a = sdf_scene_eval(scene, vec3_init(p.x + e, p.y - e, p.z - e), 0);
+    int32_t b = sdf_scene_eval(scene, vec3_init(p.x - e, p.y - e, p.z + e), 0);
+    int32_t c = sdf_scene_eval(scene, vec3_init(p.x - e, p.y + e, p.z - e), 0);
+    int32_t f = sdf_scene_eval(scene, vec3_init(p.x + e, p.y + e, p.z + e), 0);
+    return vec3_normalize(vec3_init(a - b - c + f, -a - b + c + f, -a + b - c + f));
+}
+
+/**
+ * Render the w x h tile at (x0, y0) into an RGB565 tile buffer (row stride w).
+ * row_t (w entries, may be NULL) carries each column's safe distance down the tile: a pixel
+ * whose neighbour above marched from the eye starts at the largest safe distance of the
+ * three pixels above it, computed for a cone of two pixels so that any of them is a valid
+ * bound. Pixels that start there report no safe distance themselves, so the next row marches
+ * from the eye again; roughly every other row skips the empty space in front of the scene.
+ */
+static inline void sdf_render_tile(const SdfScene *scene, const RayCamera *cam, uint16_t *buf,
+                                   int16_t x0, int16_t y0, uint16_t w, uint16_t h,
+                                   int32_t t_max, uint8_t max_steps, int32_t *row_t) {
+    int32_t cone = q16_div_s(2 * Q16_ONE, cam->focal);
+    if (row_t) {
+        for (uint16_t x = 0; x < w; x++) row_t[x] = 0;
+    }
+    for (uint16_t y = 0; y < h; y++) {
+        int32_t left_above = 0; // row_t[x - 1] before this row overwrote it
+        for (uint16_t x = 0; x < w; x++) {
+            Vec3 d = ray_camera_dir(cam, x0 + x, y0 + y);
+            int32_t t0 = 0;
+            if (row_t) {
+                t0 = row_t[x];
+                if (left_above > t0) t0 = left_above;
+                if (x + 1 < w && row_t[x + 1] > t0) t0 = row_t[x + 1];
+                left_above = row_t[x];
+            }
+            int32_t t;
+            uint8_t mat = 0;
+            bool hit = sdf_march_cone(scene, cam->eye, d, t0, t_max, max_steps, cone, &t, &mat, row_t ? &row_t[x] : 0);
+            if (!hit) {
+                buf[y * w + x] = scene->background;
+                continue;
+            }
+            Vec3 p = vec3_init(cam->eye.x + q16_mul_s(d.x, t), cam->eye.y + q16_mul_s(d.y, t), cam->eye.z + q16_mul_s(d.z, t));
+            buf[y * w + x] = light_vertex(scene->lights, scene->light_count, &scene->materials[mat],
+                                          p, sdf_normal(scene, p), cam->eye, scene->ambient);
+        }
+    }
+}
+
+} // namespace FMT
+
+#endif
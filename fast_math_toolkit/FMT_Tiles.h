@@ -0,0 +1,745 @@
+#ifndef FMT_TILES_H
+#define FMT_TILES_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(ESP32) || defined(ESP_PLATFORM)
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#define FMT_TILE_MALLOC(n) heap_caps_malloc((n), MALLOC_CAP_DMA | MALLOC_CAP_8BIT)
+#define FMT_TILE_FREERTOS 1
+#else
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#define FMT_TILE_MALLOC(n) malloc(n)
+#endif
+#include <atomic>
+
+// Let other tasks run while waiting on a transfer
+#if defined(ARDUINO)
+#define FMT_TILE_YIELD() yield()
+#elif defined(FMT_TILE_FREERTOS)
+#define FMT_TILE_YIELD() taskYIELD()
+#else
+#define FMT_TILE_YIELD() std::this_thread::yield()
+#endif
+
+#ifndef FMT_TILE_TASK_STACK
+#define FMT_TILE_TASK_STACK 4096 // bytes per worker task on ESP32; render() runs on it
+#endif
+
+namespace FMT {
+
+/**
+ * Dirty-rectangle tile compositor (include this header explicitly; FMT.h does not).
+ *
+ * The screen is split into tiles of at most 256 x 256 pixels, each with its own pixel
+ * buffer and two dirty boxes in tile-local coordinates: what was drawn this frame and
+ * what was drawn last frame. startFrame() clears only the pixels drawn last frame and
+ * flush() pushes only the union of the two boxes, so a tile where one glyph moved by a
+ * pixel costs a few rows of SPI traffic rather than the whole buffer. Pixel is uint16_t
+ * for RGB565 panels or uint8_t for grayscale ones.
+ *
+ * Immediate mode (init with pool = 0) gives every tile a persistent buffer: draw anywhere
+ * with writePixelGlobal/drawLine between startFrame() and flush(). Streaming mode (pool > 0)
+ * keeps only a few tile-sized buffers and renderTiles() draws the frame one tile at a time,
+ * so the next tile is rendered while the previous one is still being transferred. Calls
+ * for the other mode return false and do nothing; the pixel-level drawing calls are for
+ * immediate mode only.
+ *
+ * The display is reached through a sink:
+ *
+ *   uint32_t push(uint16_t x, uint16_t y, uint16_t w, uint16_t h, Pixel *data); // w * h, packed
+ *   void wait();          // return once every pushed buffer may be overwritten again
+ *   uint32_t completed(); // pushes finished so far (streaming mode only)
+ *
+ * push() returns how many pushes the sink has started, this one included.
+ *
+ * TilePushImage wraps a device with a blocking pushImage(x, y, w, h, data), TileDmaPush one
+ * with pushImageDMA/dmaBusy (LovyanGFX, TFT_eSPI; call between startWrite and endWrite).
+ *
+ * renderTilesParallel() spreads an immediate-mode frame over a TileWorkers pool (FreeRTOS
+ * tasks on ESP32, std::thread elsewhere) and returns once every tile is rendered, so the
+ * flush() that follows runs on the calling thread as usual.
+ */
+
+// Inclusive tile-local box; empty when x0 > x1
+typedef struct {
+    uint8_t x0, y0, x1, y1;
+} TileBox;
+
+static inline TileBox tile_box_empty(void) {
+    TileBox b = {0xFF, 0xFF, 0, 0};
+    return b;
+}
+
+static inline bool tile_box_is_empty(TileBox b) { return b.x0 > b.x1; }
+
+static inline void tile_box_add(TileBox *b, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+    if (x0 < b->x0) b->x0 = x0;
+    if (y0 < b->y0) b->y0 = y0;
+    if (x1 > b->x1) b->x1 = x1;
+    if (y1 > b->y1) b->y1 = y1;
+}
+
+static inline TileBox tile_box_union(TileBox a, TileBox b) {
+    if (tile_box_is_empty(a)) return b;
+    if (!tile_box_is_empty(b)) tile_box_add(&a, b.x0, b.y0, b.x1, b.y1);
+    return a;
+}
+
+// Screen-space inclusive rectangle, e.g. the bounds of a display-list entry for tile_bin
+typedef struct {
+    int16_t x0, y0, x1, y1;
+} TileRect;
+
+/**
+ * Counting-sort rectangles into per-tile lists, like raster_bin. bin_start needs
+ * cols * rows + 1 entries; tile i owns items[bin_start[i] .. bin_start[i + 1]), in input
+ * order. Returns false if more than max_items references would be needed.
+ */
+static inline bool tile_bin(const TileRect *rects, uint16_t n,
+                            uint16_t screen_w, uint16_t screen_h, uint16_t tile_size,
+                            uint16_t *bin_start, uint16_t *bin_items, uint16_t max_items) {
+    uint16_t cols = (screen_w + tile_size - 1) / tile_size;
+    uint16_t rows = (screen_h + tile_size - 1) / tile_size;
+    uint32_t count = (uint32_t)cols * rows;
+    for (uint32_t i = 0; i <= count; i++) bin_start[i] = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint16_t k = n; k--; ) {
+            int16_t px0 = rects[k].x0, py0 = rects[k].y0, px1 = rects[k].x1, py1 = rects[k].y1;
+            if (px1 < 0 || py1 < 0 || px0 >= (int16_t)screen_w || py0 >= (int16_t)screen_h || px0 > px1 || py0 > py1) continue;
+            if (px0 < 0) px0 = 0;
+            if (py0 < 0) py0 = 0;
+            if (px1 >= (int16_t)screen_w) px1 = screen_w - 1;
+            if (py1 >= (int16_t)screen_h) py1 = screen_h - 1;
+            uint16_t tx0 = px0 / tile_size, tx1 = px1 / tile_size;
+            uint16_t ty0 = py0 / tile_size, ty1 = py1 / tile_size;
+            for (uint16_t ty = ty0; ty <= ty1; ty++) {
+                for (uint16_t tx = tx0; tx <= tx1; tx++) {
+                    uint32_t b = (uint32_t)ty * cols + tx;
+                    if (pass == 0) bin_start[b]++;
+                    else bin_items[--bin_start[b]] = k;
+                }
+            }
+        }
+        if (pass == 0) {
+            uint32_t total = 0;
+            for (uint32_t b = 0; b < count; b++) {
+                total += bin_start[b];
+                bin_start[b] = (uint16_t)total;
+            }
+            if (total > max_items) return false;
+            bin_start[count] = (uint16_t)total;
+        }
+    }
+    return true;
+}
+
+template <class Dev>
+struct TilePushImage {
+    Dev *dev;
+    uint32_t pushes;
+    template <class Pixel>
+    uint32_t push(uint16_t x, uint16_t y, uint16_t w, uint16_t h, Pixel *data) {
+        dev->pushImage(x, y, w, h, data);
+        return ++pushes;
+    }
+    void wait() {}
+    uint32_t completed() { return pushes; }
+};
+
+template <class Dev>
+static inline TilePushImage<Dev> tile_push_image(Dev &dev) {
+    TilePushImage<Dev> s = {&dev, 0};
+    return s;
+}
+
+// Relies on the driver finishing one DMA transfer before it starts the next
+template <class Dev>
+struct TileDmaPush {
+    Dev *dev;
+    uint32_t pushes;
+    template <class Pixel>
+    uint32_t push(uint16_t x, uint16_t y, uint16_t w, uint16_t h, Pixel *data) {
+        dev->pushImageDMA(x, y, w, h, data);
+        return ++pushes;
+    }
+    void wait() { while (dev->dmaBusy()) FMT_TILE_YIELD(); }
+    uint32_t completed() { return dev->dmaBusy() ? pushes - 1 : pushes; }
+};
+
+template <class Dev>
+static inline TileDmaPush<Dev> tile_dma_push(Dev &dev) {
+    TileDmaPush<Dev> s = {&dev, 0};
+    return s;
+}
+
+/**
+ * Draw target handed to streaming-mode renderers: one tile's buffer addressed in screen
+ * coordinates, clipped to the tile, growing the box of what was drawn.
+ */
+template <class Pixel>
+struct TileCanvas {
+    int16_t x0, y0;
+    uint16_t w, h;
+    Pixel *buf;
+    TileBox drawn;
+
+    inline void writePixelGlobal(int16_t x, int16_t y, Pixel color) {
+        uint16_t lx = (uint16_t)(x - x0), ly = (uint16_t)(y - y0);
+        if (lx >= w || ly >= h) return;
+        buf[ly * w + lx] = color;
+        tile_box_add(&drawn, (uint8_t)lx, (uint8_t)ly, (uint8_t)lx, (uint8_t)ly);
+    }
+};
+
+// Counting semaphore: a FreeRTOS one on ESP32, mutex + condition variable elsewhere
+struct TileSignal {
+#ifdef FMT_TILE_FREERTOS
+    SemaphoreHandle_t sem;
+    TileSignal() : sem(nullptr) {}
+    bool init() { if (!sem) sem = xSemaphoreCreateCounting(32, 0); return sem != nullptr; }
+    void deinit() { if (sem) vSemaphoreDelete(sem); sem = nullptr; }
+    void post() { xSemaphoreGive(sem); }
+    void wait() { xSemaphoreTake(sem, portMAX_DELAY); }
+#else
+    std::mutex m;
+    std::condition_variable cv;
+    uint32_t count;
+    TileSignal() : count(0) {}
+    bool init() { count = 0; return true; }
+    void deinit() {}
+    void post() {
+        { std::lock_guard<std::mutex> lock(m); count++; }
+        cv.notify_one();
+    }
+    void wait() {
+        std::unique_lock<std::mutex> lock(m);
+        while (!count) cv.wait(lock);
+        count--;
+    }
+#endif
+};
+
+// A worker thread: a task pinned to a core on ESP32, a std::thread elsewhere
+struct TileTask {
+#ifdef FMT_TILE_FREERTOS
+    TaskHandle_t handle;
+    bool start(void (*entry)(void *), void *arg, uint8_t core) {
+        return xTaskCreatePinnedToCore(entry, "fmt_tiles", FMT_TILE_TASK_STACK, arg,
+                                       uxTaskPriorityGet(nullptr), &handle,
+                                       core % portNUM_PROCESSORS) == pdPASS;
+    }
+    static uint8_t core() { return (uint8_t)xPortGetCoreID(); }
+    static void exit_task() { vTaskDelete(nullptr); } // FreeRTOS tasks must not return
+    void join() {}                                    // entry has signalled before exit_task()
+#else
+    std::thread th;
+    bool start(void (*entry)(void *), void *arg, uint8_t) {
+        th = std::thread(entry, arg);
+        return true;
+    }
+    static uint8_t core() { return 0; }
+    static void exit_task() {}
+    void join() { if (th.joinable()) th.join(); }
+#endif
+};
+
+enum { TILE_WORKERS_MAX = 4 };
+
+/**
+ * Lock-free work-stealing queue of tile indices. Each worker owns a contiguous range packed
+ * as next << 16 | end in one atomic word, takes tiles from its front and, once it runs dry,
+ * steals the back half of the fullest other range. Tiles never return to a range within a
+ * frame, so a compare-and-swap can not mistake a refilled range for the one it read.
+ */
+struct TileQueue {
+    std::atomic<uint32_t> range[TILE_WORKERS_MAX];
+    uint8_t workers;
+
+    // Split tiles 0 .. count - 1 (at most 0xFFFF) evenly over n workers
+    void reset(uint32_t count, uint8_t n) {
+        workers = n;
+        for (uint8_t w = 0; w < n; w++) {
+            uint32_t b = count * w / n, e = count * (w + 1) / n;
+            range[w].store(b << 16 | e, std::memory_order_relaxed);
+        }
+    }
+
+    bool next(uint8_t w, uint32_t *tile) {
+        uint32_t r = range[w].load(std::memory_order_relaxed);
+        while ((r >> 16) < (r & 0xFFFF)) {
+            if (range[w].compare_exchange_weak(r, r + 0x10000, std::memory_order_relaxed)) {
+                *tile = r >> 16;
+                return true;
+            }
+        }
+        return steal(w, tile);
+    }
+
+    bool steal(uint8_t w, uint32_t *tile) {
+        for (;;) {
+            uint8_t victim = w;
+            uint32_t r = 0, most = 0;
+            for (uint8_t k = 1; k < workers; k++) {
+                uint8_t v = (w + k) % workers;
+                uint32_t rv = range[v].load(std::memory_order_relaxed);
+                uint32_t left = (rv >> 16) < (rv & 0xFFFF) ? (rv & 0xFFFF) - (rv >> 16) : 0;
+                if (left > most) { most = left; victim = v; r = rv; }
+            }
+            if (victim == w) return false;
+            uint32_t e = r & 0xFFFF, mid = e - (most + 1) / 2;
+            if (range[victim].compare_exchange_weak(r, (r & 0xFFFF0000u) | mid, std::memory_order_relaxed)) {
+                // Our own range is empty, so no thief touches it until this store
+                range[w].store((mid + 1) << 16 | e, std::memory_order_relaxed);
+                *tile = mid;
+                return true;
+            }
+        }
+    }
+};
+
+/**
+ * Persistent worker pool for renderTilesParallel(). start(n) adds n - 1 helper tasks to the
+ * calling thread, which does its share of every job; on ESP32 the helpers are pinned to the
+ * cores after the caller's, so with n = 2 loop() and one helper render on both cores.
+ * run() returns only after every worker has finished the job: the frame barrier.
+ */
+struct TileWorkers {
+    typedef void (*Job)(void *ctx, uint8_t worker);
+    struct Arg {
+        TileWorkers *self;
+        uint8_t worker;
+    };
+
+    uint8_t count; // workers including the caller, 0 before start()
+    TileQueue queue;
+    TileTask tasks[TILE_WORKERS_MAX];
+    Arg args[TILE_WORKERS_MAX];
+    TileSignal go[TILE_WORKERS_MAX], done;
+    Job job;
+    void *ctx;
+    bool quit;
+
+    TileWorkers() : count(0), job(nullptr), ctx(nullptr), quit(false) {}
+    ~TileWorkers() { stop(); }
+
+    bool start(uint8_t n) {
+        stop();
+        if (n == 0 || n > TILE_WORKERS_MAX || !done.init()) return false;
+        quit = false;
+        count = 1;
+        uint8_t core = TileTask::core();
+        for (uint8_t w = 1; w < n; w++) {
+            args[w].self = this;
+            args[w].worker = w;
+            if (!go[w].init() || !tasks[w].start(worker_main, &args[w], core + w)) {
+                go[w].deinit();
+                stop();
+                return false;
+            }
+            count++;
+        }
+        return true;
+    }
+
+    void stop() {
+        if (!count) return;
+        quit = true;
+        for (uint8_t w = 1; w < count; w++) go[w].post();
+        for (uint8_t w = 1; w < count; w++) done.wait();
+        for (uint8_t w = 1; w < count; w++) {
+            tasks[w].join();
+            go[w].deinit();
+        }
+        done.deinit();
+        count = 0;
+    }
+
+    void run(Job j, void *c) {
+        job = j;
+        ctx = c;
+        for (uint8_t w = 1; w < count; w++) go[w].post();
+        j(c, 0);
+        for (uint8_t w = 1; w < count; w++) done.wait();
+    }
+
+    static void worker_main(void *p) {
+        Arg *a = (Arg *)p;
+        TileWorkers *self = a->self;
+        for (;;) {
+            self->go[a->worker].wait();
+            if (self->quit) break;
+            self->job(self->ctx, a->worker);
+            self->done.post();
+        }
+        self->done.post();
+        TileTask::exit_task();
+    }
+};
+
+enum { TILE_POOL_MAX = 8 };
+
+template <class Pixel>
+struct TileCompositor {
+    struct Tile {
+        uint16_t x0, y0;
+        uint16_t w, h;
+        Pixel *buf;
+        TileBox curr; // drawn this frame
+        TileBox prev; // drawn last frame, already cleared in buf but still on screen
+        TileBox stale; // invalidate()d, pushed once with the next frame whatever is drawn
+    };
+
+    uint16_t screen_w, screen_h;
+    uint16_t tile_size;
+    uint8_t tile_shift; // log2(tile_size) when it is a power of two, else 0
+    uint16_t cols, rows;
+    Pixel bg;
+    Tile *tiles;
+    Pixel *scratch; // packs sub-rectangles narrower than their tile for push()
+    uint32_t pushed_px; // pixels handed to the sink by the last flush()
+
+    // Streaming mode: spare buffers, and a completion queue of those still being pushed
+    uint8_t pool;
+    Pixel *pool_buf[TILE_POOL_MAX];
+    uint8_t free_list[TILE_POOL_MAX], nfree;
+    uint8_t inflight[TILE_POOL_MAX], inflight_head, ninflight;
+    uint32_t inflight_seq[TILE_POOL_MAX]; // sink.completed() value that releases the buffer
+    uint32_t stalls; // acquire() calls that had to wait for a transfer, since init
+
+    TileCompositor() : screen_w(0), screen_h(0), tile_size(0), tile_shift(0), cols(0), rows(0),
+                       bg(0), tiles(nullptr), scratch(nullptr), pushed_px(0), pool(0) {}
+
+    /**
+     * pool = 0 allocates a buffer per tile (immediate mode); 1..TILE_POOL_MAX allocates only
+     * that many tile-sized buffers for renderTiles(). Two already overlap rendering with one
+     * transfer in flight.
+     */
+    bool init(uint16_t sw, uint16_t sh, uint16_t tsize, Pixel bgcolor = 0, uint8_t pool_count = 0) {
+        deinit();
+        if (tsize == 0 || tsize > 256 || pool_count > TILE_POOL_MAX) return false;
+        screen_w = sw; screen_h = sh; tile_size = tsize; bg = bgcolor;
+        tile_shift = 0;
+        if ((tsize & (tsize - 1)) == 0)
+            while ((1u << tile_shift) < tsize) tile_shift++;
+        cols = (screen_w + tile_size - 1) / tile_size;
+        rows = (screen_h + tile_size - 1) / tile_size;
+        uint32_t count = (uint32_t)cols * rows;
+        size_t tile_bytes = (size_t)tile_size * tile_size * sizeof(Pixel);
+        tiles = (Tile *)malloc(sizeof(Tile) * count);
+        if (tiles) memset(tiles, 0, sizeof(Tile) * count);
+        pool = pool_count;
+        nfree = ninflight = inflight_head = 0;
+        stalls = 0;
+        for (uint8_t i = 0; i < pool; i++) {
+            pool_buf[i] = (Pixel *)FMT_TILE_MALLOC(tile_bytes);
+            if (!pool_buf[i]) pool_buf[i] = (Pixel *)malloc(tile_bytes);
+            if (!pool_buf[i]) { pool = i; deinit(); return false; }
+            free_list[nfree++] = i;
+        }
+        if (!pool) {
+            scratch = (Pixel *)FMT_TILE_MALLOC(tile_bytes);
+            if (!scratch) scratch = (Pixel *)malloc(tile_bytes);
+        }
+        if (!tiles || (!pool && !scratch)) { deinit(); return false; }
+        for (uint16_t r = 0; r < rows; ++r) {
+            for (uint16_t c = 0; c < cols; ++c) {
+                Tile &t = tiles[r * cols + c];
+                t.x0 = c * tile_size;
+                t.y0 = r * tile_size;
+                t.w = (t.x0 + tile_size <= screen_w) ? tile_size : (uint16_t)(screen_w - t.x0);
+                t.h = (t.y0 + tile_size <= screen_h) ? tile_size : (uint16_t)(screen_h - t.y0);
+                t.curr = tile_box_empty();
+                t.prev = tile_box_empty();
+                t.stale = tile_box_empty();
+                if (pool) continue;
+                size_t n = (size_t)t.w * t.h;
+                t.buf = (Pixel *)FMT_TILE_MALLOC(n * sizeof(Pixel));
+                if (!t.buf) t.buf = (Pixel *)malloc(n * sizeof(Pixel));
+                if (!t.buf) { deinit(); return false; }
+                fill(t.buf, n, bg);
+            }
+        }
+        return true;
+    }
+
+    void deinit() {
+        if (tiles) {
+            uint32_t count = (uint32_t)cols * rows;
+            for (uint32_t i = 0; i < count; ++i) free(tiles[i].buf);
+            free(tiles);
+        }
+        free(scratch);
+        for (uint8_t i = 0; i < pool; i++) free(pool_buf[i]);
+        tiles = nullptr;
+        scratch = nullptr;
+        cols = rows = 0;
+        pool = 0;
+    }
+
+    static inline void fill(Pixel *p, size_t n, Pixel c) {
+        if (sizeof(Pixel) == 1 || c == 0) memset(p, (int)c, n * sizeof(Pixel));
+        else for (size_t i = 0; i < n; ++i) p[i] = c;
+    }
+
+    /**
+     * Repaint every tile with the next flush() or renderTiles(), e.g. after something else
+     * drew on the panel. Kept apart from prev, so startFrame() in between does not lose it.
+     */
+    void invalidate() {
+        uint32_t count = (uint32_t)cols * rows;
+        for (uint32_t i = 0; i < count; ++i) {
+            Tile &t = tiles[i];
+            tile_box_add(&t.stale, 0, 0, (uint8_t)(t.w - 1), (uint8_t)(t.h - 1));
+        }
+    }
+
+    /**
+     * Clear what was drawn last frame and roll the boxes over. Outside its curr box a tile
+     * buffer always holds bg, so clearing curr alone empties the union the next flush pushes.
+     */
+    void startFrame() {
+        if (pool) return; // renderTiles() rolls the boxes over itself
+        uint32_t count = (uint32_t)cols * rows;
+        for (uint32_t i = 0; i < count; ++i) startTile(tiles[i]);
+    }
+
+    void startTile(Tile &t) {
+        TileBox b = t.curr;
+        if (!tile_box_is_empty(b)) {
+            uint16_t bw = b.x1 - b.x0 + 1;
+            Pixel *row = t.buf + (size_t)b.y0 * t.w + b.x0;
+            if (bw == t.w) fill(row, (size_t)bw * (b.y1 - b.y0 + 1), bg);
+            else for (uint16_t y = b.y0; y <= b.y1; ++y, row += t.w) fill(row, bw, bg);
+        }
+        t.prev = b;
+        t.curr = tile_box_empty();
+    }
+
+    // Immediate mode: startFrame() for one tile, then let a renderTiles()-style renderer draw it
+    template <class Renderer>
+    void renderTile(Renderer &r, uint32_t i) {
+        Tile &t = tiles[i];
+        startTile(t);
+        if (r.empty(i)) return;
+        TileCanvas<Pixel> cv = {(int16_t)t.x0, (int16_t)t.y0, t.w, t.h, t.buf, tile_box_empty()};
+        r.render(i, cv);
+        t.curr = cv.drawn;
+    }
+
+    template <class Renderer>
+    struct ParallelJob {
+        TileCompositor *self;
+        Renderer *r;
+        TileQueue *queue;
+        static void run(void *p, uint8_t worker) {
+            ParallelJob *j = (ParallelJob *)p;
+            uint32_t i;
+            while (j->queue->next(worker, &i)) j->self->renderTile(*j->r, i);
+        }
+    };
+
+    /**
+     * Immediate mode: startFrame() and render every tile, spread over the workers, then
+     * flush() as usual. Each tile is touched by one worker only, so render() needs no locks
+     * as long as it only reads shared state. Returns false on a streaming compositor.
+     */
+    template <class Renderer>
+    bool renderTilesParallel(Renderer &r, TileWorkers &workers) {
+        if (pool) return false;
+        uint32_t count = (uint32_t)cols * rows;
+        if (workers.count < 2 || count > 0xFFFF) {
+            for (uint32_t i = 0; i < count; ++i) renderTile(r, i);
+            return true;
+        }
+        ParallelJob<Renderer> job = {this, &r, &workers.queue};
+        workers.queue.reset(count, workers.count);
+        workers.run(ParallelJob<Renderer>::run, &job);
+        return true;
+    }
+
+    inline Tile &tileAt(int16_t x, int16_t y) {
+        uint16_t tx, ty;
+        if (tile_shift) {
+            tx = (uint16_t)x >> tile_shift;
+            ty = (uint16_t)y >> tile_shift;
+        } else {
+            tx = (uint16_t)x / tile_size;
+            ty = (uint16_t)y / tile_size;
+        }
+        return tiles[ty * cols + tx];
+    }
+
+    inline void writePixelLocal(Tile &t, uint16_t lx, uint16_t ly, Pixel color) {
+        t.buf[ly * t.w + lx] = color;
+        tile_box_add(&t.curr, (uint8_t)lx, (uint8_t)ly, (uint8_t)lx, (uint8_t)ly);
+    }
+
+    inline void writePixelGlobal(int16_t x, int16_t y, Pixel color) {
+        if (x < 0 || y < 0 || x >= (int)screen_w || y >= (int)screen_h) return;
+        Tile &t = tileAt(x, y);
+        writePixelLocal(t, x - t.x0, y - t.y0, color);
+    }
+
+    // For renderers that write into t.buf directly (raster_tile, wire_tile, ...)
+    inline void markDirty(Tile &t, uint16_t lx0, uint16_t ly0, uint16_t lx1, uint16_t ly1) {
+        tile_box_add(&t.curr, (uint8_t)lx0, (uint8_t)ly0, (uint8_t)lx1, (uint8_t)ly1);
+    }
+
+    void drawLine(int x0, int y0, int x1, int y1, Pixel color) {
+        if ((x0 < 0 && x1 < 0) || (x0 >= (int)screen_w && x1 >= (int)screen_w) ||
+            (y0 < 0 && y1 < 0) || (y0 >= (int)screen_h && y1 >= (int)screen_h)) return;
+        int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+        int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+        int err = dx + dy;
+        while (true) {
+            writePixelGlobal(x0, y0, color);
+            if (x0 == x1 && y0 == y1) break;
+            int e2 = 2 * err;
+            if (e2 >= dy) { err += dy; x0 += sx; }
+            if (e2 <= dx) { err += dx; y0 += sy; }
+        }
+    }
+
+    /**
+     * Push the union of each tile's current and previous box. Boxes spanning the full tile
+     * width are contiguous in the tile buffer and go out as they are; narrower ones are
+     * packed into scratch first, after the sink has released it. Immediate mode only:
+     * returns false, doing nothing, on a streaming compositor.
+     */
+    template <class Sink>
+    bool flush(Sink &sink) {
+        if (pool) return false; // no tile buffers to push from
+        uint32_t count = (uint32_t)cols * rows;
+        bool scratch_busy = false;
+        pushed_px = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            Tile &t = tiles[i];
+            TileBox b = tile_box_union(tile_box_union(t.curr, t.prev), t.stale);
+            t.stale = tile_box_empty();
+            if (tile_box_is_empty(b)) continue;
+            uint16_t bw = b.x1 - b.x0 + 1, bh = b.y1 - b.y0 + 1;
+            Pixel *src = t.buf + (size_t)b.y0 * t.w + b.x0;
+            if (bw != t.w) {
+                if (scratch_busy) sink.wait();
+                Pixel *dst = scratch;
+                for (uint16_t y = 0; y < bh; ++y, src += t.w, dst += bw) memcpy(dst, src, bw * sizeof(Pixel));
+                src = scratch;
+                scratch_busy = true;
+            }
+            sink.push(t.x0 + b.x0, t.y0 + b.y0, bw, bh, src);
+            pushed_px += (uint32_t)bw * bh;
+        }
+        sink.wait();
+        return true;
+    }
+
+    template <class Dev>
+    bool flushTo(Dev &dev) {
+        TilePushImage<Dev> sink = tile_push_image(dev);
+        return flush(sink);
+    }
+
+    // Move buffers whose transfer has finished from the completion queue to the free list
+    template <class Sink>
+    void retire(Sink &sink) {
+        if (!ninflight) return;
+        uint32_t done = sink.completed();
+        while (ninflight && (int32_t)(done - inflight_seq[inflight_head]) >= 0) {
+            free_list[nfree++] = inflight[inflight_head];
+            inflight_head = (inflight_head + 1) % TILE_POOL_MAX;
+            ninflight--;
+        }
+    }
+
+    template <class Sink>
+    uint8_t acquire(Sink &sink) {
+        retire(sink);
+        if (!nfree) {
+            stalls++;
+            do {
+                FMT_TILE_YIELD();
+                retire(sink);
+            } while (!nfree);
+        }
+        return free_list[--nfree];
+    }
+
+    // Wait for every transfer renderTiles() started; needed before deinit() or drawing elsewhere
+    template <class Sink>
+    void drain(Sink &sink) {
+        while (ninflight) {
+            retire(sink);
+            if (ninflight) FMT_TILE_YIELD();
+        }
+    }
+
+    /**
+     * Streaming mode: render and push the frame tile by tile. For each tile the renderer
+     * is asked
+     *
+     *   bool empty(uint32_t tile);                         // nothing to draw here
+     *   void render(uint32_t tile, TileCanvas<Pixel> &cv); // cv.buf starts out as bg
+     *
+     * and the union of what it drew, what the tile showed last frame and any invalidate()d
+     * box is pushed from a pool buffer. Buffers come back through the completion queue, so
+     * rendering only stalls when every spare buffer is still being transferred. Tiles with
+     * nothing drawn now or last frame cost neither a buffer nor a push. Keep using the same
+     * sink from frame to frame; drain() before switching to another one. Returns false,
+     * doing nothing, on a compositor initialised without a pool.
+     */
+    template <class Renderer, class Sink>
+    bool renderTiles(Renderer &r, Sink &sink) {
+        if (!pool) return false; // acquire() would wait forever for a buffer
+        uint32_t count = (uint32_t)cols * rows;
+        pushed_px = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            Tile &t = tiles[i];
+            t.prev = t.curr;
+            t.curr = tile_box_empty();
+            TileBox old = tile_box_union(t.prev, t.stale);
+            t.stale = tile_box_empty();
+            bool draw = !r.empty(i);
+            if (!draw && tile_box_is_empty(old)) continue;
+
+            uint8_t slot = acquire(sink);
+            Pixel *buf = pool_buf[slot];
+            if (draw) {
+                TileCanvas<Pixel> cv = {(int16_t)t.x0, (int16_t)t.y0, t.w, t.h, buf, tile_box_empty()};
+                fill(buf, (size_t)t.w * t.h, bg);
+                r.render(i, cv);
+                t.curr = cv.drawn;
+            }
+            TileBox b = tile_box_union(t.curr, old);
+            if (tile_box_is_empty(b)) {
+                free_list[nfree++] = slot;
+                continue;
+            }
+            uint16_t bw = b.x1 - b.x0 + 1, bh = b.y1 - b.y0 + 1;
+            if (!draw) {
+                fill(buf, (size_t)bw * bh, bg); // only erasing what is on screen
+            } else if (bw != t.w || b.y0) {
+                // Pack the box to the front of the buffer; rows only ever move down in memory
+                Pixel *src = buf + (size_t)b.y0 * t.w + b.x0, *dst = buf;
+                for (uint16_t y = 0; y < bh; ++y, src += t.w, dst += bw) memmove(dst, src, bw * sizeof(Pixel));
+            }
+            uint8_t q = (inflight_head + ninflight++) % TILE_POOL_MAX;
+            inflight[q] = slot;
+            inflight_seq[q] = sink.push(t.x0 + b.x0, t.y0 + b.y0, bw, bh, buf);
+            pushed_px += (uint32_t)bw * bh;
+        }
+        return true;
+    }
+};
+
+} // namespace FMT
+
+#endif
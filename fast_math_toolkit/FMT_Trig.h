@@ -149,6 +149,28 @@ static inline uint16_t acos_u16(int32_t x) {
     return angle;
 }
 
+static inline uint16_t asin_u16(int32_t x) {
+    // asin(x) = PI/2 - acos(x); negative results wrap like atan2_u16
+    return (uint16_t)(16384 - acos_u16(x));
+}
+
+// tan(a) = sin(a) / cos(a) as a log subtraction. lval keeps the Q16.16 offset of sin_log.
+static inline Log32 tan_log(uint16_t a) {
+    Log32 s = sin_log(a);
+    Log32 c = cos_log(a);
+    Log32 r = log32_div(s, c);
+    if (s.sign != 0 && c.sign != 0) r.lval += (16 << FMT_LOG_Q);
+    return r;
+}
+
+// Result in Q16.16, saturated at +/-90 deg
+static inline int32_t tan_u16(uint16_t a) {
+    Log32 t = tan_log(a);
+    if (t.sign == 0) return 0;
+    if (t.lval >= (31 << FMT_LOG_Q)) return (t.sign > 0) ? 0x7FFFFFFF : -0x7FFFFFFF;
+    return from_log32(t);
+}
+
 } // namespace FMT
 
 #endif
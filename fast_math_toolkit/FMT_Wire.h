@@ -0,0 +1,226 @@
+#ifndef FMT_WIRE_H
+#define FMT_WIRE_H
+
+#include "FMT_3d.h"
+#include "FMT_Mesh.h"
+
+namespace FMT {
+
+/**
+ * Tiled wireframe renderer.
+ *
+ * wire_build_edges turns a triangle mesh into its unique edges once at load time.
+ * Per frame, wire_setup transforms and projects every vertex once, clips each edge against
+ * the near plane (view space) and the screen (Q16.16 screen space), and stores it as a
+ * pixel segment. wire_tile then draws the segments touching one tile straight into its
+ * RGB565 buffer: the Bresenham state at the tile entry is solved for in closed form, so the
+ * inner loop has no bounds checks or divisions and tiles join without seams.
+ */
+
+typedef struct {
+    int16_t x0, y0, x1, y1; // pixels, inside the screen
+    uint16_t color;
+} WireSeg;
+
+typedef struct {
+    Vec3 view;
+    int32_t sx, sy; // Q16.16 screen position, valid when in front of the near plane
+} WireVertex;
+
+/**
+ * Unique undirected edges of the mesh as (a << 16) | b with a < b, sorted. edges needs
+ * room for 3 * tri_count keys while building; returns the unique count.
+ */
+static inline uint16_t wire_build_edges(const MeshQ *m, uint32_t *edges) {
+    uint32_t n = (uint32_t)m->tri_count * 3;
+    for (uint16_t t = 0; t < m->tri_count; t++) {
+        for (uint8_t k = 0; k < 3; k++) {
+            uint16_t a = mesh_index(m, t * 3 + k), b = mesh_index(m, t * 3 + (k + 1) % 3);
+            edges[t * 3 + k] = (a < b) ? ((uint32_t)a << 16) | b : ((uint32_t)b << 16) | a;
+        }
+    }
+    // Shell sort: in place, no recursion, fine for the few hundred edges of a wireframe model
+    for (uint32_t gap = n / 2; gap > 0; gap /= 2) {
+        for (uint32_t i = gap; i < n; i++) {
+            uint32_t v = edges[i], j = i;
+            while (j >= gap && edges[j - gap] > v) {
+                edges[j] = edges[j - gap];
+                j -= gap;
+            }
+            edges[j] = v;
+        }
+    }
+    uint16_t count = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (count == 0 || edges[count - 1] != edges[i]) edges[count++] = edges[i];
+    }
+    return count;
+}
+
+// Liang-Barsky: shrink [t0, t1] (Q16.16) by one boundary p * t <= q
+static inline bool wire_clip_edge(int64_t p, int64_t q, int32_t *t0, int32_t *t1) {
+    if (p == 0) return q >= 0;
+    int64_t t = (q << Q16_S) / p;
+    if (p < 0) {
+        if (t > *t1) return false;
+        if (t > *t0) *t0 = (int32_t)t;
+    } else {
+        if (t < *t0) return false;
+        if (t < *t1) *t1 = (int32_t)t;
+    }
+    return true;
+}
+
+static inline bool wire_clip_screen(int32_t *x0, int32_t *y0, int32_t *x1, int32_t *y1,
+                                    int32_t xmax, int32_t ymax) {
+    int64_t dx = (int64_t)*x1 - *x0, dy = (int64_t)*y1 - *y0;
+    int32_t t0 = 0, t1 = Q16_ONE;
+    if (!wire_clip_edge(-dx, *x0, &t0, &t1)) return false;
+    if (!wire_clip_edge(dx, (int64_t)xmax - *x0, &t0, &t1)) return false;
+    if (!wire_clip_edge(-dy, *y0, &t0, &t1)) return false;
+    if (!wire_clip_edge(dy, (int64_t)ymax - *y0, &t0, &t1)) return false;
+    int32_t ox = *x0, oy = *y0;
+    if (t1 < Q16_ONE) {
+        *x1 = ox + (int32_t)((dx * t1) >> Q16_S);
+        *y1 = oy + (int32_t)((dy * t1) >> Q16_S);
+    }
+    if (t0 > 0) {
+        *x0 = ox + (int32_t)((dx * t0) >> Q16_S);
+        *y0 = oy + (int32_t)((dy * t0) >> Q16_S);
+    }
+    return true;
+}
+
+static inline void wire_project(Vec3 v, int32_t focal, int16_t cx, int16_t cy, int32_t *sx, int32_t *sy) {
+    Vec3 p = project_perspective(v, focal);
+    *sx = ((int32_t)cx << Q16_S) + p.x;
+    *sy = ((int32_t)cy << Q16_S) - p.y;
+}
+
+/**
+ * Transform and project the mesh (verts: vert_count scratch entries), then clip every edge
+ * and write the visible ones to out. near_dist is measured from the camera like
+ * clip_tri_near. Returns the number of segments.
+ */
+static inline uint16_t wire_setup(const MeshQ *m, const uint32_t *edges, uint16_t edge_count,
+                                  const Mat34 *model_view, int32_t focal, int32_t near_dist,
+                                  int16_t cx, int16_t cy, uint16_t screen_w, uint16_t screen_h,
+                                  uint16_t color, WireVertex *verts, WireSeg *out) {
+    Mat34 M = mesh_matrix(m, model_view);
+    int32_t zn = near_dist - focal;
+    for (uint16_t i = 0; i < m->vert_count; i++) {
+        WireVertex *w = &verts[i];
+        w->view = mat34_mul_point(&M, mesh_vertex_q(m, i));
+        if (w->view.z >= zn) wire_project(w->view, focal, cx, cy, &w->sx, &w->sy);
+    }
+
+    int32_t xmax = (int32_t)(screen_w - 1) << Q16_S, ymax = (int32_t)(screen_h - 1) << Q16_S;
+    uint16_t n = 0;
+    for (uint16_t e = 0; e < edge_count; e++) {
+        const WireVertex *a = &verts[edges[e] >> 16], *b = &verts[edges[e] & 0xFFFF];
+        bool a_in = a->view.z >= zn, b_in = b->view.z >= zn;
+        if (!a_in && !b_in) continue;
+        int32_t x0 = a->sx, y0 = a->sy, x1 = b->sx, y1 = b->sy;
+        if (!a_in || !b_in) {
+            // Replace the vertex behind the near plane by the crossing point
+            const WireVertex *p = a_in ? a : b, *q = a_in ? b : a;
+            int32_t t = q16_div_s(zn - p->view.z, q->view.z - p->view.z);
+            Vec3 c = vec3_init(q16_lerp(p->view.x, q->view.x, t), q16_lerp(p->view.y, q->view.y, t), zn);
+            int32_t sx, sy;
+            wire_project(c, focal, cx, cy, &sx, &sy);
+            if (a_in) { x1 = sx; y1 = sy; } else { x0 = sx; y0 = sy; }
+        }
+        if (!wire_clip_screen(&x0, &y0, &x1, &y1, xmax, ymax)) continue;
+        WireSeg *s = &out[n++];
+        s->x0 = (int16_t)((x0 + (Q16_ONE >> 1)) >> Q16_S);
+        s->y0 = (int16_t)((y0 + (Q16_ONE >> 1)) >> Q16_S);
+        s->x1 = (int16_t)((x1 + (Q16_ONE >> 1)) >> Q16_S);
+        s->y1 = (int16_t)((y1 + (Q16_ONE >> 1)) >> Q16_S);
+        s->color = color;
+    }
+    return n;
+}
+
+/**
+ * Draw one segment into the tile at (tx, ty), w x h. Pixels are those of the midpoint line
+ * walked from the lower end of the major axis, whichever tile they land in.
+ */
+static inline bool wire_draw_seg(const WireSeg *s, uint16_t *buf, int16_t tx, int16_t ty, uint16_t w, uint16_t h) {
+    int32_t ax = s->x0, ay = s->y0, bx = s->x1, by = s->y1;
+    int32_t dx = bx > ax ? bx - ax : ax - bx, dy = by > ay ? by - ay : ay - by;
+    bool xmajor = dx >= dy;
+    if (xmajor ? bx < ax : by < ay) {
+        int32_t t;
+        t = ax; ax = bx; bx = t;
+        t = ay; ay = by; by = t;
+    }
+    // Major axis a, minor axis b
+    int32_t a0, b0, da, db, sb, amin, amax, bmin, bmax, astride, bstride;
+    if (xmajor) {
+        a0 = ax; b0 = ay; da = dx; db = dy; sb = by >= ay ? 1 : -1;
+        amin = tx; amax = tx + w - 1; bmin = ty; bmax = ty + h - 1;
+        astride = 1; bstride = w;
+    } else {
+        a0 = ay; b0 = ax; da = dy; db = dx; sb = bx >= ax ? 1 : -1;
+        amin = ty; amax = ty + h - 1; bmin = tx; bmax = tx + w - 1;
+        astride = w; bstride = 1;
+    }
+    if (da == 0) {
+        if (ax < tx || ax >= tx + (int32_t)w || ay < ty || ay >= ty + (int32_t)h) return false;
+        buf[(ay - ty) * w + (ax - tx)] = s->color;
+        return true;
+    }
+
+    // Step i puts the minor coordinate at b0 + sb * floor((2 i db + da) / 2 da)
+    int32_t i_lo = amin - a0 > 0 ? amin - a0 : 0;
+    int32_t i_hi = amax - a0 < da ? amax - a0 : da;
+    int32_t k_lo = sb > 0 ? bmin - b0 : b0 - bmax;
+    int32_t k_hi = sb > 0 ? bmax - b0 : b0 - bmin;
+    if (k_hi < 0) return false;
+    int32_t two_da = da << 1, two_db = db << 1;
+    if (db == 0) {
+        if (k_lo > 0) return false;
+    } else {
+        if (k_lo > 0) {
+            int32_t lo = (int32_t)(((int64_t)two_da * k_lo - da + two_db - 1) / two_db);
+            if (lo > i_lo) i_lo = lo;
+        }
+        int32_t hi = (int32_t)(((int64_t)two_da * (k_hi + 1) - da - 1) / two_db);
+        if (hi < i_hi) i_hi = hi;
+    }
+    if (i_lo > i_hi) return false;
+
+    int32_t num = i_lo * two_db + da;
+    int32_t bb = num / two_da, err = num - bb * two_da;
+    uint16_t *p = buf + (a0 + i_lo - amin) * astride + (b0 + sb * bb - bmin) * bstride;
+    int32_t bstep = sb * bstride;
+    uint16_t color = s->color;
+    for (int32_t i = i_lo; i <= i_hi; i++) {
+        *p = color;
+        p += astride;
+        err += two_db;
+        if (err >= two_da) {
+            err -= two_da;
+            p += bstep;
+        }
+    }
+    return true;
+}
+
+// Draw every segment that overlaps the tile; returns true if any pixel was written
+static inline bool wire_tile(const WireSeg *segs, uint16_t n, uint16_t *buf,
+                             int16_t tx, int16_t ty, uint16_t w, uint16_t h) {
+    bool touched = false;
+    int16_t tx1 = tx + w - 1, ty1 = ty + h - 1;
+    for (uint16_t i = 0; i < n; i++) {
+        const WireSeg *s = &segs[i];
+        if ((s->x0 < tx && s->x1 < tx) || (s->x0 > tx1 && s->x1 > tx1) ||
+            (s->y0 < ty && s->y1 < ty) || (s->y0 > ty1 && s->y1 > ty1)) continue;
+        if (wire_draw_seg(s, buf, tx, ty, w, h)) touched = true;
+    }
+    return touched;
+}
+
+} // namespace FMT
+
+#endif
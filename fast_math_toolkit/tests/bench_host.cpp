@@ -0,0 +1,253 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+#define INCLUDE_TABLES "arduino_tables_generated.h"
+#include "../FMT.h"
+
+using namespace FMT;
+
+static volatile int32_t g_sink;
+
+template <typename F>
+static double bench_msps(size_t n, int reps, F fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) fn();
+    auto t1 = std::chrono::steady_clock::now();
+    double s = std::chrono::duration<double>(t1 - t0).count();
+    return (double)n * reps / s / 1e6;
+}
+
+static void report(const char *name, double scalar, double batch) {
+    std::cout << std::left << std::setw(18) << name
+              << "scalar " << std::right << std::setw(8) << std::fixed << std::setprecision(1) << scalar << " M/s   "
+              << "batch " << std::setw(8) << batch << " M/s   "
+              << "x" << std::setprecision(2) << batch / scalar << std::endl;
+}
+
+int main() {
+    const size_t n = 1 << 20;
+    const int reps = 20;
+    std::vector<uint16_t> ang(n), atn(n);
+    std::vector<int16_t> s(n), c(n);
+    std::vector<Log32> ls(n);
+    std::vector<int32_t> ys(n), xs(n);
+    for (size_t i = 0; i < n; i++) {
+        ang[i] = (uint16_t)rand();
+        ys[i] = (int32_t)(rand() - RAND_MAX / 2);
+        xs[i] = (int32_t)(rand() - RAND_MAX / 2);
+    }
+
+#ifdef FMT_BATCH_AVX2
+    std::cout << "FMT batch throughput (AVX2), " << n << " samples" << std::endl;
+#else
+    std::cout << "FMT batch throughput (scalar fallback), " << n << " samples" << std::endl;
+#endif
+
+    double sc = bench_msps(n, reps, [&] {
+        for (size_t i = 0; i < n; i++) { s[i] = sin_u16(ang[i]); c[i] = cos_u16(ang[i]); }
+        g_sink = s[n - 1] + c[n - 1];
+    });
+    double bt = bench_msps(n, reps, [&] {
+        sincos_u16_batch(ang.data(), s.data(), c.data(), n);
+        g_sink = s[n - 1] + c[n - 1];
+    });
+    report("sincos_u16", sc, bt);
+
+    sc = bench_msps(n, reps, [&] {
+        for (size_t i = 0; i < n; i++) ls[i] = sin_log(ang[i]);
+        g_sink = ls[n - 1].lval;
+    });
+    bt = bench_msps(n, reps, [&] {
+        sin_log_batch(ang.data(), ls.data(), n);
+        g_sink = ls[n - 1].lval;
+    });
+    report("sin_log", sc, bt);
+
+    sc = bench_msps(n, reps, [&] {
+        for (size_t i = 0; i < n; i++) atn[i] = atan2_u16(ys[i], xs[i]);
+        g_sink = atn[n - 1];
+    });
+    bt = bench_msps(n, reps, [&] {
+        atan2_u16_batch(ys.data(), xs.data(), atn.data(), n);
+        g_sink = atn[n - 1];
+    });
+    report("atan2_u16", sc, bt);
+
+    int bad = 0;
+
+    {
+        const size_t nv = 1 << 16;
+        const int vreps = 40;
+        std::vector<int32_t> vx(nv), vy(nv), vz(nv), ox(nv), oy(nv), oz(nv);
+        for (size_t i = 0; i < nv; i++) {
+            vx[i] = (int32_t)(rand() % 0x100000) - 0x80000;
+            vy[i] = (int32_t)(rand() % 0x100000) - 0x80000;
+            vz[i] = (int32_t)(rand() % 0x100000) - 0x80000;
+        }
+        Vec3 trans = {0, 0, 0x280000};
+        int32_t focal = 0x1000000;
+        sc = bench_msps(nv, vreps, [&] {
+            for (size_t i = 0; i < nv; i++) {
+                Vec3 p = pipeline_mvp(vec3_init(vx[i], vy[i], vz[i]), 0x18000, 1000, 20000, 40000, trans, focal);
+                ox[i] = p.x; oy[i] = p.y; oz[i] = p.z;
+            }
+            g_sink = ox[nv - 1];
+        });
+        bt = bench_msps(nv, vreps, [&] {
+            Mat4 M = mat4_model(0x18000, 1000, 20000, 40000, trans);
+            transform_project_batch(&M, focal, vx.data(), vy.data(), vz.data(), ox.data(), oy.data(), oz.data(), nv);
+            g_sink = ox[nv - 1];
+        });
+        report("pipeline_mvp", sc, bt);
+        // One vertex per call always takes the scalar loop, so this gates the AVX2 path
+        Mat4 M = mat4_model(0x18000, 1000, 20000, 40000, trans);
+        for (size_t i = 0; i < nv; i++) {
+            int32_t rx, ry, rz;
+            transform_project_batch(&M, focal, &vx[i], &vy[i], &vz[i], &rx, &ry, &rz, 1);
+            if (ox[i] != rx || oy[i] != ry || oz[i] != rz) bad++;
+        }
+    }
+
+    {
+        // 320x240 ray-cast view of 64 spheres over a floor, 40x40 tiles
+        const int NS = 64, W = 320, H = 240, T = 40;
+        RaySphere spheres[NS];
+        for (int i = 0; i < NS; i++) {
+            spheres[i].c = vec3_init((rand() % 60 - 30) << 16, (rand() % 20 - 10) << 16, (rand() % 60 + 20) << 16);
+            spheres[i].r = (rand() % 3 + 1) << 16;
+            spheres[i].material = (uint8_t)(i & 1);
+        }
+        RayNode nodes[2 * NS];
+        uint16_t idx[NS];
+        uint16_t nn = ray_bvh_build(nodes, 2 * NS, idx, spheres, NS);
+        Material mats[2] = {{220, 60, 40, 128, 16}, {40, 160, 220, 64, 8}};
+        Light sun = {ray_normalize(vec3_init(Q16_ONE, Q16_ONE, -Q16_ONE)), 255, 255, 255, LIGHT_DIRECTIONAL};
+        RayPlane floor_plane = {{vec3_init(0, Q16_ONE, 0), 12 << 16}, 0};
+        RayScene scene = {spheres, idx, nodes, nn, &floor_plane, 1, mats, &sun, 1, 48, 0};
+        RayCamera cam = {vec3_init(0, 0, 0), {{{Q16_ONE, 0, 0}, {0, Q16_ONE, 0}, {0, 0, Q16_ONE}}}, 240 << 16, W / 2, H / 2};
+        std::vector<uint16_t> tile(T * T);
+        const int rreps = 5;
+
+        sc = bench_msps((size_t)W * H, rreps, [&] {
+            for (int ty = 0; ty < H; ty += T) {
+                for (int tx = 0; tx < W; tx += T) {
+                    for (int y = 0; y < T; y++) {
+                        for (int x = 0; x < T; x++) {
+                            Ray r;
+                            ray_init(&r, cam.eye, ray_camera_dir(&cam, tx + x, ty + y));
+                            ray_trace_packet(&scene, &r, 1);
+                            tile[y * T + x] = ray_shade(&scene, &r);
+                        }
+                    }
+                    g_sink = tile[0];
+                }
+            }
+        });
+        bt = bench_msps((size_t)W * H, rreps, [&] {
+            for (int ty = 0; ty < H; ty += T) {
+                for (int tx = 0; tx < W; tx += T) {
+                    ray_render_tile(&scene, &cam, tile.data(), tx, ty, T, T);
+                    g_sink = tile[0];
+                }
+            }
+        });
+        std::cout << "ray_cast (M rays/s, 2x2 packets vs single rays)" << std::endl;
+        report("ray_render_tile", sc, bt);
+    }
+
+    {
+        // 160x120 SDF view: floor, sphere smoothly blended with a torus, box with a sphere carved out
+        const int W = 160, H = 120, T = 40;
+        SdfPrim prims[5] = {
+            {SDF_PLANE, SDF_OP_UNION, 0, vec3_init(0, Q16_ONE, 0), vec3_init(3 << 16, 0, 0), 0},
+            {SDF_SPHERE, SDF_OP_UNION, 1, vec3_init(-4 << 16, 0, 24 << 16), vec3_init(3 << 16, 0, 0), 0},
+            {SDF_TORUS, SDF_OP_SMOOTH, 1, vec3_init(-4 << 16, -1 << 16, 24 << 16), vec3_init(5 << 16, 1 << 16, 0), 1 << 16},
+            {SDF_BOX, SDF_OP_UNION, 2, vec3_init(6 << 16, 0, 30 << 16), vec3_init(3 << 16, 3 << 16, 3 << 16), 0},
+            {SDF_SPHERE, SDF_OP_SUBTRACT, 2, vec3_init(6 << 16, 2 << 16, 27 << 16), vec3_init(3 << 16, 0, 0), 0},
+        };
+        Material mats[3] = {{180, 180, 180, 0, 1}, {220, 60, 40, 128, 16}, {40, 160, 220, 64, 8}};
+        Light sun = {ray_normalize(vec3_init(Q16_ONE, Q16_ONE, -Q16_ONE)), 255, 255, 255, LIGHT_DIRECTIONAL};
+        SdfScene scene = {prims, 5, mats, &sun, 1, 48, 0};
+        RayCamera cam = {vec3_init(0, 0, 0), {{{Q16_ONE, 0, 0}, {0, Q16_ONE, 0}, {0, 0, Q16_ONE}}}, 120 << 16, W / 2, H / 2};
+        std::vector<uint16_t> tile(T * T);
+        int32_t row_t[T];
+        const int sreps = 3;
+        sc = bench_msps((size_t)W * H, sreps, [&] {
+            for (int ty = 0; ty < H; ty += T)
+                for (int tx = 0; tx < W; tx += T) sdf_render_tile(&scene, &cam, tile.data(), tx, ty, T, T, 90 << 16, 96, 0);
+            g_sink = tile[0];
+        });
+        bt = bench_msps((size_t)W * H, sreps, [&] {
+            for (int ty = 0; ty < H; ty += T)
+                for (int tx = 0; tx < W; tx += T) sdf_render_tile(&scene, &cam, tile.data(), tx, ty, T, T, 90 << 16, 96, row_t);
+            g_sink = tile[0];
+        });
+        std::cout << "sdf_march (M pixels/s, previous-row start bound vs marching from the eye)" << std::endl;
+        report("sdf_render_tile", sc, bt);
+    }
+
+    {
+        // 320x240 wireframe, 400 random segments, 16x16 tiles: per-pixel bounds test
+        // (TileManager::drawLine style) vs clipped per-tile Bresenham
+        const int W = 320, H = 240, T = 16, NSEG = 400;
+        std::vector<WireSeg> segs(NSEG);
+        for (int i = 0; i < NSEG; i++) {
+            segs[i] = {(int16_t)(rand() % W), (int16_t)(rand() % H), (int16_t)(rand() % W), (int16_t)(rand() % H), 0xFFFF};
+        }
+        std::vector<uint16_t> tile(T * T);
+        size_t pixels = 0;
+        for (int i = 0; i < NSEG; i++) {
+            int dx = abs(segs[i].x1 - segs[i].x0), dy = abs(segs[i].y1 - segs[i].y0);
+            pixels += (dx > dy ? dx : dy) + 1;
+        }
+        const int wreps = 5;
+        sc = bench_msps(pixels, wreps, [&] {
+            for (int ty = 0; ty < H; ty += T) {
+                for (int tx = 0; tx < W; tx += T) {
+                    for (int i = 0; i < NSEG; i++) {
+                        const WireSeg &l = segs[i];
+                        int x = l.x0, y = l.y0;
+                        int dx = abs(l.x1 - x), sx = x < l.x1 ? 1 : -1;
+                        int dy = -abs(l.y1 - y), sy = y < l.y1 ? 1 : -1;
+                        int err = dx + dy;
+                        for (;;) {
+                            if (x >= tx && x < tx + T && y >= ty && y < ty + T) tile[(y - ty) * T + (x - tx)] = l.color;
+                            if (x == l.x1 && y == l.y1) break;
+                            int e2 = 2 * err;
+                            if (e2 >= dy) { err += dy; x += sx; }
+                            if (e2 <= dx) { err += dx; y += sy; }
+                        }
+                    }
+                    g_sink = tile[0];
+                }
+            }
+        });
+        bt = bench_msps(pixels, wreps, [&] {
+            for (int ty = 0; ty < H; ty += T) {
+                for (int tx = 0; tx < W; tx += T) {
+                    wire_tile(segs.data(), NSEG, tile.data(), tx, ty, T, T);
+                    g_sink = tile[0];
+                }
+            }
+        });
+        std::cout << "wireframe (M line pixels/s, clipped per-tile Bresenham vs per-pixel bounds test)" << std::endl;
+        report("wire_tile", sc, bt);
+    }
+
+    sincos_u16_batch(ang.data(), s.data(), c.data(), n);
+    sin_log_batch(ang.data(), ls.data(), n);
+    atan2_u16_batch(ys.data(), xs.data(), atn.data(), n);
+    for (size_t i = 0; i < n; i++) {
+        Log32 l = sin_log(ang[i]);
+        if (s[i] != sin_u16(ang[i]) || c[i] != cos_u16(ang[i])) bad++;
+        if (ls[i].lval != l.lval || ls[i].sign != l.sign) bad++;
+        if (atn[i] != atan2_u16(ys[i], xs[i])) bad++;
+    }
+    if (bad) std::cout << "FAIL: batch results differ from scalar in " << bad << " cases" << std::endl;
+    else std::cout << "Batch results bit-exact with scalar." << std::endl;
+    return 0;
+}
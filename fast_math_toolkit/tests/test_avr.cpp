@@ -4,6 +4,7 @@
 
 #define INCLUDE_TABLES "arduino_tables_generated.h"
 #include "../FMT.h"
+#include "../FMT_Expr.h"
 
 static int uart_putchar(char c, FILE *stream) {
     if (c == '\n') uart_putchar('\r', stream);
@@ -38,10 +39,15 @@ __attribute__((noinline)) int32_t bench_q16_div_s(int32_t a, int32_t b) { return
 __attribute__((noinline)) int32_t bench_q16_div_s_ap(int32_t a, int32_t b) { return FMT::q16_div_s_ap(a, b); }
 __attribute__((noinline)) FMT::Vec3 bench_mat3_mul_vec(const FMT::Mat3* M, FMT::Vec3 v) { return FMT::mat3_mul_vec(M, v); }
 __attribute__((noinline)) FMT::Mat3 bench_mat3_mul_mat(const FMT::Mat3* A, const FMT::Mat3* B) { return FMT::mat3_mul_mat(A, B); }
+__attribute__((noinline)) FMT::Vec3 bench_mat3s16_mul_vec(const FMT::Mat3s16* M, FMT::Vec3 v) { return FMT::mat3s16_mul_vec(M, v); }
+__attribute__((noinline)) FMT::Mat3s16 bench_mat3s16_mul_mat(const FMT::Mat3s16* A, const FMT::Mat3s16* B) { return FMT::mat3s16_mul_mat(A, B); }
+__attribute__((noinline)) FMT::Quats16 bench_quats16_mul(FMT::Quats16 a, FMT::Quats16 b) { return FMT::quats16_mul(a, b); }
 __attribute__((noinline)) FMT::Quat bench_quat_mul_quat(FMT::Quat a, FMT::Quat b) { return FMT::quat_mul_quat(a, b); }
 __attribute__((noinline)) FMT::Vec3 bench_quat_rotate_vec(FMT::Quat q, FMT::Vec3 v) { return FMT::quat_rotate_vec(q, v); }
 __attribute__((noinline)) FMT::Quat bench_quat_normalize(FMT::Quat q) { return FMT::quat_normalize(q); }
 __attribute__((noinline)) int32_t bench_vec3_length(FMT::Vec3 v) { return FMT::vec3_length(v); }
+__attribute__((noinline)) int32_t bench_vec3_length_ap(FMT::Vec3 v) { return FMT::vec3_length_ap(v); }
+__attribute__((noinline)) uint32_t bench_hypot2(int32_t x, int32_t y) { return FMT::hypot2(x, y); }
 __attribute__((noinline)) FMT::Vec3 bench_vec3_normalize(FMT::Vec3 v) { return FMT::vec3_normalize(v); }
 __attribute__((noinline)) FMT::Vec3 bench_vec3_normalize_ap(FMT::Vec3 v) { return FMT::vec3_normalize_ap(v); }
 __attribute__((noinline)) FMT::Log32 bench_log32_add(FMT::Log32 a, FMT::Log32 b) { return FMT::log32_add(a, b); }
@@ -49,11 +55,65 @@ __attribute__((noinline)) int16_t bench_sin(uint16_t a) { return FMT::sin_u16(a)
 __attribute__((noinline)) FMT::Log32 bench_sin_log(uint16_t a) { return FMT::sin_log(a); }
 __attribute__((noinline)) uint16_t bench_atan2(int32_t y, int32_t x) { return FMT::atan2_u16(y, x); }
 __attribute__((noinline)) uint16_t bench_acos(int32_t x) { return FMT::acos_u16(x); }
+__attribute__((noinline)) uint16_t bench_asin(int32_t x) { return FMT::asin_u16(x); }
+__attribute__((noinline)) int32_t bench_tan(uint16_t a) { return FMT::tan_u16(a); }
 __attribute__((noinline)) FMT::Mat3 bench_rotation(uint16_t x, uint16_t y, uint16_t z) { return FMT::mat3_rotation_euler(x, y, z); }
 __attribute__((noinline)) FMT::Mat3 bench_rotation_ap(uint16_t x, uint16_t y, uint16_t z) { return FMT::mat3_rotation_euler_ap(x, y, z); }
 __attribute__((noinline)) FMT::Mat4 bench_mat4_mul(const FMT::Mat4* A, const FMT::Mat4* B) { return FMT::mat4_mul(A, B); }
+__attribute__((noinline)) FMT::Mat34 bench_mat34_mul(const FMT::Mat34* A, const FMT::Mat34* B) { return FMT::mat34_mul(A, B); }
+__attribute__((noinline)) FMT::Mat3 bench_quat_to_mat3(FMT::Quat q) { return FMT::quat_to_mat3(q); }
+__attribute__((noinline)) FMT::Vec3 bench_quat_rotate(FMT::Quat q, FMT::Vec3 v) { return FMT::quat_rotate_vec(q, v); }
+__attribute__((noinline)) FMT::Quat bench_quat_slerp(FMT::Quat a, FMT::Quat b, int32_t t) { return FMT::quat_slerp(a, b, t); }
+__attribute__((noinline)) FMT::Quat bench_quat_nlerp(FMT::Quat a, FMT::Quat b, int32_t t) { return FMT::quat_nlerp(a, b, t); }
+__attribute__((noinline)) FMT::Vec4 bench_chain_materialized(const FMT::Mat4* P, const FMT::Mat4* V, const FMT::Mat4* M, FMT::Vec3 v) {
+    FMT::Mat4 PV = FMT::mat4_mul(P, V);
+    FMT::Mat4 PVM = FMT::mat4_mul(&PV, M);
+    FMT::Vec4 h = {v.x, v.y, v.z, 0x10000};
+    return FMT::mat4_mul_vec4(&PVM, h);
+}
+__attribute__((noinline)) FMT::Vec4 bench_chain_expr(const FMT::Mat4* P, const FMT::Mat4* V, const FMT::Mat4* M, FMT::Vec3 v) {
+    using FMT::operator*;
+    return *P * FMT::expr_affine(*V) * FMT::expr_affine(*M) * v;
+}
 __attribute__((noinline)) FMT::Mat4 bench_mat4_mul_affine(const FMT::Mat4* A, const FMT::Mat4* B) { return FMT::mat4_mul_affine(A, B); }
 
+#define BENCH_VERTS 8
+static int32_t g_vx[BENCH_VERTS], g_vy[BENCH_VERTS], g_vz[BENCH_VERTS];
+static int32_t g_ox[BENCH_VERTS], g_oy[BENCH_VERTS], g_oz[BENCH_VERTS];
+
+__attribute__((noinline)) void bench_pipeline_loop(FMT::Vec3 trans) {
+    for (uint8_t i = 0; i < BENCH_VERTS; i++) {
+        FMT::Vec3 p = FMT::pipeline_mvp_fused(FMT::vec3_init(g_vx[i], g_vy[i], g_vz[i]), 0x10000, 1000, 2000, 3000, trans, 0x1000000);
+        g_ox[i] = p.x; g_oy[i] = p.y; g_oz[i] = p.z;
+    }
+}
+__attribute__((noinline)) void bench_transform_batch_ap(FMT::Vec3 trans) {
+    FMT::Mat4 M = FMT::mat4_model(0x10000, 1000, 2000, 3000, trans);
+    FMT::transform_project_batch_ap(&M, 0x1000000, g_vx, g_vy, g_vz, g_ox, g_oy, g_oz, BENCH_VERTS);
+}
+
+static const int16_t PROGMEM cube_verts[24] = {
+    -32767, -32767, -32767, -32767, 32767, -32767, 32767, 32767, -32767, 32767, -32767, -32767,
+    -32767, -32767, 32767, 32767, -32767, 32767, 32767, 32767, 32767, -32767, 32767, 32767
+};
+static const uint8_t PROGMEM cube_indices[36] = {
+    0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7, 0, 3, 5, 0, 5, 4,
+    3, 2, 6, 3, 6, 5, 2, 1, 7, 2, 7, 6, 1, 0, 4, 1, 4, 7
+};
+static const int32_t PROGMEM cube_quant[4] = {131077, 0, 0, 0};
+
+__attribute__((noinline)) uint16_t bench_mesh_stream(const FMT::MeshQ *m, const FMT::Mat34 *mv) {
+    FMT::MeshStream ms;
+    FMT::mesh_stream_begin(&ms, m, mv, 0x1000000);
+    FMT::Vec3 tri[3];
+    while (FMT::mesh_stream_next(&ms, tri)) g_sink = tri[0].x;
+    return ms.transformed;
+}
+
+__attribute__((noinline)) uint16_t bench_light_vertex(const FMT::Light *l, const FMT::Material *m, FMT::Vec3 p, FMT::Vec3 n, FMT::Vec3 eye) {
+    return FMT::light_vertex(l, 1, m, p, n, eye, 32);
+}
+
 int main(void) {
     UBRR0H = 0;
     UBRR0L = 103;
@@ -120,6 +180,28 @@ int main(void) {
     g_sink = RQ.w;
     printf("quat_mul_quat: %u cycles\n", c7q - 4);
 
+    FMT::Mat3s16 Ms = FMT::mat3s16_from_mat3(&M);
+    FMT::Quats16 Qs = FMT::quats16_from_quat(Q);
+    asm volatile("" : "+g"(Ms), "+g"(Qs));
+
+    start_timer();
+    FMT::Vec3 rv1s = bench_mat3s16_mul_vec(&Ms, v1);
+    uint16_t c6s = stop_timer();
+    g_sink = rv1s.x;
+    printf("mat3s16_mul_vec: %u cycles\n", c6s - 4);
+
+    start_timer();
+    FMT::Mat3s16 RMs = bench_mat3s16_mul_mat(&Ms, &Ms);
+    uint16_t c6ms = stop_timer();
+    g_sink = RMs.m[0][0];
+    printf("mat3s16_mul_mat: %u cycles\n", c6ms - 4);
+
+    start_timer();
+    FMT::Quats16 RQs = bench_quats16_mul(Qs, Qs);
+    uint16_t c7qs = stop_timer();
+    g_sink = RQs.w;
+    printf("quats16_mul: %u cycles\n", c7qs - 4);
+
     start_timer();
     FMT::Vec3 rvn_ex = bench_vec3_normalize(v1);
     uint16_t c7vn_ex = stop_timer();
@@ -150,6 +232,18 @@ int main(void) {
     g_sink = vlen;
     printf("vec3_length: %u cycles\n", c7l - 4);
 
+    start_timer();
+    int32_t vlen_ap = bench_vec3_length_ap(v1);
+    uint16_t c7la = stop_timer();
+    g_sink = vlen_ap;
+    printf("vec3_length_ap: %u cycles\n", c7la - 4);
+
+    start_timer();
+    uint32_t hyp = bench_hypot2(s1, s2);
+    uint16_t c7h = stop_timer();
+    g_sink = hyp;
+    printf("hypot2: %u cycles\n", c7h - 4);
+
     start_timer();
     FMT::Log32 la = FMT::to_log32(100);
     FMT::Log32 lb = FMT::to_log32(200);
@@ -182,6 +276,18 @@ int main(void) {
     g_sink = ac16;
     printf("acos_u16: %u cycles\n", c8ac - 4);
 
+    start_timer();
+    uint16_t as16 = bench_asin(s1);
+    uint16_t c8as = stop_timer();
+    g_sink = as16;
+    printf("asin_u16: %u cycles\n", c8as - 4);
+
+    start_timer();
+    int32_t t16 = bench_tan(u1);
+    uint16_t c8t = stop_timer();
+    g_sink = t16;
+    printf("tan_u16: %u cycles\n", c8t - 4);
+
     start_timer();
     FMT::Mat4 M4 = FMT::mat4_identity();
     FMT::Mat4 RM4 = bench_mat4_mul(&M4, &M4);
@@ -195,6 +301,55 @@ int main(void) {
     g_sink = RM4a.m[0][0];
     printf("mat4_mul_affine: %u cycles\n", c10a - 4);
 
+    FMT::Mat4 PM = FMT::mat4_perspective(0x1000000);
+    asm volatile("" : "+g"(PM));
+    start_timer();
+    FMT::Vec4 ch = bench_chain_materialized(&PM, &M4, &M4, v1);
+    uint16_t c10g = stop_timer();
+    g_sink = ch.w;
+    printf("P*V*M*v (mat4_mul x2 + mat4_mul_vec4): %u cycles\n", c10g - 4);
+
+    start_timer();
+    FMT::Vec4 che = bench_chain_expr(&PM, &M4, &M4, v1);
+    uint16_t c10h = stop_timer();
+    g_sink = che.w;
+    printf("P*V*M*v (FMT_Expr, right to left): %u cycles\n", c10h - 4);
+
+    start_timer();
+    FMT::Mat34 M34 = FMT::mat34_identity();
+    FMT::Mat34 RM34 = bench_mat34_mul(&M34, &M34);
+    uint16_t c10b = stop_timer();
+    g_sink = RM34.m[0][0];
+    printf("mat34_mul: %u cycles\n", c10b - 4);
+
+    FMT::Quat qa = {0x10000, 0, 0, 0};
+    FMT::Quat qb = FMT::quat_from_axis_angle(0, 0x10000, 0, 16384);
+    asm volatile("" : "+g"(qb));
+
+    start_timer();
+    FMT::Mat3 QM = bench_quat_to_mat3(qb);
+    uint16_t c10c = stop_timer();
+    g_sink = QM.m[0][0];
+    printf("quat_to_mat3: %u cycles\n", c10c - 4);
+
+    start_timer();
+    FMT::Vec3 qv = bench_quat_rotate(qb, v1);
+    uint16_t c10d = stop_timer();
+    g_sink = qv.z;
+    printf("quat_rotate_vec: %u cycles\n", c10d - 4);
+
+    start_timer();
+    FMT::Quat qs = bench_quat_slerp(qa, qb, 0x4000);
+    uint16_t c10e = stop_timer();
+    g_sink = qs.w;
+    printf("quat_slerp: %u cycles\n", c10e - 4);
+
+    start_timer();
+    FMT::Quat qn = bench_quat_nlerp(qa, qb, 0x4000);
+    uint16_t c10f = stop_timer();
+    g_sink = qn.w;
+    printf("quat_nlerp: %u cycles\n", c10f - 4);
+
     start_timer();
     FMT::Mat3 RM2 = bench_rotation(0, 16384, 0);
     uint16_t c9 = stop_timer();
@@ -207,6 +362,42 @@ int main(void) {
     g_sink = RM2ap.m[0][0];
     printf("mat3_rotation_euler_ap: %u cycles\n", c9a - 4);
 
+    FMT::Vec3 tr = {0, 0, 0x200000};
+    for (uint8_t i = 0; i < BENCH_VERTS; i++) { g_vx[i] = (int32_t)i << 16; g_vy[i] = 0x8000; g_vz[i] = -0x4000; }
+    asm volatile("" : "+g"(tr));
+
+    start_timer();
+    bench_pipeline_loop(tr);
+    uint16_t c11 = stop_timer();
+    g_sink = g_ox[1];
+    printf("pipeline_mvp_fused x%d: %u cycles\n", BENCH_VERTS, c11 - 4);
+
+    start_timer();
+    bench_transform_batch_ap(tr);
+    uint16_t c11b = stop_timer();
+    g_sink = g_ox[1];
+    printf("transform_project_batch_ap x%d: %u cycles\n", BENCH_VERTS, c11b - 4);
+
+    FMT::Light bulb = {{0x20000, 0x20000, -0x40000}, 255, 240, 200, FMT::LIGHT_POINT};
+    FMT::Material mat = {180, 120, 60, 128, 24};
+    FMT::Vec3 nrm = {0, 0, -0x10000}, eye = {0, 0, -0x100000};
+    asm volatile("" : "+g"(nrm));
+
+    start_timer();
+    uint16_t lit = bench_light_vertex(&bulb, &mat, v1, nrm, eye);
+    uint16_t c12 = stop_timer();
+    g_sink = lit;
+    printf("light_vertex (point, specular): %u cycles\n", c12 - 4);
+
+    FMT::MeshQ cube;
+    FMT::mesh_init(&cube, cube_verts, 24, cube_indices, 36, cube_quant);
+    FMT::Mat34 cube_mv = FMT::mat34_model(0x10000, 1000, 2000, 0, tr);
+
+    start_timer();
+    uint16_t xformed = bench_mesh_stream(&cube, &cube_mv);
+    uint16_t c13 = stop_timer();
+    printf("mesh_stream cube (12 tris, %u vertex transforms): %u cycles\n", xformed, c13 - 4);
+
     printf("DONE\n");
     while(1);
     return 0;
@@ -7,6 +7,8 @@
 
 #define INCLUDE_TABLES "arduino_tables_generated.h"
 #include "../FMT.h"
+#include "../FMT_Expr.h"
+#include "../FMT_Tiles.h"
 
 using namespace FMT;
 
@@ -67,6 +69,19 @@ void test_trig() {
     EXPECT_NEAR(acos_u16(Q16_ONE), 0, 10);
     EXPECT_NEAR(acos_u16(0), 16384, 10); // 90 deg
     EXPECT_NEAR(acos_u16(-Q16_ONE), 32768, 10); // 180 deg
+
+    // asin
+    EXPECT_NEAR(asin_u16(0), 0, 10);
+    EXPECT_NEAR(asin_u16(Q16_ONE), 16384, 10); // 90 deg
+    EXPECT_NEAR(asin_u16(Q16_ONE / 2), 5461, 300); // 30 deg
+    EXPECT_NEAR(asin_u16(-Q16_ONE), 49152, 10); // -90 deg
+
+    // tan
+    EXPECT_NEAR(tan_u16(0), 0, 10);
+    EXPECT_NEAR(q16_to_float(tan_u16(8192)), 1.0f, 0.01f); // 45 deg
+    EXPECT_NEAR(q16_to_float(tan_u16(24576)), -1.0f, 0.01f); // 135 deg
+    EXPECT_NEAR(q16_to_float(from_log32(tan_log(4096))), tan(M_PI / 8), 0.01f);
+    if (tan_u16(16384) != 0x7FFFFFFF) std::cout << "FAIL: tan_u16(90 deg) saturation" << std::endl;
 }
 
 void test_3d() {
@@ -82,6 +97,14 @@ void test_3d() {
     Vec3 vn = vec3_normalize(vec3_init(0x20000, 0, 0));
     EXPECT_NEAR(q16_to_float(vn.x), 1.0f, 0.01f);
 
+    // Log-domain magnitudes
+    EXPECT_NEAR(q16_to_float(hypot2(q16_from_float(3.0f), q16_from_float(-4.0f))), 5.0f, 0.05f);
+    EXPECT_NEAR(q16_to_float(hypot2(0, q16_from_float(-2.0f))), 2.0f, 0.001f);
+    EXPECT_NEAR(q16_to_float(hypot3(q16_from_float(2.0f), q16_from_float(3.0f), q16_from_float(6.0f))), 7.0f, 0.07f);
+    Vec3 vl = vec3_init(q16_from_float(1.0f), q16_from_float(2.0f), q16_from_float(2.0f));
+    EXPECT_NEAR(q16_to_float(vec3_length_ap(vl)), q16_to_float(vec3_length(vl)), 0.05f);
+    EXPECT_NEAR(q16_to_float(vec3_dist_ap(vl, v1)), 2.828f, 0.03f);
+
     Mat3 Ry = mat3_rotation_euler(0, 16384, 0);
     Vec3 vry = mat3_mul_vec(&Ry, v1);
     EXPECT_NEAR(q16_to_float(vry.z), -1.0f, 0.01f);
@@ -104,6 +127,38 @@ void test_3d() {
     Vec3 vr2 = quat_rotate_vec(q3, v1);
     EXPECT_NEAR(q16_to_float(vr2.x), -1.0f, 0.01f);
 
+    // quat_to_mat3 agrees with quat_rotate_vec
+    Quat qa = quat_normalize(quat_from_axis_angle(q16_from_float(0.48f), q16_from_float(0.6f), q16_from_float(0.64f), 12000));
+    Mat3 Rq = quat_to_mat3(qa);
+    Vec3 vq = vec3_init(q16_from_float(3.0f), q16_from_float(-1.0f), q16_from_float(2.0f));
+    Vec3 vm = mat3_mul_vec(&Rq, vq), vv = quat_rotate_vec(qa, vq);
+    EXPECT_NEAR(vm.x, vv.x, 32); EXPECT_NEAR(vm.y, vv.y, 32); EXPECT_NEAR(vm.z, vv.z, 32);
+    Vec3 vb[2] = {vq, v1}, vbo[2];
+    quat_rotate_batch(qa, vb, vbo, 2);
+    EXPECT_NEAR(vbo[0].y, vm.y, 0);
+
+    // slerp from identity to ~120 deg around Z advances the angle linearly in t
+    Quat qi = {Q16_ONE, 0, 0, 0};
+    Quat qz = quat_from_axis_angle(0, 0, Q16_ONE, 21845);
+    double qz_ang = 2.0 * std::acos(q16_to_float(qz.w)) * 180.0 / M_PI;
+    for (int k = 1; k < 4; k++) {
+        Quat qs = quat_slerp(qi, qz, k * Q16_ONE / 4);
+        double ang = 2.0 * std::acos(q16_to_float(qs.w)) * 180.0 / M_PI;
+        EXPECT_NEAR(ang, qz_ang * k / 4, 1.5);
+        EXPECT_NEAR(q16_to_float(qs.w) * q16_to_float(qs.w) + q16_to_float(qs.z) * q16_to_float(qs.z), 1.0, 0.01);
+    }
+    Quat qe = quat_slerp(qi, qz, Q16_ONE);
+    EXPECT_NEAR(qe.z, qz.z, 0x300);
+    Quat qn = quat_slerp(qi, quat_from_axis_angle(0, 0, Q16_ONE, 200), Q16_ONE / 2); // nlerp path
+    EXPECT_NEAR(qn.z, quat_from_axis_angle(0, 0, Q16_ONE, 100).z, 0x20);
+
+    // 90 deg/s around Y for one second in 1/64 s steps
+    Quat qt = qi;
+    Vec3 omega = vec3_init(0, q16_from_float(1.5708f), 0);
+    for (int k = 0; k < 64; k++) qt = quat_integrate(qt, omega, Q16_ONE / 64);
+    Vec3 vi = quat_rotate_vec(qt, v1);
+    EXPECT_NEAR(q16_to_float(vi.z), -1.0f, 0.02f);
+
     Mat4 M1 = mat4_translation(q16_from_float(10.0f), 0, 0);
     Mat4 M2 = mat4_translation(0, q16_from_float(5.0f), 0);
     Mat4 M3 = mat4_mul(&M1, &M2);
@@ -140,6 +195,31 @@ void test_3d() {
     EXPECT_NEAR(q16_to_float(M_prod.m[2][2]), 1.0f, 0.01f);
     EXPECT_NEAR(q16_to_float(M_prod.m[0][3]), 0.0f, 0.01f);
 
+    // Mat34 affine
+    Mat34 A34 = mat34_model(q16_from_float(2.0f), 0, 16384, 0, vec3_init(q16_from_float(1.0f), q16_from_float(2.0f), 0));
+    Mat4 A4 = mat34_to_mat4(&A34);
+    Mat34 B34 = mat34_from_mat4(&M_rot);
+    Mat34 AB34 = mat34_mul(&A34, &B34);
+    Mat4 AB4 = mat4_mul(&A4, &M_rot);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++)
+            if (AB34.m[i][j] != AB4.m[i][j]) std::cout << "FAIL: mat34_mul differs from mat4_mul at " << i << "," << j << std::endl;
+    Vec3 p34 = mat34_mul_point(&A34, v4);
+    EXPECT_NEAR(q16_to_float(p34.x), 1.0f, 0.01f);
+    EXPECT_NEAR(q16_to_float(p34.z), -2.0f, 0.01f);
+    Vec3 d34 = mat34_mul_dir(&A34, v4);
+    EXPECT_NEAR(q16_to_float(d34.x), 0.0f, 0.01f);
+    EXPECT_NEAR(q16_to_float(d34.z), -2.0f, 0.01f);
+    Mat34 A34i = mat34_inverse(&A34);
+    Vec3 p34i = mat34_mul_point(&A34i, p34);
+    EXPECT_NEAR(q16_to_float(p34i.x), 1.0f, 0.01f);
+    EXPECT_NEAR(q16_to_float(p34i.y), 0.0f, 0.01f);
+    EXPECT_NEAR(q16_to_float(p34i.z), 0.0f, 0.01f);
+    Mat34 R34i = mat34_inverse_rot(&B34);
+    Mat4 R4i = mat4_inverse_affine_rot(&M_rot);
+    EXPECT_NEAR(R34i.m[0][3], R4i.m[0][3], 0);
+    EXPECT_NEAR(R34i.m[2][3], R4i.m[2][3], 0);
+
     Mat4 Mp = mat4_perspective(0x10000); // focal 1.0
     Vec4 v5 = {0, 0x10000, 0x10000, 0x10000}; // (0,1,1)
     Vec4 vp5 = mat4_mul_vec4(&Mp, v5);
@@ -160,6 +240,140 @@ void test_3d() {
     }
 }
 
+void test_3d16() {
+    std::cout << "Testing FMT_3d16..." << std::endl;
+    // q16_mul_q14 matches the 64-bit product exactly
+    int bad = 0;
+    for (int i = 0; i < 10000; i++) {
+        int32_t a = (int32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand()) >> 4;
+        int16_t b = (int16_t)rand();
+        if (q16_mul_q14(a, b) != (int32_t)(((int64_t)a * b) >> Q14_S)) bad++;
+    }
+    EXPECT_NEAR(bad, 0, 0);
+
+    // Widening is exact, so compact values round-trip
+    Vec3s16 n = vec3s16_init(-16384, 9459, 12345);
+    Vec3s16 n2 = vec3s16_from_vec3(vec3_from_vec3s16(n));
+    EXPECT_NEAR(n2.x, n.x, 0);
+    EXPECT_NEAR(n2.y, n.y, 0);
+    EXPECT_NEAR(n2.z, n.z, 0);
+    EXPECT_NEAR(q14_from_q16(3 * Q16_ONE), 32767, 0);
+
+    // Compact rotation agrees with the Q16.16 one to within the Q1.14 step
+    Mat3 R = mat3_rotation_euler(5000, 12000, 30000);
+    Mat3s16 Rs = mat3s16_from_mat3(&R);
+    Vec3 p = vec3_init(q16_from_float(12.5f), q16_from_float(-3.25f), q16_from_float(40.0f));
+    Vec3 a = mat3_mul_vec(&R, p), b = mat3s16_mul_vec(&Rs, p);
+    EXPECT_NEAR(q16_to_float(b.x), q16_to_float(a.x), 0.01f);
+    EXPECT_NEAR(q16_to_float(b.y), q16_to_float(a.y), 0.01f);
+    EXPECT_NEAR(q16_to_float(b.z), q16_to_float(a.z), 0.01f);
+    EXPECT_NEAR(vec3s16_dot_vec3(vec3s16_init(0, Q14_ONE, 0), p), p.y, 0);
+
+    Vec3s16 up = mat3s16_mul_vec_s16(&Rs, vec3s16_init(0, Q14_ONE, 0));
+    EXPECT_NEAR(up.x, Rs.m[0][1], 1);
+    EXPECT_NEAR(vec3s16_dot(up, up), Q14_ONE, 8);
+    Mat3 RR = mat3_mul_mat(&R, &R);
+    Mat3s16 RRs = mat3s16_mul_mat(&Rs, &Rs);
+    EXPECT_NEAR(q16_from_q14(RRs.m[2][0]), RR.m[2][0], 16);
+
+    // Quaternion path
+    Quat q = quat_normalize(quat_from_axis_angle(q16_from_float(0.6f), q16_from_float(0.8f), 0, 11000));
+    Quats16 qs = quats16_from_quat(q);
+    Mat3 Q = quat_to_mat3(q);
+    Mat3s16 Qs = quats16_to_mat3s16(qs);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++) EXPECT_NEAR(q16_from_q14(Qs.m[i][j]), Q.m[i][j], 24);
+    Quats16 qq = quats16_mul(qs, qs);
+    Quat qq32 = quat_mul_quat(q, q);
+    EXPECT_NEAR(q16_from_q14(qq.w), qq32.w, 16);
+    EXPECT_NEAR(q16_from_q14(qq.z), qq32.z, 16);
+    Vec3 out;
+    quats16_rotate_batch(qs, &p, &out, 1);
+    Vec3 ref = quat_rotate_vec(q, p);
+    EXPECT_NEAR(q16_to_float(out.x), q16_to_float(ref.x), 0.02f);
+    EXPECT_NEAR(q16_to_float(out.z), q16_to_float(ref.z), 0.02f);
+}
+
+void test_expr() {
+    std::cout << "Testing FMT_Expr..." << std::endl;
+    Mat4 P = mat4_perspective(q16_from_float(100.0f));
+    Mat4 V = mat4_model(Q16_ONE, 0, 2000, 0, vec3_init(0, 0, q16_from_float(-5.0f)));
+    Mat34 M = mat34_model(q16_from_float(1.5f), 3000, 0, 9000, vec3_init(q16_from_float(2.0f), 0, q16_from_float(30.0f)));
+    Mat4 M4 = mat34_to_mat4(&M);
+    Vec3 v = vec3_init(q16_from_float(1.0f), q16_from_float(-2.0f), q16_from_float(0.5f));
+
+    // Reference: materialized matrix products, then one product with the point
+    Mat4 PV = mat4_mul(&P, &V);
+    Mat4 PVM = mat4_mul(&PV, &M4);
+    Vec4 v4 = {v.x, v.y, v.z, Q16_ONE};
+    Vec4 ref = mat4_mul_vec4(&PVM, v4);
+
+    Vec4 a = P * expr_affine(V) * M * v;
+    EXPECT_NEAR(q16_to_float(a.x), q16_to_float(ref.x), 0.05f);
+    EXPECT_NEAR(q16_to_float(a.y), q16_to_float(ref.y), 0.05f);
+    EXPECT_NEAR(q16_to_float(a.w), q16_to_float(ref.w), 0.05f);
+    Vec4 b = P * V * M4 * v;
+    EXPECT_NEAR(b.x, a.x, 64);
+    EXPECT_NEAR(b.w, a.w, 64);
+
+    // All-affine chains stay Vec3 / Mat34
+    Mat3 R = mat3_rotation_euler(1000, 0, 0);
+    Vec3 c = expr_affine(V) * M * R * v;
+    Mat34 VMR = expr_eval(expr_affine(V) * M * R);
+    Vec3 d = mat34_mul_point(&VMR, v);
+    EXPECT_NEAR(q16_to_float(c.z), q16_to_float(d.z), 0.01f);
+
+    Mat4 E = expr_eval(P * expr_affine(V) * M);
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++) EXPECT_NEAR(q16_to_float(E.m[i][j]), q16_to_float(PVM.m[i][j]), 0.01f);
+
+    // Batch: the collapsed and per-point paths agree
+    Vec3 in[16];
+    Vec4 out[16];
+    for (int i = 0; i < 16; i++) in[i] = vec3_init((i - 8) << 15, (i * 3) << 13, -(i << 14));
+    expr_transform(P * expr_affine(V) * M, in, out, 16);
+    Vec4 one;
+    expr_transform(P * expr_affine(V) * M, &in[5], &one, 1);
+    EXPECT_NEAR(q16_to_float(out[5].x), q16_to_float(one.x), 0.05f);
+    EXPECT_NEAR(q16_to_float(out[5].w), q16_to_float(one.w), 0.05f);
+    EXPECT_NEAR((ExprProd<ExprMat4, ExprMat34>::EVAL_MACS), 48, 0);
+}
+
+void test_transform_node() {
+    std::cout << "Testing Transform nodes..." << std::endl;
+    Transform root, arm, hand;
+    transform_init(&root);
+    transform_init(&arm);
+    transform_init(&hand);
+    transform_set_parent(&arm, &root);
+    transform_set_parent(&hand, &arm);
+
+    transform_set_translation(&root, vec3_init(q16_from_float(10.0f), 0, 0));
+    transform_set_rotation(&root, 0, 0, 16384); // 90 deg around Z
+    transform_set_translation(&arm, vec3_init(q16_from_float(2.0f), 0, 0));
+    transform_set_scale(&hand, q16_from_float(2.0f));
+    transform_set_translation(&hand, vec3_init(q16_from_float(1.0f), 0, 0));
+
+    Vec3 p = mat34_mul_point(transform_world(&hand), vec3_init(Q16_ONE, 0, 0));
+    // hand: (1,0,0) -> (3,0,0), arm: (5,0,0), root: rotate to (0,5,0) then (10,5,0)
+    EXPECT_NEAR(q16_to_float(p.x), 10.0f, 0.02f);
+    EXPECT_NEAR(q16_to_float(p.y), 5.0f, 0.02f);
+
+    uint16_t root_rev = root.rev, arm_rev = arm.rev, hand_rev = hand.rev;
+    transform_world(&hand);
+    if (root.rev != root_rev || hand.rev != hand_rev) std::cout << "FAIL: clean Transform rebuilt" << std::endl;
+
+    transform_set_rotation(&hand, 0, 0, 0); // unchanged value must not dirty the node
+    transform_world(&hand);
+    if (hand.rev != hand_rev) std::cout << "FAIL: unchanged setter dirtied Transform" << std::endl;
+
+    transform_set_rotation(&root, 0, 0, 0);
+    p = mat34_mul_point(transform_world(&hand), vec3_init(Q16_ONE, 0, 0));
+    EXPECT_NEAR(q16_to_float(p.x), 15.0f, 0.02f);
+    EXPECT_NEAR(q16_to_float(p.y), 0.0f, 0.02f);
+    if (hand.rev == hand_rev || arm.rev == arm_rev) std::cout << "FAIL: parent change not propagated" << std::endl;
+}
+
 void test_ring() {
     std::cout << "Testing FMT_Ring..." << std::endl;
     Log32 la = to_log32(100);
@@ -183,6 +397,815 @@ void test_fused_pipeline() {
     EXPECT_NEAR(q16_to_float(vp1.y), q16_to_float(vp2.y), 0.1f);
 }
 
+void test_batch() {
+    std::cout << "Testing FMT_Batch..." << std::endl;
+    const size_t n = 4099; // not a multiple of the vector width, exercises the tail loop
+    std::vector<uint16_t> ang(n), atn(n);
+    std::vector<int16_t> s(n), c(n);
+    std::vector<Log32> ls(n);
+    std::vector<int32_t> ys(n), xs(n);
+    for (size_t i = 0; i < n; i++) {
+        ang[i] = (uint16_t)(i * 16);
+        ys[i] = (int32_t)(rand() - RAND_MAX / 2);
+        xs[i] = (int32_t)(rand() - RAND_MAX / 2);
+    }
+    ys[0] = 0; xs[0] = 0;
+    ys[1] = 0; xs[1] = -5;
+    ys[2] = -5; xs[2] = 0;
+    ys[3] = -2147483647 - 1; xs[3] = 7;
+
+    sincos_u16_batch(ang.data(), s.data(), c.data(), n);
+    sin_log_batch(ang.data(), ls.data(), n);
+    atan2_u16_batch(ys.data(), xs.data(), atn.data(), n);
+
+    int bad = 0;
+    for (size_t i = 0; i < n; i++) {
+        Log32 l = sin_log(ang[i]);
+        if (s[i] != sin_u16(ang[i]) || c[i] != cos_u16(ang[i])) bad++;
+        if (ls[i].lval != l.lval || ls[i].sign != l.sign) bad++;
+        if (atn[i] != atan2_u16(ys[i], xs[i])) bad++;
+    }
+    if (bad) std::cout << "FAIL: batch trig differs from scalar in " << bad << " cases" << std::endl;
+}
+
+void test_batch_transform() {
+    std::cout << "Testing transform_project_batch..." << std::endl;
+    const size_t n = 301;
+    int32_t scale = q16_from_float(1.5f);
+    uint16_t ax = 1000, ay = 20000, az = 40000;
+    Vec3 trans = {q16_from_float(1.0f), q16_from_float(-2.0f), q16_from_float(40.0f)};
+    int32_t focal = q16_from_float(256.0f);
+    Mat4 M = mat4_model(scale, ax, ay, az, trans);
+
+    std::vector<int32_t> x(n), y(n), z(n), ox(n), oy(n), oz(n), rx(n), ry(n), rz(n), px(n), py(n), pz(n);
+    for (size_t i = 0; i < n; i++) {
+        x[i] = (int32_t)(rand() % 0x100000) - 0x80000;
+        y[i] = (int32_t)(rand() % 0x100000) - 0x80000;
+        z[i] = (int32_t)(rand() % 0x100000) - 0x80000;
+    }
+    transform_project_batch(&M, focal, x.data(), y.data(), z.data(), ox.data(), oy.data(), oz.data(), n);
+    transform_project_batch_ap(&M, focal, x.data(), y.data(), z.data(), px.data(), py.data(), pz.data(), n);
+    int bad = 0;
+    for (size_t i = 0; i < n; i++) {
+        // one vertex per call always takes the scalar loop
+        transform_project_batch(&M, focal, &x[i], &y[i], &z[i], &rx[i], &ry[i], &rz[i], 1);
+        if (ox[i] != rx[i] || oy[i] != ry[i] || oz[i] != rz[i]) bad++;
+        Vec3 ref = pipeline_mvp(vec3_init(x[i], y[i], z[i]), scale, ax, ay, az, trans, focal);
+        EXPECT_NEAR(q16_to_float(ox[i]), q16_to_float(ref.x), 0.01f);
+        EXPECT_NEAR(q16_to_float(oy[i]), q16_to_float(ref.y), 0.01f);
+        EXPECT_NEAR(q16_to_float(oz[i]), q16_to_float(ref.z), 0.01f);
+        EXPECT_NEAR(q16_to_float(px[i]), q16_to_float(ref.x), 0.05f + std::abs(q16_to_float(ref.x)) * 0.01f);
+    }
+    if (bad) std::cout << "FAIL: transform_project_batch vector path differs in " << bad << " cases" << std::endl;
+}
+
+void test_raster() {
+    std::cout << "Testing FMT_Raster..." << std::endl;
+    const int T = 64;
+    int32_t focal = q16_from_float(64.0f);
+    // Quad covering pixels 8..39 split along its diagonal (screen centre at 0,0, y up)
+    Vec3 p00 = {8 << 16, -8 << 16, 0}, p10 = {40 << 16, -8 << 16, 0};
+    Vec3 p01 = {8 << 16, -40 << 16, 0}, p11 = {40 << 16, -40 << 16, 0};
+    RasterTri tris[3];
+    if (!raster_tri_setup(&tris[0], p00, p10, p11, focal, 0, 0, 0x001F) ||
+        !raster_tri_setup(&tris[1], p00, p11, p01, focal, 0, 0, 0x07E0)) std::cout << "FAIL: raster_tri_setup" << std::endl;
+
+    std::vector<uint16_t> c0(T * T, 0), c1(T * T, 0), depth(T * T);
+    uint16_t item0 = 0, item1 = 1;
+    raster_tile(tris, &item0, 1, c0.data(), depth.data(), 0, 0, T, T);
+    raster_tile(tris, &item1, 1, c1.data(), depth.data(), 0, 0, T, T);
+    int overlap = 0, covered = 0;
+    for (int i = 0; i < T * T; i++) {
+        if (c0[i] && c1[i]) overlap++;
+        if (c0[i] || c1[i]) covered++;
+    }
+    if (overlap) std::cout << "FAIL: shared edge rasterized twice (" << overlap << " px)" << std::endl;
+    EXPECT_NEAR(covered, 32 * 32, 0);
+
+    // A nearer triangle wins the depth test whatever the submission order
+    Vec3 q0 = {0, 0, q16_from_float(-32.0f)}, q1 = {63 << 16, 0, q16_from_float(-32.0f)}, q2 = {0, -63 << 16, q16_from_float(-32.0f)};
+    raster_tri_setup(&tris[2], q0, q1, q2, focal, 0, 0, 0xF800);
+    std::vector<uint16_t> cz(T * T, 0);
+    uint16_t order[3] = {2, 0, 1};
+    raster_tile(tris, order, 3, cz.data(), depth.data(), 0, 0, T, T);
+    EXPECT_NEAR(cz[20 * T + 20], 0xF800, 0);
+    EXPECT_NEAR(cz[38 * T + 38], 0x001F, 0);
+
+    // Binning into a 2x2 grid of 64 px tiles
+    Vec3 r0 = {60 << 16, -10 << 16, 0}, r1 = {70 << 16, -10 << 16, 0}, r2 = {60 << 16, -70 << 16, 0};
+    raster_tri_setup(&tris[2], r0, r1, r2, focal, 0, 0, 0xFFFF);
+    uint16_t bin_start[5], bin_items[16];
+    if (!raster_bin(tris, 3, 128, 128, 64, bin_start, bin_items, 16)) std::cout << "FAIL: raster_bin overflow" << std::endl;
+    EXPECT_NEAR(bin_start[1] - bin_start[0], 3, 0);
+    EXPECT_NEAR(bin_start[2] - bin_start[1], 1, 0);
+    EXPECT_NEAR(bin_start[3] - bin_start[2], 1, 0);
+    EXPECT_NEAR(bin_start[4] - bin_start[3], 1, 0);
+    EXPECT_NEAR(bin_items[bin_start[0]], 0, 0);
+    if (raster_bin(tris, 3, 128, 128, 64, bin_start, bin_items, 5)) std::cout << "FAIL: raster_bin overflow not reported" << std::endl;
+
+    // Sliver along the diagonal, 1.5 px high at x = 0, with the full depth range across it: the
+    // depth plane at the far corner of its bounding box is way outside 32 bits
+    const int S = 208;
+    RasterTri sliver = {{0, 3200, 0}, {0, 3200, 24}, {0, 0, 65535}, 0xFFFF};
+    std::vector<uint16_t> cs(S * S, 0), ds(S * S);
+    uint16_t item_s = 0;
+    raster_tile(&sliver, &item_s, 1, cs.data(), ds.data(), 0, 0, S, S);
+    int drawn = 0, bad_depth = 0;
+    for (int y = 0; y < S; y++) {
+        for (int x = 0; x < S; x++) {
+            if (!cs[y * S + x]) continue;
+            drawn++;
+            // z only depends on how far the pixel centre sits below the a-b diagonal
+            double expect = 65535.0 * (y - x) / 1.5;
+            if (std::abs(ds[y * S + x] - expect) > 2) bad_depth++;
+        }
+    }
+    EXPECT_NEAR(drawn, 67, 0); // it tapers below one pixel centre per column after x = 66
+    EXPECT_NEAR(bad_depth, 0, 0);
+}
+
+void test_cull() {
+    std::cout << "Testing FMT_Cull..." << std::endl;
+    int32_t focal = q16_from_float(256.0f);
+    Frustum f;
+    frustum_init(&f, focal, q16_from_float(160.0f), q16_from_float(120.0f), q16_from_float(16.0f), q16_from_float(4096.0f));
+    int32_t r = q16_from_float(10.0f);
+    EXPECT_NEAR(frustum_test_sphere(&f, vec3_init(0, 0, 0), r), CULL_INSIDE, 0);
+    EXPECT_NEAR(frustum_test_sphere(&f, vec3_init(q16_from_float(1000.0f), 0, 0), r), CULL_OUTSIDE, 0);
+    EXPECT_NEAR(frustum_test_sphere(&f, vec3_init(0, 0, q16_from_float(-300.0f)), r), CULL_OUTSIDE, 0); // behind the camera
+    // x = 165 at z = 0 projects just past the right edge (160) but the sphere reaches back in
+    EXPECT_NEAR(frustum_test_sphere(&f, vec3_init(q16_from_float(165.0f), 0, 0), r), CULL_INTERSECT, 0);
+    EXPECT_NEAR(frustum_test_sphere(&f, vec3_init(0, q16_from_float(-200.0f), 0), r), CULL_OUTSIDE, 0);
+
+    Mat34 mv = mat34_model(q16_from_float(2.0f), 0, 0, 0, vec3_init(q16_from_float(2000.0f), 0, 0));
+    EXPECT_NEAR(frustum_test_object(&f, &mv, vec3_init(0, 0, 0), r, q16_from_float(2.0f)), CULL_OUTSIDE, 0);
+
+    // Screen counter-clockwise triangle is front-facing both before and after projection
+    Vec3 a = vec3_init(0, 0, 0), b = vec3_init(q16_from_float(10.0f), 0, 0), c = vec3_init(0, q16_from_float(10.0f), 0);
+    Vec3 eye = vec3_init(0, 0, -focal);
+    if (tri_backfacing_obj(a, b, c, eye) || tri_backfacing_proj(project_perspective(a, focal), project_perspective(b, focal), project_perspective(c, focal)))
+        std::cout << "FAIL: front-facing triangle culled" << std::endl;
+    if (!tri_backfacing_obj(a, c, b, eye) || !tri_backfacing_proj(a, c, b))
+        std::cout << "FAIL: back-facing triangle kept" << std::endl;
+
+    // Near-plane clipping: one vertex behind the plane gives a quad
+    int32_t near_dist = q16_from_float(16.0f);
+    Vec3 tri[3] = {vec3_init(0, 0, 0), vec3_init(q16_from_float(10.0f), 0, q16_from_float(-300.0f)), vec3_init(0, q16_from_float(10.0f), 0)};
+    Vec3 poly[4];
+    uint8_t n = clip_tri_near(tri, focal, near_dist, poly);
+    EXPECT_NEAR(n, 4, 0);
+    for (int i = 0; i < n; i++) {
+        if (poly[i].z + focal < near_dist) std::cout << "FAIL: clipped vertex in front of the near plane" << std::endl;
+    }
+    Vec3 behind[3] = {vec3_init(0, 0, -focal), vec3_init(Q16_ONE, 0, -focal), vec3_init(0, Q16_ONE, -focal)};
+    EXPECT_NEAR(clip_tri_near(behind, focal, near_dist, poly), 0, 0);
+    EXPECT_NEAR(clip_tri_near(tri + 0, focal, -focal, poly), 3, 0);
+}
+
+void test_light() {
+    std::cout << "Testing FMT_Light..." << std::endl;
+    // (n.h)^k against pow()
+    for (float c = 0.5f; c < 1.0f; c += 0.1f) {
+        EXPECT_NEAR(spec_pow_q8(q16_from_float(c), 16), 256.0 * std::pow(c, 16.0), 256.0 * 0.04);
+    }
+    EXPECT_NEAR(spec_pow_q8(Q16_ONE, 32), 256, 0);
+    EXPECT_NEAR(spec_pow_q8(0, 32), 0, 0);
+    EXPECT_NEAR(rgb565(255, 255, 255), 0xFFFF, 0);
+    EXPECT_NEAR(rgb565(255, 0, 0), 0xF800, 0);
+
+    Light sun = {vec3_init(0, 0, -Q16_ONE), 255, 255, 255, LIGHT_DIRECTIONAL};
+    Material matte = {200, 100, 50, 0, 1};
+    Vec3 p = vec3_init(0, 0, 0), eye = vec3_init(0, 0, q16_from_float(-100.0f));
+    // Facing the light: full albedo; edge-on: ambient only
+    uint16_t lit = light_vertex(&sun, 1, &matte, p, vec3_init(0, 0, -Q16_ONE), eye, 0);
+    EXPECT_NEAR(lit >> 11, 199 >> 3, 1);
+    EXPECT_NEAR((lit >> 5) & 0x3F, 99 >> 2, 1);
+    uint16_t edge = light_vertex(&sun, 1, &matte, p, vec3_init(Q16_ONE, 0, 0), eye, 128);
+    EXPECT_NEAR(edge, rgb565(100, 50, 25), 0);
+    EXPECT_NEAR(light_vertex(&sun, 1, &matte, p, vec3_init(0, 0, Q16_ONE), eye, 0), 0, 0);
+
+    // Point light 45 degrees off the normal: Lambert cos = 0.707
+    Light bulb = {vec3_init(q16_from_float(10.0f), 0, q16_from_float(-10.0f)), 255, 255, 255, LIGHT_POINT};
+    Material white = {255, 255, 255, 0, 1};
+    uint16_t half = light_vertex(&bulb, 1, &white, p, vec3_init(0, 0, -Q16_ONE), eye, 0);
+    EXPECT_NEAR(half >> 11, 255 * 0.7071 / 8, 1);
+
+    // Highlight only where the half vector lines up with the normal
+    Material shiny = {0, 0, 0, 255, 64};
+    uint16_t hot = light_vertex(&sun, 1, &shiny, p, vec3_init(0, 0, -Q16_ONE), eye, 0);
+    EXPECT_NEAR(hot >> 11, 31, 1);
+    Vec3 tilted = vec3_normalize(vec3_init(q16_from_float(0.5f), 0, -Q16_ONE));
+    uint16_t off = light_vertex(&sun, 1, &shiny, p, tilted, eye, 0);
+    if ((off >> 11) > 4) std::cout << "FAIL: specular too wide off the highlight" << std::endl;
+
+    Vec3 pos[2] = {p, p}, nrm[2] = {vec3_init(0, 0, -Q16_ONE), vec3_init(Q16_ONE, 0, 0)};
+    uint16_t out[2];
+    light_vertices(&sun, 1, &matte, pos, nrm, 2, eye, 0, out);
+    EXPECT_NEAR(out[0], lit, 0);
+    EXPECT_NEAR(out[1], 0, 0);
+}
+
+void test_ray() {
+    std::cout << "Testing FMT_Ray..." << std::endl;
+    const int NS = 24;
+    RaySphere spheres[NS];
+    srand(7);
+    for (int i = 0; i < NS; i++) {
+        spheres[i].c = vec3_init((rand() % 40 - 20) << 16, (rand() % 20 - 10) << 16, (rand() % 30 + 10) << 16);
+        spheres[i].r = (rand() % 3 + 1) << 16;
+        spheres[i].material = (uint8_t)(i & 1);
+    }
+    RayNode nodes[2 * NS];
+    uint16_t idx[NS];
+    uint16_t nn = ray_bvh_build(nodes, 2 * NS, idx, spheres, NS);
+    if (nn == 0 || nn > 2 * NS) std::cout << "FAIL: BVH node count " << nn << std::endl;
+    // Every sphere lands in exactly one leaf, inside the leaf box
+    std::vector<int> seen(NS, 0);
+    for (int i = 0; i < nn; i++) {
+        for (int k = nodes[i].index; nodes[i].count && k < nodes[i].index + nodes[i].count; k++) {
+            const RaySphere &sp = spheres[idx[k]];
+            seen[idx[k]]++;
+            if (sp.c.x - sp.r < nodes[i].lo.x || sp.c.z + sp.r > nodes[i].hi.z) std::cout << "FAIL: sphere outside leaf bounds" << std::endl;
+        }
+    }
+    for (int i = 0; i < NS; i++) if (seen[i] != 1) std::cout << "FAIL: sphere " << i << " in " << seen[i] << " leaves" << std::endl;
+
+    Material mats[2] = {{255, 0, 0, 0, 1}, {0, 255, 0, 0, 1}};
+    Light sun = {vec3_normalize(vec3_init(Q16_ONE, Q16_ONE, -Q16_ONE)), 255, 255, 255, LIGHT_DIRECTIONAL};
+    RayPlane floor_plane = {{vec3_init(0, Q16_ONE, 0), q16_from_float(12.0f)}, 0};
+    RayScene scene = {spheres, idx, nodes, nn, &floor_plane, 1, mats, &sun, 1, 64, 0x001F};
+
+    // Packets and BVH agree with brute force over every primitive
+    int mismatches = 0;
+    for (int k = 0; k < 400; k++) {
+        Ray rays[RAY_PACKET];
+        for (int j = 0; j < RAY_PACKET; j++) {
+            Vec3 d = ray_normalize(vec3_init((rand() % 2000 - 1000) << 6, (rand() % 2000 - 1000) << 6, 1000 << 6));
+            ray_init(&rays[j], vec3_init(0, 0, 0), d);
+        }
+        ray_trace_packet(&scene, rays, RAY_PACKET);
+        for (int j = 0; j < RAY_PACKET; j++) {
+            Ray ref;
+            ray_init(&ref, rays[j].o, rays[j].d);
+            for (int i = 0; i < NS; i++) ray_hit_sphere(&ref, &spheres[i], (uint16_t)i);
+            ray_hit_plane(&ref, &floor_plane.p, RAY_PLANE_HIT);
+            if (ref.hit != rays[j].hit || ref.t != rays[j].t) mismatches++;
+        }
+    }
+    EXPECT_NEAR(mismatches, 0, 0);
+
+    // Out of nodes with more than 255 spheres left: one big leaf still holds all of them
+    const int NB = 300;
+    std::vector<RaySphere> many(NB);
+    for (int i = 0; i < NB; i++) {
+        many[i].c = vec3_init((i % 20 - 10) << 17, (i / 20 - 7) << 17, (30 + i % 7) << 16);
+        many[i].r = q16_from_float(0.8f);
+        many[i].material = 0;
+    }
+    RayNode big[1];
+    std::vector<uint16_t> big_idx(NB);
+    RayScene big_scene = {many.data(), big_idx.data(), big, ray_bvh_build(big, 1, big_idx.data(), many.data(), NB), 0, 0, mats, &sun, 1, 64, 0x001F};
+    EXPECT_NEAR(big[0].count, NB, 0);
+
+    // Tight node budgets stay inside the array and still find every hit
+    const int NT = 32;
+    RaySphere tight[NT];
+    for (int i = 0; i < NT; i++) {
+        tight[i].c = vec3_init((rand() % 40 - 20) << 16, (rand() % 20 - 10) << 16, (rand() % 30 + 10) << 16);
+        tight[i].r = (rand() % 3 + 1) << 16;
+        tight[i].material = 0;
+    }
+    const uint16_t budgets[] = {5, 9};
+    for (uint16_t max_nodes : budgets) {
+        std::vector<RayNode> tn(max_nodes);
+        uint16_t tidx[NT];
+        uint16_t tc = ray_bvh_build(tn.data(), max_nodes, tidx, tight, NT);
+        if (tc == 0 || tc > max_nodes) std::cout << "FAIL: BVH with " << max_nodes << " nodes used " << tc << std::endl;
+        RayScene ts = {tight, tidx, tn.data(), tc, 0, 0, mats, &sun, 1, 64, 0x001F};
+        int tmiss = 0;
+        for (int k = 0; k < 100; k++) {
+            Ray rays[RAY_PACKET];
+            for (int j = 0; j < RAY_PACKET; j++) {
+                Vec3 d = ray_normalize(vec3_init((rand() % 2000 - 1000) << 6, (rand() % 2000 - 1000) << 6, 1000 << 6));
+                ray_init(&rays[j], vec3_init(0, 0, 0), d);
+            }
+            ray_trace_packet(&ts, rays, RAY_PACKET);
+            for (int j = 0; j < RAY_PACKET; j++) {
+                Ray ref;
+                ray_init(&ref, rays[j].o, rays[j].d);
+                for (int i = 0; i < NT; i++) ray_hit_sphere(&ref, &tight[i], (uint16_t)i);
+                if (ref.hit != rays[j].hit || ref.t != rays[j].t) tmiss++;
+            }
+        }
+        if (tmiss) std::cout << "FAIL: BVH with " << max_nodes << " nodes misses " << tmiss << " hits" << std::endl;
+    }
+
+    // A hand-built chain deeper than RAY_STACK: every interior node has a leaf on its right,
+    // and the deepest leaf holds the only sphere the rays can reach
+    const int D = 40;
+    RayNode chain[2 * D + 1];
+    uint16_t chain_idx[D + 1];
+    std::vector<RaySphere> chain_spheres(D + 1);
+    for (int i = 0; i <= D; i++) {
+        chain_spheres[i].c = vec3_init(0, (i + 2) << 18, 20 << 16); // out of the way, above the rays
+        chain_spheres[i].r = Q16_ONE;
+        chain_spheres[i].material = 0;
+        chain_idx[i] = (uint16_t)i;
+    }
+    chain_spheres[0].c = vec3_init(0, 0, 20 << 16);
+    for (int i = 0; i < 2 * D + 1; i++) {
+        chain[i].lo = vec3_init(-(100 << 16), -(100 << 16), -(100 << 16));
+        chain[i].hi = vec3_init(100 << 16, 200 << 16, 100 << 16);
+        chain[i].axis = 2;
+        if (i < D) { chain[i].index = (uint16_t)(2 * D - i); chain[i].count = 0; }
+        else { chain[i].index = (uint16_t)(i - D); chain[i].count = 1; } // leaves in depth-first order
+    }
+    RayScene deep = {chain_spheres.data(), chain_idx, chain, 2 * D + 1, 0, 0, mats, &sun, 1, 64, 0x001F};
+
+    int lost = 0;
+    for (int k = 0; k < 100; k++) {
+        Ray rays[RAY_PACKET], chain_rays[RAY_PACKET];
+        for (int j = 0; j < RAY_PACKET; j++) {
+            Vec3 d = ray_normalize(vec3_init((rand() % 2000 - 1000) << 5, (rand() % 2000 - 1000) << 5, 1000 << 6));
+            ray_init(&rays[j], vec3_init(0, 0, 0), d);
+            ray_init(&chain_rays[j], vec3_init(0, 0, 0), vec3_init(0, 0, Q16_ONE));
+        }
+        ray_trace_packet(&big_scene, rays, RAY_PACKET);
+        ray_trace_packet(&deep, chain_rays, RAY_PACKET);
+        for (int j = 0; j < RAY_PACKET; j++) {
+            Ray ref;
+            ray_init(&ref, rays[j].o, rays[j].d);
+            for (int i = 0; i < NB; i++) ray_hit_sphere(&ref, &many[i], (uint16_t)i);
+            if (ref.hit != rays[j].hit || ref.t != rays[j].t) lost++;
+            if (chain_rays[j].hit != 0) lost++;
+        }
+    }
+    EXPECT_NEAR(lost, 0, 0);
+
+    // Plane distance without the division on rejected hits
+    Ray down;
+    ray_init(&down, vec3_init(0, 0, 0), vec3_init(0, -Q16_ONE, 0));
+    ray_hit_plane(&down, &floor_plane.p, RAY_PLANE_HIT);
+    EXPECT_NEAR(q16_to_float(down.t), 12.0f, 0.001f);
+    EXPECT_NEAR(down.hit, RAY_PLANE_HIT, 0);
+    Ray up;
+    ray_init(&up, vec3_init(0, 0, 0), vec3_init(0, Q16_ONE, 0));
+    ray_hit_plane(&up, &floor_plane.p, RAY_PLANE_HIT);
+    EXPECT_NEAR(up.hit, RAY_NO_HIT, 0);
+
+    // One sphere straight ahead fills the centre of a 6x5 tile, the corners see the background
+    RaySphere ahead = {vec3_init(0, 0, q16_from_float(20.0f)), q16_from_float(2.0f), 1};
+    RayNode one[2];
+    uint16_t one_idx[1];
+    RayScene single = {&ahead, one_idx, one, ray_bvh_build(one, 2, one_idx, &ahead, 1), 0, 0, mats, &sun, 1, 64, 0x001F};
+    RayCamera cam = {vec3_init(0, 0, 0), {{{Q16_ONE, 0, 0}, {0, Q16_ONE, 0}, {0, 0, Q16_ONE}}}, q16_from_float(8.0f), 3, 2};
+    uint16_t tile[6 * 5];
+    ray_render_tile(&single, &cam, tile, 0, 0, 6, 5);
+    if ((tile[2 * 6 + 3] & 0x07E0) == 0) std::cout << "FAIL: sphere not visible at tile centre" << std::endl;
+    EXPECT_NEAR(tile[0], 0x001F, 0);
+    EXPECT_NEAR(tile[4 * 6 + 5], 0x001F, 0);
+}
+
+void test_sdf() {
+    std::cout << "Testing FMT_SDF..." << std::endl;
+    Vec3 o = vec3_init(0, 0, 0);
+    Vec3 p = vec3_init(q16_from_float(3.0f), q16_from_float(4.0f), 0);
+    EXPECT_NEAR(q16_to_float(sdf_sphere(p, o, Q16_ONE)), 4.0f, 0.05f);
+    EXPECT_NEAR(q16_to_float(sdf_sphere(o, o, Q16_ONE)), -1.0f, 0.01f);
+    Vec3 half = vec3_init(Q16_ONE, Q16_ONE, Q16_ONE);
+    EXPECT_NEAR(q16_to_float(sdf_box(vec3_init(q16_from_float(3.0f), 0, 0), o, half)), 2.0f, 0.02f);
+    EXPECT_NEAR(q16_to_float(sdf_box(vec3_init(q16_from_float(0.5f), 0, 0), o, half)), -0.5f, 0.01f);
+    EXPECT_NEAR(q16_to_float(sdf_box(vec3_init(q16_from_float(4.0f), q16_from_float(5.0f), 0), o, half)), 5.0f, 0.05f);
+    EXPECT_NEAR(q16_to_float(sdf_plane(p, vec3_init(0, Q16_ONE, 0), q16_from_float(2.0f))), 6.0f, 0.001f);
+    EXPECT_NEAR(q16_to_float(sdf_torus(vec3_init(q16_from_float(3.0f), 0, 0), o, q16_from_float(3.0f), q16_from_float(0.5f))), -0.5f, 0.02f);
+    EXPECT_NEAR(q16_to_float(sdf_torus(vec3_init(0, q16_from_float(4.0f), 0), o, q16_from_float(3.0f), q16_from_float(0.5f))), 4.5f, 0.05f);
+    // smooth min blends only within k
+    EXPECT_NEAR(sdf_smin(Q16_ONE, 3 * Q16_ONE, Q16_ONE), Q16_ONE, 0);
+    EXPECT_NEAR(q16_to_float(sdf_smin(Q16_ONE, Q16_ONE, Q16_ONE)), 0.75f, 0.001f);
+
+    SdfPrim prims[3] = {
+        {SDF_PLANE, SDF_OP_UNION, 0, vec3_init(0, Q16_ONE, 0), vec3_init(q16_from_float(3.0f), 0, 0), 0},
+        {SDF_SPHERE, SDF_OP_UNION, 1, vec3_init(0, 0, q16_from_float(20.0f)), vec3_init(q16_from_float(3.0f), 0, 0), 0},
+        {SDF_TORUS, SDF_OP_SMOOTH, 1, vec3_init(q16_from_float(6.0f), 0, q16_from_float(20.0f)), vec3_init(q16_from_float(2.0f), q16_from_float(0.5f), 0), Q16_ONE},
+    };
+    Material mats[2] = {{200, 200, 200, 0, 1}, {255, 0, 0, 0, 1}};
+    Light sun = {vec3_normalize(vec3_init(0, Q16_ONE, -Q16_ONE)), 255, 255, 255, LIGHT_DIRECTIONAL};
+    SdfScene scene = {prims, 3, mats, &sun, 1, 64, 0x001F};
+
+    int32_t t;
+    uint8_t mat;
+    if (!sdf_march(&scene, o, vec3_init(0, 0, Q16_ONE), 0, q16_from_float(90.0f), 64, &t, &mat)) std::cout << "FAIL: sdf_march missed the sphere" << std::endl;
+    EXPECT_NEAR(q16_to_float(t), 17.0f, 0.15f);
+    EXPECT_NEAR(mat, 1, 0);
+    if (sdf_march(&scene, o, vec3_init(0, Q16_ONE, 0), 0, q16_from_float(90.0f), 64, &t, &mat)) std::cout << "FAIL: sdf_march hit the sky" << std::endl;
+    Vec3 n = sdf_normal(&scene, vec3_init(0, 0, q16_from_float(17.0f)));
+    EXPECT_NEAR(q16_to_float(n.z), -1.0f, 0.03f);
+
+    // Row reuse changes where marching starts, not what is hit (shading may move by a step)
+    RayCamera cam = {o, {{{Q16_ONE, 0, 0}, {0, Q16_ONE, 0}, {0, 0, Q16_ONE}}}, q16_from_float(32.0f), 8, 8};
+    uint16_t exact[16 * 16], reuse[16 * 16];
+    int32_t row_t[16];
+    sdf_render_tile(&scene, &cam, exact, 0, 0, 16, 16, q16_from_float(90.0f), 64, 0);
+    sdf_render_tile(&scene, &cam, reuse, 0, 0, 16, 16, q16_from_float(90.0f), 64, row_t);
+    int differ = 0;
+    for (int i = 0; i < 16 * 16; i++) {
+        // sky is 0x001F, the grey floor has green, the red objects have none
+        int ce = exact[i] == 0x001F ? 0 : ((exact[i] & 0x07E0) ? 1 : 2);
+        int cr = reuse[i] == 0x001F ? 0 : ((reuse[i] & 0x07E0) ? 1 : 2);
+        if (ce != cr) differ++;
+    }
+    EXPECT_NEAR(differ, 0, 0);
+    if ((exact[8 * 16 + 8] >> 11) < 8) std::cout << "FAIL: sphere not shaded at tile centre" << std::endl;
+    EXPECT_NEAR(exact[0], 0x001F, 0);
+}
+
+// generate_tables.py --mesh cube.obj (unit cube, quads fan-triangulated)
+static const int16_t test_cube_verts[24] = {
+  -32767, -32767, -32767, -32767, 32767, -32767, 32767, 32767,
+  -32767, 32767, -32767, -32767, -32767, -32767, 32767, 32767,
+  -32767, 32767, 32767, 32767, 32767, -32767, 32767, 32767
+};
+static const uint8_t test_cube_indices[36] = {
+  0, 1, 2, 0, 2, 3, 4, 5,
+  6, 4, 6, 7, 0, 3, 5, 0,
+  5, 4, 3, 2, 6, 3, 6, 5,
+  2, 1, 7, 2, 7, 6, 1, 0,
+  4, 1, 4, 7
+};
+static const int32_t test_cube_quant_q16[4] = {131077, 0, 0, 0};
+
+void test_mesh() {
+    std::cout << "Testing FMT_Mesh..." << std::endl;
+    MeshQ cube;
+    mesh_init(&cube, test_cube_verts, 24, test_cube_indices, 36, test_cube_quant_q16);
+    EXPECT_NEAR(cube.vert_count, 8, 0);
+    EXPECT_NEAR(cube.tri_count, 12, 0);
+    Vec3 v7 = mesh_vertex(&cube, 7);
+    EXPECT_NEAR(q16_to_float(v7.x), -1.0f, 0.001f);
+    EXPECT_NEAR(q16_to_float(v7.z), 1.0f, 0.001f);
+
+    // The streamed triangles match transforming every corner separately, and each corner is transformed once
+    Mat34 mv = mat34_model(q16_from_float(2.0f), 3000, 7000, 0, vec3_init(0, 0, q16_from_float(10.0f)));
+    int32_t focal = q16_from_float(100.0f);
+    MeshStream ms;
+    mesh_stream_begin(&ms, &cube, &mv, focal);
+    Vec3 tri[3];
+    int count = 0;
+    while (mesh_stream_next(&ms, tri)) {
+        for (int i = 0; i < 3; i++) {
+            Vec3 ref = project_perspective(mat34_mul_point(&mv, mesh_vertex(&cube, mesh_index(&cube, count * 3 + i))), focal);
+            EXPECT_NEAR(tri[i].x, ref.x, 64);
+            EXPECT_NEAR(tri[i].y, ref.y, 64);
+            EXPECT_NEAR(tri[i].z, ref.z, 64);
+        }
+        count++;
+    }
+    EXPECT_NEAR(count, 12, 0);
+    EXPECT_NEAR(ms.transformed, 8, 0);
+
+    // 16-bit index lists decode the same way
+    uint16_t idx16[36];
+    for (int i = 0; i < 36; i++) idx16[i] = test_cube_indices[i];
+    MeshQ cube16;
+    mesh_init(&cube16, test_cube_verts, 24, idx16, 36, test_cube_quant_q16);
+    EXPECT_NEAR(mesh_index(&cube16, 35), 7, 0);
+}
+
+void test_wire() {
+    std::cout << "Testing FMT_Wire..." << std::endl;
+    MeshQ cube;
+    mesh_init(&cube, test_cube_verts, 24, test_cube_indices, 36, test_cube_quant_q16);
+    uint32_t edges[36];
+    uint16_t ne = wire_build_edges(&cube, edges);
+    EXPECT_NEAR(ne, 18, 0); // 12 cube edges + 6 face diagonals
+    for (uint16_t i = 1; i < ne; i++) EXPECT_NEAR((edges[i - 1] < edges[i]) ? 1 : 0, 1, 0);
+
+    // Tiled drawing matches drawing each segment into one screen-sized tile, pixel for pixel
+    const int W = 64, H = 48, T = 16;
+    WireSeg segs[8] = {
+        {0, 0, 63, 47, 1}, {63, 0, 0, 47, 2}, {5, 40, 60, 3, 3}, {10, 2, 12, 45, 4},
+        {3, 20, 60, 20, 5}, {30, 1, 30, 46, 6}, {17, 17, 17, 17, 7}, {50, 45, 2, 44, 8}};
+    static uint16_t ref[W * H], tiled[W * H], tile[T * T];
+    for (int i = 0; i < W * H; i++) ref[i] = tiled[i] = 0;
+    for (int i = 0; i < 8; i++) wire_draw_seg(&segs[i], ref, 0, 0, W, H);
+    for (int ty = 0; ty < H; ty += T) {
+        for (int tx = 0; tx < W; tx += T) {
+            for (int i = 0; i < T * T; i++) tile[i] = 0;
+            wire_tile(segs, 8, tile, tx, ty, T, T);
+            for (int y = 0; y < T; y++)
+                for (int x = 0; x < T; x++) tiled[(ty + y) * W + tx + x] = tile[y * T + x];
+        }
+    }
+    int diff = 0, lit = 0;
+    for (int i = 0; i < W * H; i++) {
+        if (ref[i] != tiled[i]) diff++;
+        if (ref[i] == 5) lit++;
+    }
+    EXPECT_NEAR(diff, 0, 0);
+    EXPECT_NEAR(lit, 57, 0); // 58-pixel horizontal line, one pixel overdrawn by the vertical one
+    EXPECT_NEAR(ref[0], 1, 0);
+    EXPECT_NEAR(ref[47 * W + 63], 1, 0);
+
+    // The projected cube stays on screen; an edge crossing the near plane is clipped, not dropped
+    static WireVertex wv[8];
+    WireSeg out[18];
+    int32_t focal = q16_from_float(64.0f);
+    Mat34 mv = mat34_model(q16_from_float(8.0f), 3000, 7000, 0, vec3_init(0, 0, q16_from_float(20.0f)));
+    uint16_t ns = wire_setup(&cube, edges, ne, &mv, focal, Q16_ONE, W / 2, H / 2, W, H, 0xFFFF, wv, out);
+    EXPECT_NEAR((ns > 0 && ns <= 18) ? 1 : 0, 1, 0);
+    for (uint16_t i = 0; i < ns; i++) {
+        EXPECT_NEAR((out[i].x0 >= 0 && out[i].x0 < W && out[i].x1 >= 0 && out[i].x1 < W) ? 1 : 0, 1, 0);
+        EXPECT_NEAR((out[i].y0 >= 0 && out[i].y0 < H && out[i].y1 >= 0 && out[i].y1 < H) ? 1 : 0, 1, 0);
+    }
+    mv = mat34_model(q16_from_float(8.0f), 0, 0, 0, vec3_init(0, 0, -focal));
+    ns = wire_setup(&cube, edges, ne, &mv, focal, Q16_ONE, W / 2, H / 2, W, H, 0xFFFF, wv, out);
+    EXPECT_NEAR((ns > 0) ? 1 : 0, 1, 0);
+}
+
+template <class Pixel>
+struct TestScreenSink {
+    Pixel *screen;
+    int W;
+    uint32_t pushes;
+    uint32_t push(uint16_t x, uint16_t y, uint16_t w, uint16_t h, Pixel *data) {
+        for (int j = 0; j < h; j++)
+            for (int i = 0; i < w; i++) screen[(y + j) * W + x + i] = data[j * w + i];
+        return ++pushes;
+    }
+    void wait() {}
+    uint32_t completed() { return pushes; }
+};
+
+template <class Pixel>
+static void check_tiles(uint16_t tsize, Pixel bg, Pixel ink) {
+    const int W = 100, H = 60;
+    static Pixel screen[W * H], ref[W * H];
+    TileCompositor<Pixel> tc;
+    if (!tc.init(W, H, tsize, bg)) { std::cout << "FAIL: TileCompositor::init" << std::endl; return; }
+    TestScreenSink<Pixel> sink = {screen, W, 0};
+    for (int i = 0; i < W * H; i++) screen[i] = bg;
+    int mismatches = 0;
+    uint32_t pushed = 0;
+    for (int f = 0; f < 20; f++) {
+        tc.startFrame();
+        for (int i = 0; i < W * H; i++) ref[i] = bg;
+        // A moving line and a dot, then nothing for the last frames so everything gets erased
+        if (f < 16) {
+            int x0 = f * 5 - 10, y0 = 3 + f, x1 = f * 5 + 20, y1 = 40 - f;
+            tc.drawLine(x0, y0, x1, y1, ink);
+            int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1, dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1, err = dx + dy;
+            for (;;) {
+                if (x0 >= 0 && x0 < W && y0 >= 0 && y0 < H) ref[y0 * W + x0] = ink;
+                if (x0 == x1 && y0 == y1) break;
+                int e2 = 2 * err;
+                if (e2 >= dy) { err += dy; x0 += sx; }
+                if (e2 <= dx) { err += dx; y0 += sy; }
+            }
+            tc.writePixelGlobal(W - 1, H - 1 - f, ink);
+            ref[(H - 1 - f) * W + W - 1] = ink;
+        }
+        tc.flush(sink);
+        pushed += tc.pushed_px;
+        for (int i = 0; i < W * H; i++) mismatches += screen[i] != ref[i];
+    }
+    EXPECT_NEAR(mismatches, 0, 0);
+    EXPECT_NEAR(tc.pushed_px, 0, 0); // nothing drawn for two frames: nothing left to push
+    // Dirty boxes push a small fraction of what whole dirty tiles would
+    EXPECT_NEAR(pushed < 20u * W * H / 8 ? 1 : 0, 1, 0);
+    tc.invalidate();
+    tc.flush(sink);
+    EXPECT_NEAR(tc.pushed_px, W * H, 0);
+
+    // Something else drew on the panel; invalidate() before the next frame has to survive startFrame()
+    for (int i = 0; i < W * H; i++) screen[i] = ink;
+    tc.invalidate();
+    tc.startFrame();
+    tc.flush(sink);
+    EXPECT_NEAR(tc.pushed_px, W * H, 0);
+    mismatches = 0;
+    for (int i = 0; i < W * H; i++) mismatches += screen[i] != bg;
+    EXPECT_NEAR(mismatches, 0, 0);
+    tc.startFrame();
+    tc.flush(sink);
+    EXPECT_NEAR(tc.pushed_px, 0, 0);
+    tc.deinit();
+}
+
+// Finishes the oldest transfer on every third completed() poll; pixels land only then
+template <class Pixel>
+struct TestDelayedSink {
+    struct Job { uint16_t x, y, w, h; Pixel *data; };
+    Pixel *screen;
+    int W;
+    uint32_t pushes, done, lag, polls;
+    Job jobs[4];
+    void finish() {
+        Job &j = jobs[done % 4];
+        for (int y = 0; y < j.h; y++)
+            for (int x = 0; x < j.w; x++) screen[(j.y + y) * W + j.x + x] = j.data[y * j.w + x];
+        done++;
+    }
+    uint32_t push(uint16_t x, uint16_t y, uint16_t w, uint16_t h, Pixel *data) {
+        if (pushes - done == lag) finish();
+        Job j = {x, y, w, h, data};
+        jobs[pushes % 4] = j;
+        return ++pushes;
+    }
+    void wait() { while (done != pushes) finish(); }
+    uint32_t completed() {
+        if (done != pushes && ++polls % 3 == 0) finish();
+        return done;
+    }
+};
+
+struct TestLineRenderer {
+    TileRect rects[2];
+    uint16_t bin_start[64], bin_items[64];
+    int lx0, ly0, lx1, ly1, dot_x, dot_y;
+    uint16_t ink;
+    bool empty(uint32_t tile) { return bin_start[tile] == bin_start[tile + 1]; }
+    void render(uint32_t tile, TileCanvas<uint16_t> &cv) {
+        for (uint16_t k = bin_start[tile]; k < bin_start[tile + 1]; k++) {
+            if (bin_items[k] == 1) { cv.writePixelGlobal(dot_x, dot_y, ink); continue; }
+            int x0 = lx0, y0 = ly0, x1 = lx1, y1 = ly1;
+            int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1, dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1, err = dx + dy;
+            for (;;) {
+                cv.writePixelGlobal(x0, y0, ink);
+                if (x0 == x1 && y0 == y1) break;
+                int e2 = 2 * err;
+                if (e2 >= dy) { err += dy; x0 += sx; }
+                if (e2 <= dx) { err += dx; y0 += sy; }
+            }
+        }
+    }
+};
+
+static void check_tiles_streaming(uint8_t pool, uint32_t lag) {
+    const int W = 100, H = 60, T = 16; // 7 x 4 tiles
+    static uint16_t screen[W * H], ref[W * H];
+    TileCompositor<uint16_t> stream, immediate;
+    if (!stream.init(W, H, T, 0x0841, pool) || !immediate.init(W, H, T, 0x0841)) {
+        std::cout << "FAIL: TileCompositor::init streaming" << std::endl;
+        return;
+    }
+    TestDelayedSink<uint16_t> sink = {screen, W, 0, 0, lag, 0};
+    TestScreenSink<uint16_t> ref_sink = {ref, W, 0};
+    for (int i = 0; i < W * H; i++) screen[i] = ref[i] = 0x0841;
+    TestLineRenderer r;
+    r.ink = 0xFFE0;
+    int mismatches = 0;
+    uint32_t pushed = 0, pushed_ref = 0;
+    for (int f = 0; f < 12; f++) {
+        r.lx0 = f * 7 - 10; r.ly0 = 2 + f * 3; r.lx1 = 90 - f * 4; r.ly1 = 50 - f;
+        r.dot_x = 3 + f; r.dot_y = 57;
+        TileRect line = {(int16_t)std::min(r.lx0, r.lx1), (int16_t)std::min(r.ly0, r.ly1),
+                         (int16_t)std::max(r.lx0, r.lx1), (int16_t)std::max(r.ly0, r.ly1)};
+        TileRect dot = {(int16_t)r.dot_x, (int16_t)r.dot_y, (int16_t)r.dot_x, (int16_t)r.dot_y};
+        r.rects[0] = line;
+        r.rects[1] = dot;
+        // The last two frames draw nothing, which must still erase what is on screen
+        uint16_t n = f < 10 ? 2 : 0;
+        if (!tile_bin(r.rects, n, W, H, T, r.bin_start, r.bin_items, 64)) std::cout << "FAIL: tile_bin overflow" << std::endl;
+        stream.renderTiles(r, sink);
+        pushed += stream.pushed_px;
+
+        immediate.startFrame();
+        if (n) {
+            immediate.drawLine(r.lx0, r.ly0, r.lx1, r.ly1, r.ink);
+            immediate.writePixelGlobal(r.dot_x, r.dot_y, r.ink);
+        }
+        immediate.flush(ref_sink);
+        pushed_ref += immediate.pushed_px;
+
+        stream.drain(sink);
+        sink.wait();
+        for (int i = 0; i < W * H; i++) mismatches += screen[i] != ref[i];
+    }
+    EXPECT_NEAR(mismatches, 0, 0);
+    EXPECT_NEAR(pushed, pushed_ref, 0);
+    EXPECT_NEAR(stream.pushed_px, 0, 0);
+
+    // Each mode refuses the other's frame calls instead of hanging or touching missing buffers
+    TileWorkers none;
+    EXPECT_NEAR(immediate.renderTiles(r, ref_sink), 0, 0);
+    EXPECT_NEAR(stream.flush(sink), 0, 0);
+    EXPECT_NEAR(stream.renderTilesParallel(r, none), 0, 0);
+    stream.startFrame();
+
+    // invalidate() repaints the next streamed frame even where nothing is drawn
+    for (int i = 0; i < W * H; i++) screen[i] = 0xFFFF;
+    stream.invalidate();
+    stream.renderTiles(r, sink);
+    stream.drain(sink);
+    sink.wait();
+    EXPECT_NEAR(stream.pushed_px, W * H, 0);
+    mismatches = 0;
+    for (int i = 0; i < W * H; i++) mismatches += screen[i] != 0x0841;
+    EXPECT_NEAR(mismatches, 0, 0);
+    stream.renderTiles(r, sink);
+    EXPECT_NEAR(stream.pushed_px, 0, 0);
+    stream.drain(sink);
+    stream.deinit();
+    immediate.deinit();
+}
+
+struct TestQueueJob {
+    TileQueue *queue;
+    std::atomic<uint32_t> *hits;
+    static void run(void *p, uint8_t worker) {
+        TestQueueJob *j = (TestQueueJob *)p;
+        uint32_t i;
+        while (j->queue->next(worker, &i)) j->hits[i].fetch_add(1);
+    }
+};
+
+// Every tile is handed out exactly once per frame, however the workers race for them
+static void check_tile_queue(uint8_t n) {
+    const uint32_t count = 300;
+    static std::atomic<uint32_t> hits[count];
+    TileWorkers workers;
+    if (!workers.start(n)) { std::cout << "FAIL: TileWorkers::start" << std::endl; return; }
+    TestQueueJob job = {&workers.queue, hits};
+    int wrong = 0;
+    // One worker alone has to steal everyone else's tiles
+    for (uint32_t i = 0; i < count; i++) hits[i] = 0;
+    workers.queue.reset(count, n);
+    TestQueueJob::run(&job, n - 1);
+    for (uint32_t i = 0; i < count; i++) wrong += hits[i] != 1;
+    for (int f = 0; f < 50; f++) {
+        for (uint32_t i = 0; i < count; i++) hits[i] = 0;
+        workers.queue.reset(count, workers.count);
+        workers.run(TestQueueJob::run, &job);
+        for (uint32_t i = 0; i < count; i++) wrong += hits[i] != 1;
+    }
+    EXPECT_NEAR(wrong, 0, 0);
+    workers.stop();
+}
+
+static void check_tiles_parallel(uint8_t n) {
+    const int W = 100, H = 60, T = 16;
+    static uint16_t screen[W * H], ref[W * H];
+    TileCompositor<uint16_t> par, immediate;
+    TileWorkers workers;
+    if (!par.init(W, H, T, 0x0841) || !immediate.init(W, H, T, 0x0841) || !workers.start(n)) {
+        std::cout << "FAIL: TileCompositor::init parallel" << std::endl;
+        return;
+    }
+    TestScreenSink<uint16_t> sink = {screen, W, 0}, ref_sink = {ref, W, 0};
+    for (int i = 0; i < W * H; i++) screen[i] = ref[i] = 0x0841;
+    TestLineRenderer r;
+    r.ink = 0xFFE0;
+    int mismatches = 0;
+    uint32_t pushed = 0, pushed_ref = 0;
+    for (int f = 0; f < 12; f++) {
+        r.lx0 = 95 - f * 7; r.ly0 = 2 + f * 3; r.lx1 = f * 4; r.ly1 = 58 - f;
+        r.dot_x = 3 + f; r.dot_y = 57;
+        TileRect line = {(int16_t)std::min(r.lx0, r.lx1), (int16_t)std::min(r.ly0, r.ly1),
+                         (int16_t)std::max(r.lx0, r.lx1), (int16_t)std::max(r.ly0, r.ly1)};
+        TileRect dot = {(int16_t)r.dot_x, (int16_t)r.dot_y, (int16_t)r.dot_x, (int16_t)r.dot_y};
+        r.rects[0] = line;
+        r.rects[1] = dot;
+        uint16_t nr = f < 10 ? 2 : 0;
+        if (!tile_bin(r.rects, nr, W, H, T, r.bin_start, r.bin_items, 64)) std::cout << "FAIL: tile_bin overflow" << std::endl;
+        par.renderTilesParallel(r, workers);
+        par.flush(sink);
+        pushed += par.pushed_px;
+
+        immediate.startFrame();
+        if (nr) {
+            immediate.drawLine(r.lx0, r.ly0, r.lx1, r.ly1, r.ink);
+            immediate.writePixelGlobal(r.dot_x, r.dot_y, r.ink);
+        }
+        immediate.flush(ref_sink);
+        pushed_ref += immediate.pushed_px;
+        for (int i = 0; i < W * H; i++) mismatches += screen[i] != ref[i];
+    }
+    EXPECT_NEAR(mismatches, 0, 0);
+    EXPECT_NEAR(pushed, pushed_ref, 0);
+    EXPECT_NEAR(par.pushed_px, 0, 0);
+    par.deinit();
+    immediate.deinit();
+}
+
+void test_tiles() {
+    std::cout << "Testing FMT_Tiles..." << std::endl;
+    TileBox b = tile_box_empty();
+    EXPECT_NEAR(tile_box_is_empty(b), 1, 0);
+    tile_box_add(&b, 3, 4, 3, 4);
+    b = tile_box_union(b, tile_box_empty());
+    EXPECT_NEAR(b.x0 + b.y0 * 10 + b.x1 * 100 + b.y1 * 1000, 4343, 0);
+    check_tiles<uint16_t>(16, 0x0000, 0xFFFF);
+    check_tiles<uint16_t>(12, 0x1234, 0xF800); // not a power of two, partial edge tiles, non-zero bg
+    check_tiles<uint8_t>(4, 0, 255);
+    check_tiles_streaming(1, 1);
+    check_tiles_streaming(2, 1);
+    check_tiles_streaming(3, 2); // a buffer reused before its transfer finished shows up as a mismatch
+    check_tile_queue(2);
+    check_tile_queue(4);
+    check_tiles_parallel(1);
+    check_tiles_parallel(3);
+}
+
 void test_utils() {
     std::cout << "Testing FMT_Utils..." << std::endl;
     // Perspective table should return 256 for z=0 if focal=256
@@ -194,9 +1217,22 @@ int main() {
     test_fixed();
     test_trig();
     test_3d();
+    test_3d16();
+    test_expr();
+    test_transform_node();
     test_ring();
     test_fused_pipeline();
+    test_batch();
+    test_batch_transform();
+    test_raster();
+    test_cull();
+    test_light();
+    test_ray();
+    test_sdf();
+    test_mesh();
+    test_wire();
     test_utils();
+    test_tiles();
     std::cout << "Host tests completed." << std::endl;
     return 0;
 }
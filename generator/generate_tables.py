@@ -10,6 +10,10 @@ Generates PROGMEM-friendly C header (and optionally .cpp) with lookup tables for
  - base constants (PI, 2PI in chosen Q formats)
  - optional angle (atan-approx) table and stereographic projection table
  - optional glyph bitmaps for TTF/OTF fonts (requires Pillow)
+ - optional indexed meshes from OBJ files: int16 quantized positions, Q16 scale/offset, 8/16-bit indices
+
+--tune sweeps the log/exp table sizes and BTM splits, prints the size/error/cycle Pareto fronts and,
+with --flash-budget, emits the most accurate float tables that fit.
 
 Uses mathematically correct formulas for all tables.
 """
@@ -46,39 +50,243 @@ def gen_exp2_frac_table(frac_size=256, q=8):
     scale = qscale(q)
     return [round((2 ** (f / frac_size)) * scale) for f in range(frac_size)]
 
+def parse_float_split(bits, tiv, to_spec, opt="--float", max_bits=16):
+    """Offset tables as (seg_bits, slice_bits, slice_shift), slices listed from the top down
+    and together covering the bits below the TIV index."""
+    if bits > max_bits:
+        raise SystemExit(f"{opt}-bits is at most {max_bits} (the exp2 input is a Q{max_bits} fraction)")
+    tos = []
+    for part in to_spec.split(","):
+        seg, width = (int(v) for v in part.split(":"))
+        tos.append([seg, width])
+    if sum(w for _, w in tos) != bits - tiv:
+        raise SystemExit(f"{opt}-to slices must cover the {bits - tiv} bits below the TIV index")
+    shift = bits - tiv
+    for t in tos:
+        shift -= t[1]
+        if t[0] > tiv:
+            raise SystemExit(f"{opt}-to segment bits cannot exceed {opt}-tiv")
+        t.append(shift)
+    return [tuple(t) for t in tos]
+
+def gen_multipartite(f, bits, tiv, tos, q=16):
+    """Multipartite approximation of f on [0, 1) with a bits-bit input: a table of initial
+    values (TIV) indexed by the top tiv bits, plus one offset table per slice of the
+    remaining bits, indexed by the top seg bits and the slice. Each offset is the slope of
+    f over its segment times the slice's distance from its centre; the TIV is taken at the
+    point where all slices sit at their centres, so every offset table is odd around it.
+    With bits=14, tiv=9 and one 4:5 offset table this is the classic bipartite split."""
+    scale = 1 << q
+    ulp = 2.0 ** -bits
+    centre = sum(2 ** (w - 1) * 2 ** sh for _, w, sh in tos)
+    tiv_t = [round(f((i * 2 ** (bits - tiv) + centre) * ulp) * scale) for i in range(2 ** tiv)]
+    offsets = []
+    for seg, w, sh in tos:
+        seg_len = 2.0 ** -seg
+        t = []
+        for k in range(2 ** (seg + w)):
+            g, sl = k >> w, k & ((1 << w) - 1)
+            slope = (f((g + 1) * seg_len) - f(g * seg_len)) / seg_len
+            t.append(round(slope * (sl - 2 ** (w - 1)) * 2 ** sh * ulp * scale))
+        offsets.append(t)
+    return tiv_t, offsets
+
+def multipartite_eval(idx, bits, tiv, tos, tiv_t, offsets, q=16):
+    r = tiv_t[idx >> (bits - tiv)]
+    for (seg, w, sh), t in zip(tos, offsets):
+        r += t[((idx >> (bits - seg)) << w) | ((idx >> sh) & ((1 << w) - 1))]
+    return min(max(r, 0), (1 << q) - 1)
+
+def multipartite_stats(f, bits, tiv, tos, tiv_t, offsets, q=16):
+    """Worst and mean absolute error in units of 2^-q over all inputs, sampled at each input's
+    midpoint. Sums whole table columns instead of calling multipartite_eval per input, which
+    keeps the tuner's exhaustive sweeps fast."""
+    n = 2 ** bits
+    r = [tiv_t[i >> (bits - tiv)] for i in range(n)]
+    for (seg, w, sh), t in zip(tos, offsets):
+        mask = (1 << w) - 1
+        r = [a + t[((i >> (bits - seg)) << w) | ((i >> sh) & mask)] for i, a in zip(range(n), r)]
+    top = (1 << q) - 1
+    errs = [abs(min(max(a, 0), top) - f((i + 0.5) / n) * (1 << q)) for i, a in zip(range(n), r)]
+    return max(errs), sum(errs) / n
+
+def multipartite_error(f, bits, tiv, tos, tiv_t, offsets, q=16):
+    """Worst absolute error in units of 2^-q over all inputs, sampled at each input's midpoint."""
+    return multipartite_stats(f, bits, tiv, tos, tiv_t, offsets, q)[0]
+
+def btm_log2_f(x): return math.log2(1 + x)
+def btm_exp2_f(x): return 2 ** x - 1
+
 def gen_btm_log2(n1, n2, n3):
-    def f(x): return math.log2(1 + x)
-    t1 = []
-    for i12 in range(2**(n1+n2)):
-        x_val = (i12 * 2**n3) + 2**(n3-1)
-        x = x_val / 2**(n1+n2+n3)
-        t1.append(round(f(x) * 65536))
-    t2 = []
-    for i13 in range(2**(n1+n3)):
-        i1 = i13 >> n3
-        x_start = (i1 * 2**(n2+n3)) / 2**(n1+n2+n3)
-        x_end = ((i1+1) * 2**(n2+n3)) / 2**(n1+n2+n3)
-        slope = (f(x_end) - f(x_start)) / (2**(n2+n3) / 2**(n1+n2+n3))
-        correction = slope * (i13 % 2**n3 - 2**(n3-1)) / 2**(n1+n2+n3)
-        t2.append(round(correction * 65536))
-    return t1, t2
+    tiv_t, (to,) = gen_multipartite(btm_log2_f, n1 + n2 + n3, n1 + n2, [(n1, n3, 0)])
+    return tiv_t, to
 
 def gen_btm_exp2(n1, n2, n3):
-    def f(x): return 2**x - 1
-    t1 = []
-    for i12 in range(2**(n1+n2)):
-        x_val = (i12 * 2**n3) + 2**(n3-1)
-        x = x_val / 2**(n1+n2+n3)
-        t1.append(round(f(x) * 65536))
-    t2 = []
-    for i13 in range(2**(n1+n3)):
-        i1 = i13 >> n3
-        x_start = (i1 * 2**(n2+n3)) / 2**(n1+n2+n3)
-        x_end = ((i1+1) * 2**(n2+n3)) / 2**(n1+n2+n3)
-        slope = (f(x_end) - f(x_start)) / (2**(n2+n3) / 2**(n1+n2+n3))
-        correction = slope * (i13 % 2**n3 - 2**(n3-1)) / 2**(n1+n2+n3)
-        t2.append(round(correction * 65536))
-    return t1, t2
+    tiv_t, (to,) = gen_multipartite(btm_exp2_f, n1 + n2 + n3, n1 + n2, [(n1, n3, 0)])
+    return tiv_t, to
+
+def gen_float_tables(bits, tiv, tos, wide=False):
+    """BTM/multipartite tables for fast_float.c: arrays and the BTM_* configuration macros.
+    wide=True gives the double-precision set: Q32 entries in log2_d* / exp2_d*, BTM64_* macros."""
+    prefix, tab, q = ("BTM64", "d", 32) if wide else ("BTM", "t", 16)
+    ttype = "int32_t" if wide else "int16_t"
+    arrays, defines = [], [(f"{prefix}_BITS", bits), (f"{prefix}_TIV_BITS", tiv), (f"{prefix}_TO_COUNT", len(tos))]
+    for n, (seg, w, sh) in enumerate(tos, 1):
+        defines += [(f"{prefix}_TO{n}_SEG_BITS", seg), (f"{prefix}_TO{n}_SLICE_BITS", w), (f"{prefix}_TO{n}_SLICE_SHIFT", sh)]
+    for fname, f in (("log2", btm_log2_f), ("exp2", btm_exp2_f)):
+        tiv_t, offsets = gen_multipartite(f, bits, tiv, tos, q)
+        arrays.append(("u" + ttype, f"{fname}_{tab}1", tiv_t))
+        for n, t in enumerate(offsets, 2):
+            arrays.append((ttype, f"{fname}_{tab}{n}", t))
+        err = multipartite_error(f, bits, tiv, tos, tiv_t, offsets, q)
+        size = sum(len(a[2]) for a in arrays if a[1].startswith(fname)) * q // 8
+        print(f"{fname}: {len(tos) + 1} tables, {size} bytes, "
+              f"max error {err:.2f} / 2^{q} (~{q - math.log2(max(err, 1e-9)):.1f} bits)")
+    return arrays, defines
+
+# --- Table tuner (--tune) ---
+# Rough ATmega328P cycle costs of the operations the lookups compile to (avr-gcc -O2).
+AVR_CYCLES = {
+    "lpm8": 3,       # byte from flash, Z already set up
+    "lpm16": 6,      # word from flash
+    "addr": 3,       # table base + index * 2 into Z
+    "shift16": 2,    # one-bit shift of a 16-bit value
+    "shift32": 4,    # one-bit shift of a 32-bit value
+    "add16": 2,
+    "add32": 4,
+    "mul16": 12,     # 16x16 -> 32 with the hardware MUL
+    "branch": 2,
+}
+
+def q8_log_stats(log_size, q, interp):
+    """Log stage of the fixed-point multiply, exhaustive over every normalized 16-bit
+    mantissa: the table (log2(i) for i < log_size) is indexed by the top bits, optionally
+    interpolated on the bits below. Returns max / mean absolute error in log2 units."""
+    k = log_size.bit_length() - 1
+    t = gen_log2_table(log_size + 1, q)
+    t[log_size] = round(k * (1 << q))
+    low = 16 - k
+    worst = total = 0.0
+    for m in range(1 << 15, 1 << 16):
+        i, rest = m >> low, m & ((1 << low) - 1)
+        v = t[i] + ((t[i + 1] - t[i]) * rest >> low if interp else 0)
+        err = abs(v / (1 << q) - (k - 1) - math.log2(m / (1 << 15)))
+        worst = max(worst, err)
+        total += err
+    return worst, total / (1 << 15)
+
+def q8_exp_stats(frac_size, q, interp):
+    """Exp stage, exhaustive over every Q-q fraction: relative error of 2^f."""
+    j = frac_size.bit_length() - 1
+    t = gen_exp2_frac_table(frac_size, q) + [2 << q]
+    low = q - j
+    worst = total = 0.0
+    for f in range(1 << q):
+        i, rest = f >> low, f & ((1 << low) - 1)
+        v = t[i] + ((t[i + 1] - t[i]) * rest >> low if interp else 0)
+        err = abs(v / (1 << q) / 2 ** (f / (1 << q)) - 1)
+        worst = max(worst, err)
+        total += err
+    return worst, total / (1 << q)
+
+def q8_mul_cycles(log_size, frac_size, q, log_interp, exp_interp):
+    c = AVR_CYCLES
+    # log2: msb byte lookup, normalizing shift (~4 bits on average), table read
+    log = c["branch"] * 2 + c["lpm8"] + 4 * c["shift16"] + c["addr"] + c["lpm16"] + c["add32"]
+    log += max(0, log_size.bit_length() - 9) * c["shift16"]  # indices wider than a byte
+    if log_interp:
+        log += c["lpm16"] + c["add16"] + c["mul16"] + (16 - log_size.bit_length() + 1) * c["shift16"] + c["add32"]
+    exp = c["addr"] + c["lpm16"] + c["branch"] * 2 + 8 * c["shift32"]
+    if exp_interp:
+        exp += c["lpm16"] + c["add16"] + c["mul16"] + (q - frac_size.bit_length() + 1) * c["shift16"] + c["add32"]
+    return 2 * log + c["add32"] + exp
+
+def btm_cycles(tos):
+    """One BTM lookup: the TIV read plus, per offset table, building its index from two bit
+    fields, the read and the add."""
+    c = AVR_CYCLES
+    return c["addr"] + c["lpm16"] + len(tos) * (6 * c["shift16"] + c["addr"] + c["lpm16"] + c["add16"])
+
+def btm_splits(bits_list):
+    """Bipartite and tripartite splits worth measuring: offset tables no larger than the TIV."""
+    for bits in bits_list:
+        for tiv in range(max(5, bits // 2), bits - 1):
+            rest = bits - tiv
+            for seg in range(2, min(tiv, 7) + 1):
+                if seg + rest <= tiv:
+                    yield bits, tiv, [(seg, rest, 0)]
+            for w1 in range(1, rest):
+                w2 = rest - w1
+                for s1 in range(2, min(tiv, 7) + 1):
+                    for s2 in range(1, s1):
+                        if s1 + w1 <= tiv and s2 + w2 <= tiv:
+                            yield bits, tiv, [(s1, w1, w2), (s2, w2, 0)]
+
+def pareto_front(points, keys):
+    """Points not dominated on every key (all minimized), sorted by the first key."""
+    front = []
+    for p in points:
+        if not any(all(o[k] <= p[k] for k in keys) and any(o[k] < p[k] for k in keys) for o in points):
+            front.append(p)
+    return sorted(front, key=lambda p: tuple(p[k] for k in keys))
+
+def tune_tables(q, bits_list, budget):
+    """Sweep the fixed-point log/exp table sizes and interpolation, and the BTM float splits.
+    Prints both Pareto fronts (bytes, error, AVR cycles) and returns the float split that
+    fits the flash budget next to the fixed-point tables FMT reads, or None."""
+    q8 = []
+    sizes = [s for s in (64, 128, 256, 512, 1024)]
+    log_stats = {(n, i): q8_log_stats(n, q, i) for n in sizes for i in (False, True)}
+    exp_stats = {(n, i): q8_exp_stats(n, q, i) for n in sizes if n <= (1 << q) for i in (False, True)
+                 if not (i and n == (1 << q))}
+    for (ln, li), (lmax, lmean) in log_stats.items():
+        for (en, ei), (emax, emean) in exp_stats.items():
+            # a * b adds two logs, then the exp rounds the sum
+            q8.append({"log": ln, "exp": en, "interp": ("log " if li else "") + ("exp" if ei else "") or "-",
+                       "bytes": 256 + 2 * (ln + li) + 2 * (en + ei),
+                       "max": 2 ** (2 * lmax) * (1 + emax) - 1, "mean": 2 ** (2 * lmean) * (1 + emean) - 1,
+                       "cycles": q8_mul_cycles(ln, en, q, li, ei)})
+    print(f"Fixed-point multiply (Q{q} log), Pareto front over {len(q8)} configurations:")
+    print("   bytes  log-size  exp-frac-size  interp    max rel err  mean rel err  ~cycles")
+    for p in pareto_front(q8, ("bytes", "max", "cycles")):
+        print(f"  {p['bytes']:6d}  {p['log']:8d}  {p['exp']:13d}  {p['interp']:8s}  {p['max']:11.2e}  {p['mean']:12.2e}  {p['cycles']:7d}")
+
+    flt = []
+    for bits, tiv, tos in btm_splits(bits_list):
+        size = 2 ** tiv + sum(2 ** (seg + w) for seg, w, _ in tos)
+        if budget is not None and 2 * 2 * size > budget:
+            continue
+        stats = []
+        for f in (btm_log2_f, btm_exp2_f):
+            tiv_t, offsets = gen_multipartite(f, bits, tiv, tos)
+            stats.append(multipartite_stats(f, bits, tiv, tos, tiv_t, offsets))
+        (lmax, lmean), (emax, emean) = stats
+        # Mantissa product: two log errors (log2 units, so ln 2 per unit) and one exp error
+        flt.append({"bits": bits, "tiv": tiv, "tos": tos, "bytes": 2 * 2 * size,
+                    "max": (2 * math.log(2) * lmax + emax) / 65536, "mean": (2 * math.log(2) * lmean + emean) / 65536,
+                    "log": lmax, "exp": emax, "cycles": 3 * btm_cycles(tos)})
+    print(f"\nBTM float multiply, Pareto front over {len(flt)} splits:")
+    print("   bytes  bits  tiv  offset tables  log2 err  exp2 err  max rel err  mean rel err  ~cycles")
+    front = pareto_front(flt, ("bytes", "max", "cycles"))
+    for p in front:
+        to = ",".join(f"{seg}:{w}" for seg, w, _ in p["tos"])
+        print(f"  {p['bytes']:6d}  {p['bits']:4d}  {p['tiv']:3d}  {to:13s}  {p['log']:8.2f}  {p['exp']:8.2f}  "
+              f"{p['max']:11.2e}  {p['mean']:12.2e}  {p['cycles']:7d}")
+    print("(errors of the BTM tables in 1/65536; cycles are table lookups only, from AVR_CYCLES)")
+
+    if budget is None:
+        return None
+    # FMT_Core indexes log2_table_q8 with an 8-bit mantissa and exp2_table_q8 with the Q8
+    # fraction, so the fixed-point tables it links against are always 256 + 256 entries.
+    fixed = 256 + 2 * 256 + 2 * 256
+    fits = [p for p in front if p["bytes"] <= budget - fixed]
+    if not fits:
+        raise SystemExit(f"--flash-budget {budget}: nothing fits next to the {fixed} bytes of fixed-point tables")
+    best = min(fits, key=lambda p: (p["max"], p["cycles"], p["bytes"]))
+    to = ",".join(f"{seg}:{w}" for seg, w, _ in best["tos"])
+    print(f"\nBudget {budget} bytes: fixed-point tables {fixed} bytes + float split --float-bits {best['bits']} "
+          f"--float-tiv {best['tiv']} --float-to {to} ({best['bytes']} bytes)")
+    return best
 
 def gen_sin_cos_table(n=512, q=15):
     scale = qscale(q)
@@ -187,9 +395,64 @@ def rasterize_font(ttf_path, size, chars, glyph_w=None, glyph_h=None, mono_thres
         glyphs[ch] = cols
     return glyphs, glyph_w, glyph_h
 
+def load_obj(path):
+    verts, tris = [], []
+    for line in Path(path).read_text().splitlines():
+        parts = line.split()
+        if not parts:
+            continue
+        if parts[0] == 'v':
+            verts.append(tuple(float(p) for p in parts[1:4]))
+        elif parts[0] == 'f':
+            idx = [int(p.split('/')[0]) for p in parts[1:]]
+            idx = [i - 1 if i > 0 else len(verts) + i for i in idx]
+            for k in range(1, len(idx) - 1):  # fan-triangulate polygons
+                tris.append((idx[0], idx[k], idx[k + 1]))
+    return verts, tris
+
+def gen_quantized_mesh(verts, tris):
+    # Renumber vertices in first-use order: drops unused ones and keeps the indices of
+    # neighbouring triangles close together, which is what the FMT vertex cache wants.
+    remap, order = {}, []
+    for t in tris:
+        for i in t:
+            if i not in remap:
+                remap[i] = len(order)
+                order.append(i)
+    used = [verts[i] for i in order]
+    lo = [min(v[a] for v in used) for a in range(3)]
+    hi = [max(v[a] for v in used) for a in range(3)]
+    offset = [(lo[a] + hi[a]) / 2.0 for a in range(3)]
+    half = max((hi[a] - lo[a]) / 2.0 for a in range(3)) or 1.0
+    # world_q16 = offset_q16 + (q * scale_q16 >> 16); q = +-32767 spans the largest half extent
+    scale_q16 = max(1, int(math.ceil(half * 65536.0 * 65536.0 / 32767.0)))
+    q = []
+    for v in used:
+        for a in range(3):
+            q.append(clamp_int(round((v[a] - offset[a]) * 65536.0 * 65536.0 / scale_q16), -32767, 32767))
+    indices = [remap[i] for t in tris for i in t]
+    quant = [scale_q16] + [round(o * 65536.0) for o in offset]
+    return q, indices, quant
+
+def write_float_files(out_dir, arrays, defines, progmem_macro, arrays64=None):
+    """fast_float_config.h (picked up by fast_float.h) and the matching fast_float_tables.cpp,
+    plus fast_float64_tables.cpp when the double-precision tables are generated too."""
+    out_dir.mkdir(parents=True, exist_ok=True)
+    cfg = ["#ifndef FAST_FLOAT_CONFIG_H", "#define FAST_FLOAT_CONFIG_H", ""]
+    cfg += [f"#define {name} {val}" for name, val in defines]
+    cfg += ["", "#endif", ""]
+    (out_dir / "fast_float_config.h").write_text("\n".join(cfg))
+    for file_name, file_arrays in (("fast_float_tables.cpp", arrays), ("fast_float64_tables.cpp", arrays64)):
+        if file_arrays is None:
+            continue
+        c_content = ['#include "fast_float.h"\n']
+        for ctype, name, vals in file_arrays:
+            c_content.append(fmt_c_array(ctype, name, vals, progmem_macro=progmem_macro))
+        (out_dir / file_name).write_text("\n".join(c_content) + "\n")
+
 def main():
     parser = argparse.ArgumentParser()
-    parser.add_argument("--out", "-o", default="arduino_tables_generated")
+    parser.add_argument("--out", "-o", help="Base name of the main table files (default arduino_tables_generated)")
     parser.add_argument("--emit-c", action="store_true")
     parser.add_argument("--progmem-macro", default="PROGMEM")
     parser.add_argument("--log-q", type=int, default=8)
@@ -213,6 +476,17 @@ def main():
     parser.add_argument("--stereo-size", type=int, default=256)
     parser.add_argument("--stereo-q", type=int, default=12)
     parser.add_argument("--gen-float", action="store_true", help="Generate BTM float tables")
+    parser.add_argument("--float-bits", type=int, default=14, help="Mantissa bits indexing the float tables")
+    parser.add_argument("--float-tiv", type=int, default=9, help="Bits indexing the table of initial values")
+    parser.add_argument("--float-to", default="4:5", help="Offset tables as seg_bits:slice_bits, top slice first (e.g. 4:3,2:3)")
+    parser.add_argument("--gen-float64", action="store_true", help="Also generate the wider double-precision tables (host use)")
+    parser.add_argument("--float64-bits", type=int, default=22, help="Mantissa bits indexing the double-precision tables")
+    parser.add_argument("--float64-tiv", type=int, default=12)
+    parser.add_argument("--float64-to", default="7:5,5:5")
+    parser.add_argument("--float-dir", help="Write fast_float_tables.cpp and fast_float_config.h for fast_float.c here")
+    parser.add_argument("--tune", action="store_true", help="Sweep table sizes/splits and print the Pareto fronts")
+    parser.add_argument("--tune-bits", default="12,13,14,15,16", help="Float input bit widths the tuner sweeps")
+    parser.add_argument("--flash-budget", type=int, help="With --tune: emit the most accurate float tables that fit")
     parser.add_argument("--font-file", help="Path to TTF/OTF font file for rasterization")
     parser.add_argument("--font-size", type=int, default=14)
     parser.add_argument("--glyph-chars", default=" !?0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ")
@@ -220,9 +494,21 @@ def main():
     parser.add_argument("--glyph-h", type=int, default=None)
     parser.add_argument("--gen-lse", action="store_true", help="Generate LogSumExp table")
     parser.add_argument("--gen-log-trig", action="store_true", help="Generate Log-domain sin/cos tables")
+    parser.add_argument("--mesh", action="append", default=[], help="OBJ file to emit as a quantized FMT mesh (repeatable)")
     args = parser.parse_args()
 
-    base = Path(args.out)
+    if args.tune:
+        best = tune_tables(args.log_q, [int(b) for b in args.tune_bits.split(",")], args.flash_budget)
+        if best is None:
+            return
+        args.gen_float = True
+        args.float_bits, args.float_tiv = best["bits"], best["tiv"]
+        args.float_to = ",".join(f"{seg}:{w}" for seg, w, _ in best["tos"])
+
+    # A --float-dir run writes only the float files unless the main tables were asked for too
+    wants_main = bool(args.out or args.mesh or args.font_file or args.gen_atan or args.gen_stereo
+                      or args.gen_lse or args.gen_log_trig)
+    base = Path(args.out or "arduino_tables_generated")
     header_path = base.with_suffix(".h")
     arrays = []
 
@@ -262,13 +548,36 @@ def main():
         lse = gen_lse_table(256, q=args.log_q)
         arrays.append(("uint16_t", "lse_table_q8", lse))
 
-    if args.gen_float:
-        l_t1, l_t2 = gen_btm_log2(4, 5, 5)
-        e_t1, e_t2 = gen_btm_exp2(4, 5, 5)
-        arrays.append(("uint16_t", "log2_t1", l_t1))
-        arrays.append(("int16_t", "log2_t2", l_t2))
-        arrays.append(("uint16_t", "exp2_t1", e_t1))
-        arrays.append(("int16_t", "exp2_t2", e_t2))
+    defines = []
+    if args.gen_float64 and not args.float_dir:
+        raise SystemExit("--gen-float64 writes fast_float64_tables.cpp and needs --float-dir")
+    if args.gen_float or args.gen_float64:
+        tos = parse_float_split(args.float_bits, args.float_tiv, args.float_to)
+        f_arrays, defines = gen_float_tables(args.float_bits, args.float_tiv, tos)
+        if args.float_dir:
+            arrays64 = None
+            if args.gen_float64:
+                tos64 = parse_float_split(args.float64_bits, args.float64_tiv, args.float64_to, "--float64", 24)
+                arrays64, defines64 = gen_float_tables(args.float64_bits, args.float64_tiv, tos64, wide=True)
+                defines += defines64
+            write_float_files(Path(args.float_dir), f_arrays, defines, args.progmem_macro, arrays64)
+            if not wants_main:
+                return
+            defines = []  # the float macros live in fast_float_config.h
+        else:
+            arrays += f_arrays
+
+    for mesh_path in args.mesh:
+        stem = "".join(c if c.isalnum() else "_" for c in Path(mesh_path).stem.lower())
+        verts, tris = load_obj(mesh_path)
+        q, indices, quant = gen_quantized_mesh(verts, tris)
+        n = len(q) // 3
+        idx_type = "uint8_t" if n <= 256 else "uint16_t"
+        arrays.append(("int16_t", f"mesh_{stem}_verts", q))
+        arrays.append((idx_type, f"mesh_{stem}_indices", indices))
+        arrays.append(("int32_t", f"mesh_{stem}_quant_q16", quant))
+        packed = len(q) * 2 + len(indices) * (1 if idx_type == "uint8_t" else 2) + 16
+        print(f"mesh_{stem}: {n} vertices, {len(tris)} triangles, {packed} bytes (Vec3 + uint16_t indices: {n * 12 + len(indices) * 2})")
 
     glyph_meta = None
     if args.font_file:
@@ -293,6 +602,9 @@ def main():
     guard = base.name.upper() + "_H"
     h_content = [f"#ifndef {guard}", f"#define {guard}", '#include <stdint.h>', '#ifdef ARDUINO', '#include <avr/pgmspace.h>', '#else', '#ifndef PROGMEM', '#define PROGMEM', '#endif', '#endif\n']
 
+    for name, val in defines:
+        h_content.append(f"#define {name} {val}")
+
     if args.emit_c:
         for ctype, name, vals in arrays:
             h_content.append(f"extern const {ctype} {args.progmem_macro} {name}[{len(vals)}];")
@@ -45,6 +45,9 @@ echo -e "\n${GREEN}2. Running Host-based Floating-point Test (BTM)...${NC}"
 cd tests
 make -f Makefile.host test_fast_float
 ./test_fast_float | tail -n 10
+echo -e "\nSame tests with generated tripartite tables:"
+make -f Makefile.host test_fast_float_mp
+./test_fast_float_mp | tail -n 10
 cd ..
 
 # 3. AVR Emulation Test (Fixed-point)
@@ -68,6 +71,8 @@ make clean
 make
 echo -e "Running host tests:"
 ./test_host
+echo -e "\nRunning host benchmarks:"
+make run_bench
 if command -v simavr &> /dev/null && command -v avr-gcc &> /dev/null; then
     echo -e "\nRunning AVR benchmarks:"
     make run_avr
@@ -1,5 +1,6 @@
 #include <avr/io.h>
 #include <stdio.h>
+#include <math.h>
 #include "../fast_float.h"
 
 static int uart_putchar(char c, FILE *stream) {
@@ -11,6 +12,33 @@ static int uart_putchar(char c, FILE *stream) {
 
 static FILE uartout = FDEV_SETUP_STREAM(uart_putchar, NULL, _FDEV_SETUP_WRITE);
 
+static inline void start_timer(void) {
+    TCNT1 = 0;
+    TCCR1B = (1 << CS10);
+}
+
+static inline uint16_t stop_timer(void) {
+    uint16_t t = TCNT1;
+    TCCR1B = 0;
+    return t;
+}
+
+volatile float g_sink;
+
+// Cycles for one call, and the relative error against avr-libc in parts per million
+#define BENCH1(label, fast_expr, ref_expr)                                          \
+    do {                                                                            \
+        start_timer();                                                              \
+        float r_fast = fast_expr;                                                   \
+        uint16_t c_fast = stop_timer();                                             \
+        start_timer();                                                              \
+        float r_ref = ref_expr;                                                     \
+        uint16_t c_ref = stop_timer();                                              \
+        g_sink = r_fast + r_ref;                                                    \
+        long ppm = (long)(fabs((r_fast - r_ref) / r_ref) * 1e6);                    \
+        printf("%s: %u cycles (avr-libc %u), err %ld ppm\n", label, c_fast, c_ref, ppm); \
+    } while (0)
+
 int main(void) {
     UBRR0H = 0;
     UBRR0L = 103;
@@ -25,6 +53,12 @@ int main(void) {
     float res_mul = fast_mul_f32(a, b);
     float res_div = fast_div_f32(a, b);
 
+    static float buf[32];
+    for (uint8_t i = 0; i < 32; i++) buf[i] = (float)i * 0.25f - 4.0f;
+    fast_scale_f32_array(buf, b, buf, 32);
+    fast_mul_f32_array(buf, buf, buf, 32);
+    fast_div_f32_array(buf, buf, buf, 32);
+
     // Cast to void to suppress unused variable warnings while ensuring the calls are made
     (void)res_mul;
     (void)res_div;
@@ -33,6 +67,62 @@ int main(void) {
     // but we can print their raw bits or just confirm completion.
     printf("Multiplication/Division completed.\n");
 
+    TCCR1A = 0;
+    TCCR1B = 0;
+    volatile float x = 1234.567f;
+    volatile float y = 2.2f;
+    BENCH1("fast_log2_f32", fast_log2_f32(x), log(x) * 1.44269504f);
+    BENCH1("fast_exp2_f32", fast_exp2_f32(y), exp(y * 0.69314718f));
+    BENCH1("fast_sqrt_f32", fast_sqrt_f32(x), sqrt(x));
+    BENCH1("fast_rsqrt_f32", fast_rsqrt_f32(x), 1.0f / sqrt(x));
+    BENCH1("fast_pow_f32", fast_pow_f32(x, y), pow(x, y));
+
+    // 16-tap FIR step: block-exponent dot product versus soft-float multiply-add
+    static float taps[16], hist[16];
+    for (uint8_t i = 0; i < 16; i++) {
+        taps[i] = 0.0625f - (float)i * 0.003f;
+        hist[i] = (float)i * 1.7f - 9.0f;
+    }
+    start_timer();
+    float dot_fast = fast_dot_f32(taps, hist, 16);
+    uint16_t c_dot = stop_timer();
+    start_timer();
+    float dot_ref = 0;
+    for (uint8_t i = 0; i < 16; i++) dot_ref += taps[i] * hist[i];
+    uint16_t c_ref = stop_timer();
+    start_timer();
+    float dot_mix = 0;
+    for (uint8_t i = 0; i < 16; i++) dot_mix += fast_mul_f32(taps[i], hist[i]);
+    uint16_t c_mix = stop_timer();
+    g_sink = dot_fast + dot_ref + dot_mix;
+    printf("fast_dot_f32 x16: %u cycles (float loop %u, fast_mul_f32 + float add %u), err %ld ppm\n",
+           c_dot, c_ref, c_mix, (long)(fabs((dot_fast - dot_ref) / dot_ref) * 1e6));
+    start_timer();
+    fast_axpy_f32(0.5f, taps, hist, 16);
+    printf("fast_axpy_f32 x16: %u cycles\n", stop_timer());
+
+    // Straight on the 16-bit encodings versus widening to float and back
+    volatile uint16_t ha = fast_f32_to_f16(1.5f), hb = fast_f32_to_f16(-0.3f);
+    volatile uint16_t hr;
+    start_timer();
+    hr = fast_mul_f16(ha, hb);
+    uint16_t c_half = stop_timer();
+    start_timer();
+    hr = fast_f32_to_f16(fast_f16_to_f32(ha) * fast_f16_to_f32(hb));
+    uint16_t c_wide = stop_timer();
+    printf("fast_mul_f16: %u cycles (via float %u)\n", c_half, c_wide);
+    start_timer();
+    hr = fast_mul_bf16(fast_f32_to_bf16(1.5f), fast_f32_to_bf16(-0.3f));
+    printf("fast_mul_bf16 with conversions: %u cycles\n", stop_timer());
+    (void)hr;
+
+    static uint16_t hbuf[32];
+    static int32_t qbuf[32];
+    fast_f32_to_f16_array(buf, hbuf, 32);
+    fast_f16_to_q16_array(hbuf, qbuf, 32);
+    fast_q16_to_bf16_array(qbuf, hbuf, 32);
+    fast_bf16_to_f32_array(hbuf, buf, 32);
+
     printf("DONE\n");
     while(1);
     return 0;
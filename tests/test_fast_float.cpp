@@ -2,8 +2,299 @@
 #include <iomanip>
 #include <cmath>
 #include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
 #include "../fast_float.h"
 
+static uint32_t bits(float f) {
+    uint32_t u;
+    memcpy(&u, &f, 4);
+    return u;
+}
+
+template <typename F>
+static double msps(size_t n, int reps, F fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) fn();
+    auto t1 = std::chrono::steady_clock::now();
+    return (double)n * reps / std::chrono::duration<double>(t1 - t0).count() / 1e6;
+}
+
+// Average and maximum relative error of fn against ref over log-uniform inputs in [lo, hi]
+template <typename F, typename R>
+static void report_unary(const char *name, F fn, R ref, double lo, double hi, bool abs_err = false) {
+    const int samples = 100000;
+    double total = 0, worst = 0;
+    for (int i = 0; i < samples; i++) {
+        double t = (double)rand() / RAND_MAX;
+        float x = (float)(lo * std::pow(hi / lo, t));
+        if (lo < 0) x = (float)(lo + (hi - lo) * t);
+        double e = ref(x), a = fn(x);
+        double err = abs_err ? std::abs(a - e) : std::abs(a - e) / std::abs(e);
+        total += err;
+        if (err > worst) worst = err;
+    }
+    std::cout << std::left << std::setw(22) << name << (abs_err ? "avg abs err " : "avg rel err ")
+              << std::setw(12) << total / samples << " max " << worst << std::endl;
+}
+
+static void test_log_domain() {
+    std::cout << "\n--- Log-domain functions (100k samples each) ---" << std::endl;
+    report_unary("fast_log2_f32", fast_log2_f32, [](float x) { return std::log2((double)x); }, 1e-30, 1e30, true);
+    report_unary("fast_exp2_f32", fast_exp2_f32, [](float x) { return std::exp2((double)x); }, -100.0, 100.0);
+    report_unary("fast_sqrt_f32", fast_sqrt_f32, [](float x) { return std::sqrt((double)x); }, 1e-30, 1e30);
+    report_unary("fast_rsqrt_f32", fast_rsqrt_f32, [](float x) { return 1.0 / std::sqrt((double)x); }, 1e-30, 1e30);
+    report_unary("fast_pow_f32(x, 2.2)", [](float x) { return fast_pow_f32(x, 2.2f); },
+                 [](float x) { return std::pow((double)x, 2.2); }, 1e-5, 1e5);
+    report_unary("fast_pow_f32(2.5, y)", [](float y) { return fast_pow_f32(2.5f, y); },
+                 [](float y) { return std::pow(2.5, (double)y); }, -60.0, 60.0);
+
+    int bad = 0;
+    bad += fast_sqrt_f32(0.0f) != 0.0f;
+    bad += !std::isnan(fast_sqrt_f32(-1.0f));
+    bad += !std::isinf(fast_rsqrt_f32(0.0f));
+    bad += !(std::isinf(fast_log2_f32(0.0f)) && fast_log2_f32(0.0f) < 0);
+    bad += fast_exp2_f32(200.0f) != INFINITY;
+    bad += fast_exp2_f32(-200.0f) != 0.0f;
+    bad += fast_pow_f32(3.0f, 0.0f) != 1.0f;
+    bad += fast_pow_f32(0.0f, 2.0f) != 0.0f;
+    bad += std::abs(fast_log2_f32(8.0f) - 3.0f) > 1e-3f;
+    std::cout << (bad ? "FAIL: " : "") << "Special cases wrong: " << bad << std::endl;
+}
+
+static void test_arrays() {
+    std::cout << "\n--- Array kernels ---" << std::endl;
+    const uint16_t n = 4099; // not a multiple of the vector width
+    std::vector<float> a(n), b(n), out(n);
+    for (int i = 0; i < n; i++) {
+        a[i] = ((float)rand() / RAND_MAX - 0.5f) * 2000.0f;
+        b[i] = ((float)rand() / RAND_MAX - 0.5f) * 20.0f;
+    }
+    // Zeros, denormals, huge and tiny values exercise the special cases
+    float special[] = {0.0f, -0.0f, 1e-40f, 3e38f, 1e-38f, -3e38f, 1.0f, 2.0f};
+    for (int i = 0; i < 8; i++) {
+        a[i] = special[i];
+        b[i + 8] = special[i];
+        a[i + 16] = special[i];
+        b[i + 16] = special[7 - i];
+    }
+
+    int bad = 0;
+    // The first array calls race to set up any vector tables: every thread must see them complete
+    std::vector<float> outs[4];
+    std::thread workers[4];
+    for (int t = 0; t < 4; t++) {
+        outs[t].resize(n);
+        workers[t] = std::thread([&, t] { fast_mul_f32_array(a.data(), b.data(), outs[t].data(), n); });
+    }
+    for (int t = 0; t < 4; t++) {
+        workers[t].join();
+        for (int i = 0; i < n; i++) bad += bits(outs[t][i]) != bits(fast_mul_f32(a[i], b[i]));
+    }
+    fast_mul_f32_array(a.data(), b.data(), out.data(), n);
+    for (int i = 0; i < n; i++) bad += bits(out[i]) != bits(fast_mul_f32(a[i], b[i]));
+    fast_div_f32_array(a.data(), b.data(), out.data(), n);
+    for (int i = 0; i < n; i++) bad += bits(out[i]) != bits(fast_div_f32(a[i], b[i]));
+    for (int k = 0; k < 4; k++) {
+        float s = k == 0 ? 0.37f : special[k + 1];
+        fast_scale_f32_array(a.data(), s, out.data(), n);
+        for (int i = 0; i < n; i++) bad += bits(out[i]) != bits(fast_mul_f32(a[i], s));
+    }
+    std::cout << (bad ? "FAIL: " : "") << "Array results differ from scalar in " << bad << " cases" << std::endl;
+
+    const int reps = 2000;
+    double t_scalar = msps(n, reps, [&] {
+        for (int i = 0; i < n; i++) out[i] = fast_mul_f32(a[i], b[i]);
+    });
+    double t_mul = msps(n, reps, [&] { fast_mul_f32_array(a.data(), b.data(), out.data(), n); });
+    double t_scale = msps(n, reps, [&] { fast_scale_f32_array(a.data(), 0.37f, out.data(), n); });
+    double t_div = msps(n, reps, [&] { fast_div_f32_array(a.data(), b.data(), out.data(), n); });
+    std::cout << "fast_mul_f32 loop: " << t_scalar << " M/s, fast_mul_f32_array: " << t_mul
+              << " M/s, fast_scale_f32_array: " << t_scale << " M/s, fast_div_f32_array: " << t_div << " M/s" << std::endl;
+}
+
+static void test_dot() {
+    std::cout << "\n--- Dot product / axpy ---" << std::endl;
+    const uint16_t n = 1000;
+    std::vector<float> a(n), b(n), y(n), y0(n);
+    double worst_dot = 0, worst_loop = 0;
+    for (int t = 0; t < 200; t++) {
+        double ref = 0, mag = 0;
+        float loop = 0;
+        for (int i = 0; i < n; i++) {
+            a[i] = (float)(((double)rand() / RAND_MAX - 0.5) * std::pow(10.0, rand() % 7 - 3));
+            b[i] = (float)(((double)rand() / RAND_MAX - 0.5) * 4.0);
+            ref += (double)a[i] * b[i];
+            mag += std::abs((double)a[i] * b[i]);
+            loop += fast_mul_f32(a[i], b[i]);
+        }
+        // Error relative to sum |a b|, which is what any summation order is accurate to
+        worst_dot = std::max(worst_dot, std::abs(fast_dot_f32(a.data(), b.data(), n) - ref) / mag);
+        worst_loop = std::max(worst_loop, std::abs(loop - ref) / mag);
+    }
+    std::cout << "fast_dot_f32 max err " << worst_dot << " (fast_mul_f32 + float add loop: " << worst_loop << ")" << std::endl;
+
+    double worst_axpy = 0;
+    for (int i = 0; i < n; i++) {
+        y0[i] = y[i] = (float)(((double)rand() / RAND_MAX - 0.5) * 100.0);
+        a[i] = (float)(((double)rand() / RAND_MAX - 0.5) * 100.0);
+    }
+    fast_axpy_f32(-0.37f, a.data(), y.data(), n);
+    for (int i = 0; i < n; i++) {
+        double ref = -0.37 * a[i] + y0[i];
+        worst_axpy = std::max(worst_axpy, std::abs(y[i] - ref) / (std::abs(0.37 * a[i]) + std::abs(y0[i])));
+    }
+    std::cout << "fast_axpy_f32 max err " << worst_axpy << std::endl;
+
+    int bad = worst_dot > 2e-4 || worst_axpy > 2e-4;
+    float one[2] = {1.0f, -1.0f}, big[2] = {3e38f, 3e38f}, zero[2] = {0.0f, 0.0f};
+    bad += fast_dot_f32(one, one, 0) != 0.0f;
+    bad += fast_dot_f32(one, zero, 2) != 0.0f;
+    bad += std::abs(fast_dot_f32(one, one, 2) - 2.0f) > 1e-3f;
+    bad += fast_dot_f32(big, one, 2) != 0.0f;          // cancels exactly
+    bad += !std::isinf(fast_dot_f32(big, big, 2));     // overflows only when packed
+    float tiny[2] = {1e-30f, 1e-30f}, huge[2] = {1e30f, 1e30f};
+    bad += std::abs(fast_dot_f32(tiny, huge, 2) - 2.0f) > 1e-3f; // products are fine even if factors are extreme
+    std::cout << (bad ? "FAIL: " : "") << "Dot/axpy checks failed: " << bad << std::endl;
+}
+
+#ifdef BTM64_BITS
+static void test_f64() {
+    std::cout << "\n--- Double precision (" << BTM64_BITS << "-bit tables) ---" << std::endl;
+    const uint32_t n = 1 << 16;
+    std::vector<double> a(n), b(n), out(n), ref(n);
+    for (uint32_t i = 0; i < n; i++) {
+        a[i] = std::pow(2.0, ((double)rand() / RAND_MAX - 0.5) * 400.0) * (rand() & 1 ? 1 : -1);
+        b[i] = std::pow(2.0, ((double)rand() / RAND_MAX - 0.5) * 400.0);
+    }
+    double total[2] = {0, 0}, worst[2] = {0, 0};
+    int bad = 0;
+    fast_mul_f64_array(a.data(), b.data(), out.data(), n);
+    for (uint32_t i = 0; i < n; i++) {
+        double e = std::abs(out[i] - a[i] * b[i]) / std::abs(a[i] * b[i]);
+        total[0] += e;
+        worst[0] = std::max(worst[0], e);
+        bad += out[i] != fast_mul_f64(a[i], b[i]);
+    }
+    fast_div_f64_array(a.data(), b.data(), out.data(), n);
+    for (uint32_t i = 0; i < n; i++) {
+        double e = std::abs(out[i] - a[i] / b[i]) / std::abs(a[i] / b[i]);
+        total[1] += e;
+        worst[1] = std::max(worst[1], e);
+        bad += out[i] != fast_div_f64(a[i], b[i]);
+    }
+    std::cout << "fast_mul_f64 avg rel err " << total[0] / n << " max " << worst[0] << std::endl;
+    std::cout << "fast_div_f64 avg rel err " << total[1] / n << " max " << worst[1] << std::endl;
+    bad += worst[0] > 1e-5 || worst[1] > 1e-5;
+    bad += fast_mul_f64(0.0, 3.0) != 0.0 || !std::isinf(fast_div_f64(1.0, 0.0));
+    bad += !std::isinf(fast_mul_f64(1e300, 1e300)) || fast_mul_f64(1e-300, 1e-300) != 0.0;
+    std::cout << (bad ? "FAIL: " : "") << "Double checks failed: " << bad << std::endl;
+
+    // Throughput against the native multiply / divide (which the compiler vectorizes)
+    const int reps = 200;
+    double t_mul = msps(n, reps, [&] { fast_mul_f64_array(a.data(), b.data(), out.data(), n); });
+    double t_div = msps(n, reps, [&] { fast_div_f64_array(a.data(), b.data(), out.data(), n); });
+    double t_nmul = msps(n, reps, [&] {
+        for (uint32_t i = 0; i < n; i++) ref[i] = a[i] * b[i];
+    });
+    double t_ndiv = msps(n, reps, [&] {
+        for (uint32_t i = 0; i < n; i++) ref[i] = a[i] / b[i];
+    });
+    std::cout << "fast_mul_f64_array: " << t_mul << " M/s (native " << t_nmul << " M/s), fast_div_f64_array: " << t_div
+              << " M/s (native " << t_ndiv << " M/s)" << std::endl;
+}
+#endif
+
+// Distance in encodings between two finite halves of the same sign
+static int half_ulps(uint16_t a, uint16_t b) {
+    return a > b ? a - b : b - a;
+}
+
+static void test_half() {
+    std::cout << "\n--- fp16 / bfloat16 ---" << std::endl;
+    int bad = 0;
+    // Every non-NaN encoding survives the round trip through float
+    for (uint32_t h = 0; h < 65536; h++) {
+        if ((h & 0x7C00) == 0x7C00 && (h & 0x3FF)) continue;
+        bad += fast_f32_to_f16(fast_f16_to_f32((uint16_t)h)) != h;
+        if ((h & 0x7F80) == 0x7F80 && (h & 0x7F)) continue;
+        bad += fast_f32_to_bf16(fast_bf16_to_f32((uint16_t)h)) != h;
+    }
+    // Narrowing rounds to nearest: the result is no farther from x than its neighbours
+    for (int i = 0; i < 100000; i++) {
+        float x = (float)(std::pow(2.0, ((double)rand() / RAND_MAX - 0.5) * 60.0) * (rand() & 1 ? 1 : -1));
+        uint16_t h = fast_f32_to_f16(x), g = fast_f32_to_bf16(x);
+        double eh = std::abs(fast_f16_to_f32(h) - (double)x), eg = std::abs(fast_bf16_to_f32(g) - (double)x);
+        if (std::abs(x) < 65504.0f) {
+            bad += eh > std::abs(fast_f16_to_f32(h + 1) - (double)x) || (h & 0x7FFF && eh > std::abs(fast_f16_to_f32(h - 1) - (double)x));
+        }
+        bad += eg > std::abs(fast_bf16_to_f32(g + 1) - (double)x) || (g & 0x7FFF && eg > std::abs(fast_bf16_to_f32(g - 1) - (double)x));
+    }
+    bad += fast_f32_to_f16(1e6f) != 0x7C00 || fast_f32_to_f16(-1e-9f) != 0x8000 || fast_f32_to_f16(5.9604645e-8f) != 0x0001;
+    bad += fast_f32_to_bf16(3.4e38f) != 0x7F80 || fast_f32_to_bf16(1.0f) != 0x3F80;
+
+    // Q16.16 in both directions
+    const uint16_t n = 1000;
+    std::vector<int32_t> q(n), q2(n);
+    std::vector<uint16_t> h(n), g(n);
+    for (int i = 0; i < n; i++) q[i] = (int32_t)((uint32_t)rand() * 2654435761u) >> (rand() % 16);
+    q[0] = 0x7FFFFFFF;
+    q[1] = 1;
+    fast_q16_to_f16_array(q.data(), h.data(), n);
+    fast_q16_to_bf16_array(q.data(), g.data(), n);
+    for (int i = 0; i < n; i++) {
+        double x = q[i] / 65536.0;
+        bad += std::abs(fast_f16_to_f32(h[i]) - x) > std::abs(x) * (1.0 / 2048) + 1e-7 * (std::abs(x) < 6.1e-5);
+        bad += std::abs(fast_bf16_to_f32(g[i]) - x) > std::abs(x) * (1.0 / 256);
+    }
+    fast_f16_to_q16_array(h.data(), q2.data(), n);
+    bad += q2[0] != 0x7FFFFFFF; // 32768 rounds to 32768.0 in fp16, which saturates
+    fast_bf16_to_q16_array(g.data(), q2.data(), n);
+    for (int i = 2; i < n; i++) bad += q2[i] != (int32_t)(fast_bf16_to_f32(g[i]) * 65536.0);
+    std::cout << (bad ? "FAIL: " : "") << "Conversion errors: " << bad << std::endl;
+
+    // Multiply and divide against the correctly rounded result, which float gives exactly here
+    const int samples = 100000;
+    int worst[4] = {0, 0, 0, 0}, exact[4] = {0, 0, 0, 0};
+    for (int i = 0; i < samples; i++) {
+        float a = (float)(std::pow(2.0, ((double)rand() / RAND_MAX - 0.5) * 20.0) * (rand() & 1 ? 1 : -1));
+        float b = (float)(std::pow(2.0, ((double)rand() / RAND_MAX - 0.5) * 20.0));
+        uint16_t ha = fast_f32_to_f16(a), hb = fast_f32_to_f16(b), ga = fast_f32_to_bf16(a), gb = fast_f32_to_bf16(b);
+        float fa = fast_f16_to_f32(ha), fb = fast_f16_to_f32(hb), za = fast_bf16_to_f32(ga), zb = fast_bf16_to_f32(gb);
+        int d[4] = {half_ulps(fast_mul_f16(ha, hb), fast_f32_to_f16(fa * fb)),
+                    half_ulps(fast_div_f16(ha, hb), fast_f32_to_f16(fa / fb)),
+                    half_ulps(fast_mul_bf16(ga, gb), fast_f32_to_bf16(za * zb)),
+                    half_ulps(fast_div_bf16(ga, gb), fast_f32_to_bf16(za / zb))};
+        for (int k = 0; k < 4; k++) {
+            if (d[k] > worst[k]) worst[k] = d[k];
+            exact[k] += d[k] == 0;
+        }
+    }
+    const char *names[4] = {"fast_mul_f16", "fast_div_f16", "fast_mul_bf16", "fast_div_bf16"};
+    for (int k = 0; k < 4; k++) {
+        std::cout << (worst[k] > 1 ? "FAIL: " : "") << std::left << std::setw(14) << names[k] << " correctly rounded "
+                  << 100.0 * exact[k] / samples << "%, max " << worst[k] << " ulp" << std::endl;
+    }
+    int special = 0;
+    special += fast_mul_f16(0x3C00, 0x0000) != 0;      // 1 * 0
+    special += fast_div_f16(0x3C00, 0x0000) != 0x7C00; // 1 / 0
+    special += fast_mul_f16(0x7BFF, 0x4000) != 0x7C00; // 65504 * 2
+    special += fast_mul_bf16(0xBF80, 0x4000) != 0xC000; // -1 * 2
+    // fp16 overflows at 65504, so infinities come up often
+    special += fast_div_f16(0x3C00, 0x7C00) != 0;                 // 1 / inf
+    special += fast_div_f16(0xFC00, 0x4000) != 0xFC00;            // -inf / 2
+    special += fast_mul_f16(0x7C00, 0xC000) != 0xFC00;            // inf * -2
+    special += (fast_mul_f16(0x7C00, 0x0000) & 0x7FFF) <= 0x7C00; // inf * 0 is NaN
+    special += (fast_div_f16(0x7C00, 0xFC00) & 0x7FFF) <= 0x7C00; // inf / -inf is NaN
+    special += fast_mul_f16(0x7D00, 0x4000) != 0x7F00;            // signalling NaN * 2 comes back quiet
+    special += (fast_div_f16(0x4000, 0x7E00) & 0x7FFF) <= 0x7C00; // 2 / NaN
+    special += fast_div_bf16(0x3F80, 0xFF80) != 0x8000;           // 1 / -inf
+    special += (fast_mul_bf16(0x7FC0, 0x4000) & 0x7FFF) <= 0x7F80; // NaN * 2
+    std::cout << (special ? "FAIL: " : "") << "Special cases wrong: " << special << std::endl;
+}
+
 int main() {
     std::cout << "Testing fast_float multiplication and division (BTM)..." << std::endl;
 
@@ -53,5 +344,13 @@ int main() {
     std::cout << "Average relative error (MUL): " << (total_err_mul / samples) * 100.0 << "%" << std::endl;
     std::cout << "Average relative error (DIV): " << (total_err_div / samples) * 100.0 << "%" << std::endl;
 
+    test_log_domain();
+    test_arrays();
+    test_dot();
+    test_half();
+#ifdef BTM64_BITS
+    test_f64();
+#endif
+
     return 0;
 }